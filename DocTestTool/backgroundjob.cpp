@@ -0,0 +1,72 @@
+#include "backgroundjob.h"
+
+namespace
+{
+    const double kMegabyte = 1024.0 * 1024.0;
+}
+
+//=============================================================================
+// class BackgroundJob
+//=============================================================================
+BackgroundJob::BackgroundJob()
+    : finished_(false)
+    , cancelled_(false)
+{
+}
+
+BackgroundJob::~BackgroundJob()
+{
+    wait();
+}
+
+void BackgroundJob::wait()
+{
+    if (thread_.joinable())
+    {
+        thread_.join();
+    }
+}
+
+void BackgroundJob::start()
+{
+    timer_.start();
+    thread_ = std::thread([this]()
+    {
+        run();
+        finished_ = true;
+    });
+}
+
+double BackgroundJob::megabytesPerSecond() const
+{
+    const qint64 ms = timer_.isValid() ? timer_.elapsed() : 0;
+    return ms > 0 ? bytesDone() / kMegabyte * 1000.0 / ms : 0.0;
+}
+
+qint64 BackgroundJob::secondsLeft() const
+{
+    const qint64 total = bytesTotal();
+    const qint64 done = bytesDone();
+    const qint64 ms = timer_.isValid() ? timer_.elapsed() : 0;
+    if (total <= 0 || done <= 0 || ms <= 0)
+    {
+        return -1;
+    }
+    return qMax<qint64>(0, (total - done) * ms / done / 1000);
+}
+
+QString BackgroundJob::progressMessage() const
+{
+    QString message = title().append(": ").append(QString::number(filesDone()));
+    if (filesTotal() > 0)
+    {
+        message.append("/").append(QString::number(filesTotal()));
+    }
+    message.append(QString(" files, %1 MB/s").arg(megabytesPerSecond(), 0, 'f', 1));
+    const qint64 left = secondsLeft();
+    if (left >= 0)
+    {
+        message.append(QString(", %1:%2 left").arg(left / 60).arg(left % 60, 2, 10, QChar('0')));
+    }
+    return message;
+}
@@ -0,0 +1,72 @@
+#ifndef BACKGROUND_JOB_H
+#define BACKGROUND_JOB_H
+
+#include <QStringList>
+#include <QElapsedTimer>
+
+#include <atomic>
+#include <thread>
+
+struct SaveData;
+
+// Work that runs on its own thread while the GUI stays responsive. The main window
+// polls progress and calls finish() on the GUI thread once the worker is done.
+class BackgroundJob
+{
+public:
+    enum class Type
+    {
+        Upload = 0,
+        Export,
+        Mirror,
+    };
+private:
+    std::thread thread_;
+    std::atomic<bool> finished_;
+protected:
+    std::atomic<bool> cancelled_;
+    QElapsedTimer timer_;
+    QStringList failures_; // written by the worker, read once it's finished
+protected:
+    // executed on the worker thread
+    virtual void run() = 0;
+public:
+    //
+    BackgroundJob();
+    // waits for the worker
+    virtual ~BackgroundJob();
+    //
+    virtual Type type() const = 0;
+    // short name for messages
+    virtual QString title() const = 0;
+    //
+    void start();
+    // blocks until the worker returns, the owner must call it before deleting a job
+    void wait();
+    //
+    void cancel() { cancelled_ = true; }
+    //
+    bool isCancelled() const { return cancelled_; }
+    //
+    bool isFinished() const { return finished_; }
+    // progress counters, totals are 0 when they are not known
+    virtual qint64 filesDone() const = 0;
+    //
+    virtual qint64 filesTotal() const = 0;
+    //
+    virtual qint64 bytesDone() const = 0;
+    //
+    virtual qint64 bytesTotal() const = 0;
+    //
+    double megabytesPerSecond() const;
+    // -1 if it can't be estimated
+    qint64 secondsLeft() const;
+    //
+    QString progressMessage() const;
+    // valid once the job is finished
+    const QStringList & failures() const { return failures_; }
+    // executed on the GUI thread after the worker is done, returns summary for the user
+    virtual QString finish(SaveData * save) = 0;
+};
+
+#endif // BACKGROUND_JOB_H
@@ -0,0 +1,104 @@
+#include "compressionpolicy.h"
+
+#include <QFileInfo>
+
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    // deflate gains around 1% above this, less than it costs to run
+    const double kStoreEntropy = 7.5;
+    // too little data to judge, deflate is cheap anyway
+    const qint64 kMinSample = 512;
+
+    struct Signature
+    {
+        const char * bytes;
+        size_t size;
+    };
+
+    const Signature kCompressedSignatures[] =
+    {
+        { "\xFF\xD8\xFF", 3 }, // jpeg
+        { "\x89PNG\r\n\x1A\n", 8 }, // png
+        { "GIF8", 4 }, // gif
+        { "PK\x03\x04", 4 }, // zip, docx, xlsx
+        { "\x1F\x8B", 2 }, // gzip
+        { "7z\xBC\xAF\x27\x1C", 6 }, // 7z
+        { "Rar!", 4 }, // rar
+        { "\x28\xB5\x2F\xFD", 4 }, // zstd
+    };
+}
+
+//=============================================================================
+// class CompressionPolicy
+//=============================================================================
+CompressionPolicy::CompressionPolicy()
+    : storeEntropy_(kStoreEntropy)
+{
+}
+
+void CompressionPolicy::setOverride(const QString & extension, Method method)
+{
+    overrides_[extension.toLower()] = method;
+}
+
+bool CompressionPolicy::hasOverride(const QString & fileName) const
+{
+    return overrides_.contains(QFileInfo(fileName).suffix().toLower());
+}
+
+CompressionPolicy::Method CompressionPolicy::methodFor(const QString & fileName, const char * sample, qint64 size) const
+{
+    auto it = overrides_.constFind(QFileInfo(fileName).suffix().toLower());
+    if (it != overrides_.constEnd())
+    {
+        return static_cast<Method>(it.value());
+    }
+    if (size < kMinSample)
+    {
+        return Deflate;
+    }
+    if (isCompressedFormat(sample, size))
+    {
+        return Store;
+    }
+    return entropy(sample, size) >= storeEntropy_ ? Store : Deflate;
+}
+
+bool CompressionPolicy::isCompressedFormat(const char * sample, qint64 size)
+{
+    for (const Signature & signature : kCompressedSignatures)
+    {
+        if (size >= static_cast<qint64>(signature.size) && memcmp(sample, signature.bytes, signature.size) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+double CompressionPolicy::entropy(const char * data, qint64 size)
+{
+    if (size <= 0)
+    {
+        return 0.0;
+    }
+    qint64 counts[256] = {};
+    const unsigned char * bytes = reinterpret_cast<const unsigned char *>(data);
+    for (qint64 i = 0; i < size; ++i)
+    {
+        ++counts[bytes[i]];
+    }
+    double bits = 0.0;
+    for (qint64 count : counts)
+    {
+        if (count > 0)
+        {
+            const double p = static_cast<double>(count) / size;
+            bits -= p * std::log2(p);
+        }
+    }
+    return bits;
+}
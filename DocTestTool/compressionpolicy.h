@@ -0,0 +1,42 @@
+#ifndef COMPRESSION_POLICY_H
+#define COMPRESSION_POLICY_H
+
+#include <QString>
+#include <QMap>
+
+// Decides per document whether deflate is worth it. JPEG, PNG, zip and most TIFF/PDF
+// bodies are already compressed, deflating them again costs CPU and saves about nothing,
+// so such documents are stored as they are.
+class CompressionPolicy
+{
+public:
+    enum Method
+    {
+        Store = 0, // zip method 0
+        Deflate = 8, // Z_DEFLATED
+    };
+    // bytes from the start of the document that are looked at
+    static const int kSampleSize = 64 * 1024;
+private:
+    QMap<QString, int> overrides_; // lower case extension -> method, skips sampling
+    double storeEntropy_; // bits per byte from which a sample counts as incompressible
+public:
+    //
+    CompressionPolicy();
+    //
+    void setOverride(const QString & extension, Method method);
+    //
+    const QMap<QString, int> & overrides() const { return overrides_; }
+    //
+    void clearOverrides() { overrides_.clear(); }
+    // true when the extension decides the method without sampling
+    bool hasOverride(const QString & fileName) const;
+    // method for the document, sample is its first bytes, up to kSampleSize of them
+    Method methodFor(const QString & fileName, const char * sample, qint64 size) const;
+    // signatures of formats that are compressed as a whole
+    static bool isCompressedFormat(const char * sample, qint64 size);
+    // Shannon entropy of the bytes, 8 bits per byte for random data
+    static double entropy(const char * data, qint64 size);
+};
+
+#endif // COMPRESSION_POLICY_H
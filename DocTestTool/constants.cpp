@@ -2,15 +2,35 @@
 
 const QString Constants::kBaseFolder = "base";
 const QString Constants::kDocsFolder = "docs";
+const QString Constants::kIndexFolder = "index";
 const QString Constants::kDefaultTagsFile = "config.json";
 const QString Constants::kInfoDocFile = "info.json";
+const QString Constants::kTagsManifest = "tags.json";
 const QString Constants::kComment = "comment";
 const QString Constants::kFilename = "filename";
 const QString Constants::kTags = "tags";
 const QString Constants::kTemplates = "templates";
-const QString Constants::kUploadFilters = "Documents (*.pdf *.tiff);;Images (*.jpg *.jpeg *.png);;Data Only (*.txt *json *html);;XML (*.xml);;All files (*.*)";
+const QString Constants::kUploadFilters = "Documents (*.pdf *.tiff);;Images (*.jpg *.jpeg *.png);;Data Only (*.txt *.json *.html);;XML (*.xml);;All files (*.*)";
+const QString Constants::kArchiveFilters = "Zip (*.zip)";
 const QString Constants::kDelimiter = ", ";
 const QString Constants::kTagsCombo = "Tags";
 const QString Constants::kTemplatesCombo = "Templates";
 const QString Constants::kCommentsCombo = "Comments";
-const QString Constants::kName = "Name";
\ No newline at end of file
+const QString Constants::kName = "Name";
+const QString Constants::kContentCombo = "Content";
+const QString Constants::kRules = "rules";
+const QString Constants::kMatch = "match";
+const QString Constants::kScope = "scope";
+const QString Constants::kTemplate = "template";
+const QString Constants::kScopePath = "path";
+const QString Constants::kScopeContent = "content";
+const QString Constants::kScopeAny = "any";
+const QString Constants::kTextExtensions = "txt json html htm xml";
+const QString Constants::kCompression = "compression";
+const QString Constants::kStore = "store";
+const QString Constants::kDeflate = "deflate";
+const QString Constants::kDeflateCacheFile = ".deflate-cache";
+const QString Constants::kDeflateCacheManifest = ".deflate-cache-manifest";
+const QString Constants::kDeflateCacheBudget = "deflateCacheMB";
+const QString Constants::kTagMirror = "tagMirror";
+const QString Constants::kMirrorFolder = "by-tag";
\ No newline at end of file
@@ -7,18 +7,38 @@ struct Constants
 {
     static const QString kBaseFolder;
     static const QString kDocsFolder;
+    static const QString kIndexFolder;
     static const QString kDefaultTagsFile;
     static const QString kInfoDocFile;
+    static const QString kTagsManifest;
     static const QString kComment;
     static const QString kFilename;
     static const QString kTags;
     static const QString kTemplates;
     static const QString kUploadFilters;
+    static const QString kArchiveFilters;
     static const QString kDelimiter;
     static const QString kTagsCombo;
     static const QString kTemplatesCombo;
     static const QString kCommentsCombo;
     static const QString kName;
+    static const QString kContentCombo;
+    static const QString kRules;
+    static const QString kMatch;
+    static const QString kScope;
+    static const QString kTemplate;
+    static const QString kScopePath;
+    static const QString kScopeContent;
+    static const QString kScopeAny;
+    static const QString kTextExtensions;
+    static const QString kCompression;
+    static const QString kStore;
+    static const QString kDeflate;
+    static const QString kDeflateCacheFile;
+    static const QString kDeflateCacheManifest;
+    static const QString kDeflateCacheBudget;
+    static const QString kTagMirror;
+    static const QString kMirrorFolder;
 };
 
 #endif // DOC_CONSTANTS_H
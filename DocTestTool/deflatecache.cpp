@@ -0,0 +1,290 @@
+#include "deflatecache.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+
+#include <QTextStream>
+
+#include <algorithm>
+#include <vector>
+
+#include "constants.h"
+
+namespace
+{
+    const quint32 kMagic = 0x43445444; // "DTDC"
+    const quint32 kVersion = 1;
+    const int kMd5Size = 32; // hex digits
+    // magic, version, md5, size, crc, compressed size
+    const qint64 kHeaderSize = 4 + 4 + kMd5Size + 8 + 4 + 8;
+    // manifest lines allowed per known sidecar before the manifest is rewritten
+    const int kManifestSlack = 2;
+
+    void writeHeader(QIODevice & device, const QString & md5, qint64 size, quint32 crc, qint64 compressedSize)
+    {
+        QDataStream stream(&device);
+        stream.setByteOrder(QDataStream::LittleEndian);
+        stream << kMagic << kVersion;
+        stream.writeRawData(md5.toLatin1().leftJustified(kMd5Size, ' ', true).constData(), kMd5Size);
+        stream << size << crc << compressedSize;
+    }
+}
+
+//=============================================================================
+// class DeflateCache
+//=============================================================================
+DeflateCache::DeflateCache(const QString & docsFolder, qint64 budget)
+    : docsFolder_(docsFolder)
+    , budget_(budget)
+    , used_(-1)
+    , pending_(0)
+    , manifestLines_(0)
+{
+}
+
+QString DeflateCache::sidecarPath(const QString & md5) const
+{
+    return QDir(docsFolder_).absoluteFilePath(md5 + "/" + Constants::kDeflateCacheFile);
+}
+
+QString DeflateCache::manifestPath() const
+{
+    return QDir(docsFolder_).absoluteFilePath(Constants::kDeflateCacheManifest);
+}
+
+bool DeflateCache::lookup(const QString & md5, qint64 size, Record & record)
+{
+    if (!isEnabled() || md5.isEmpty())
+    {
+        return false;
+    }
+    QFile file(sidecarPath(md5));
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+    QDataStream stream(&file);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    quint32 magic = 0;
+    quint32 version = 0;
+    QByteArray hash(kMd5Size, Qt::Uninitialized);
+    stream >> magic >> version;
+    stream.readRawData(hash.data(), kMd5Size);
+    stream >> record.size >> record.crc >> record.compressedSize;
+    const bool valid = stream.status() == QDataStream::Ok
+        && magic == kMagic
+        && version == kVersion
+        && hash.trimmed() == md5.toLatin1()
+        && record.size == size
+        && record.compressedSize == file.size() - kHeaderSize;
+    const qint64 fileSize = file.size();
+    file.close();
+    load();
+    if (!valid)
+    {
+        // written for other content or by another version
+        remove(md5);
+        return false;
+    }
+    if (!sidecars_.contains(md5))
+    {
+        // missed by the manifest, the process that wrote it may have been killed
+        const qint64 modified = QFileInfo(file).lastModified().toMSecsSinceEpoch();
+        sidecars_.insert(md5, { fileSize, modified });
+        used_ += fileSize;
+        appendManifest(md5, fileSize, modified);
+    }
+    found_.insert(md5);
+    record.path = file.fileName();
+    record.dataOffset = kHeaderSize;
+    return true;
+}
+
+void DeflateCache::load()
+{
+    if (used_ >= 0)
+    {
+        return;
+    }
+    used_ = 0;
+    QFile manifest(manifestPath());
+    if (manifest.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        // replayed in order, a later line for the same md5 wins
+        QTextStream stream(&manifest);
+        while (!stream.atEnd())
+        {
+            const QStringList fields = stream.readLine().split(' ');
+            ++manifestLines_;
+            if (fields.size() != 3)
+            {
+                continue;
+            }
+            const qint64 size = fields[1].toLongLong();
+            if (size < 0)
+            {
+                sidecars_.remove(fields[0]);
+            }
+            else
+            {
+                sidecars_.insert(fields[0], { size, fields[2].toLongLong() });
+            }
+        }
+        manifest.close();
+        if (manifestLines_ > kManifestSlack * sidecars_.size() + 64)
+        {
+            writeManifest();
+        }
+    }
+    else
+    {
+        // first run with the manifest, the sidecars are where their documents are
+        QDirIterator it(docsFolder_, QStringList() << Constants::kDeflateCacheFile, QDir::Files | QDir::Hidden, QDirIterator::Subdirectories);
+        while (it.hasNext())
+        {
+            it.next();
+            const QFileInfo info = it.fileInfo();
+            sidecars_.insert(info.dir().dirName(), { info.size(), info.lastModified().toMSecsSinceEpoch() });
+        }
+        writeManifest();
+    }
+    for (const Sidecar & sidecar : sidecars_)
+    {
+        used_ += sidecar.size;
+    }
+}
+
+void DeflateCache::writeManifest()
+{
+    QSaveFile file(manifestPath());
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+    {
+        return;
+    }
+    QTextStream stream(&file);
+    for (auto it = sidecars_.constBegin(); it != sidecars_.constEnd(); ++it)
+    {
+        stream << it.key() << ' ' << it.value().size << ' ' << it.value().modified << '\n';
+    }
+    stream.flush();
+    if (file.commit())
+    {
+        manifestLines_ = sidecars_.size();
+    }
+}
+
+void DeflateCache::appendManifest(const QString & md5, qint64 size, qint64 modified)
+{
+    QFile file(manifestPath());
+    if (!file.open(QIODevice::Append | QIODevice::Text))
+    {
+        return;
+    }
+    QTextStream(&file) << md5 << ' ' << size << ' ' << modified << '\n';
+    ++manifestLines_;
+}
+
+void DeflateCache::remove(const QString & md5)
+{
+    const QString path = sidecarPath(md5);
+    if (!QFile::remove(path) && QFile::exists(path))
+    {
+        return;
+    }
+    // a sidecar deleted with its document is gone as well
+    const auto it = sidecars_.find(md5);
+    if (it != sidecars_.end())
+    {
+        used_ -= it.value().size;
+        sidecars_.erase(it);
+        appendManifest(md5, -1, 0);
+    }
+}
+
+bool DeflateCache::reserve(qint64 bytes)
+{
+    if (bytes > budget_)
+    {
+        return false;
+    }
+    load();
+    if (used_ + pending_ + bytes > budget_)
+    {
+        std::vector<std::pair<qint64, QString>> oldest;
+        for (auto it = sidecars_.constBegin(); it != sidecars_.constEnd(); ++it)
+        {
+            // still to be copied into the archive
+            if (found_.contains(it.key()))
+            {
+                continue;
+            }
+            oldest.emplace_back(it.value().modified, it.key());
+        }
+        std::sort(oldest.begin(), oldest.end());
+        for (size_t i = 0; i < oldest.size() && used_ + pending_ + bytes > budget_; ++i)
+        {
+            remove(oldest[i].second);
+        }
+    }
+    if (used_ + pending_ + bytes > budget_)
+    {
+        return false;
+    }
+    pending_ += bytes;
+    return true;
+}
+
+std::unique_ptr<QSaveFile> DeflateCache::begin(const QString & md5, qint64 size)
+{
+    // deflate rarely grows a document, its size is a safe estimate of the sidecar
+    if (!isEnabled() || md5.isEmpty() || !reserve(kHeaderSize + size))
+    {
+        return nullptr;
+    }
+    std::unique_ptr<QSaveFile> file(new QSaveFile(sidecarPath(md5)));
+    if (!file->open(QIODevice::WriteOnly))
+    {
+        pending_ -= kHeaderSize + size;
+        return nullptr;
+    }
+    // placeholder, the real header is written on commit
+    writeHeader(*file, md5, 0, 0, 0);
+    return file;
+}
+
+bool DeflateCache::commit(QSaveFile & file, const QString & md5, qint64 size, quint32 crc)
+{
+    pending_ -= kHeaderSize + size;
+    const qint64 compressedSize = file.size() - kHeaderSize;
+    if (!file.seek(0))
+    {
+        file.cancelWriting();
+        return false;
+    }
+    writeHeader(file, md5, size, crc, compressedSize);
+    if (!file.commit())
+    {
+        return false;
+    }
+    const auto it = sidecars_.find(md5);
+    if (it != sidecars_.end())
+    {
+        used_ -= it.value().size;
+    }
+    const Sidecar sidecar = { kHeaderSize + compressedSize, QDateTime::currentMSecsSinceEpoch() };
+    sidecars_.insert(md5, sidecar);
+    used_ += sidecar.size;
+    appendManifest(md5, sidecar.size, sidecar.modified);
+    return true;
+}
+
+void DeflateCache::cancel(QSaveFile & file, qint64 size)
+{
+    file.cancelWriting();
+    pending_ -= kHeaderSize + size;
+}
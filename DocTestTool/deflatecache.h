@@ -0,0 +1,71 @@
+#ifndef DEFLATE_CACHE_H
+#define DEFLATE_CACHE_H
+
+#include <QString>
+#include <QHash>
+#include <QSet>
+
+#include <memory>
+
+class QSaveFile;
+
+// Keeps the deflate stream of exported documents next to them in their md5 folders,
+// so the next export of the same document is a plain copy into the archive.
+// A sidecar is a fixed header (md5, size, crc) followed by the raw deflate stream.
+// A manifest in the docs folder lists the sidecars with their sizes, so the budget
+// is checked without walking the docs tree.
+class DeflateCache
+{
+public:
+    struct Record
+    {
+        QString path; // sidecar file
+        qint64 size = 0; // uncompressed
+        quint32 crc = 0;
+        qint64 dataOffset = 0; // where the deflate stream starts
+        qint64 compressedSize = 0;
+    };
+private:
+    struct Sidecar
+    {
+        qint64 size;
+        qint64 modified; // msecs since epoch, oldest sidecars are dropped first
+    };
+    QString docsFolder_;
+    qint64 budget_; // bytes all sidecars may take together
+    qint64 used_; // -1 until the manifest is loaded
+    qint64 pending_; // bytes reserved by sidecars still being written
+    QHash<QString, Sidecar> sidecars_; // known sidecars by md5
+    QSet<QString> found_; // sidecars looked up for this export, they aren't dropped
+    int manifestLines_; // lines in the manifest, it's rewritten once mostly stale
+private:
+    //
+    QString sidecarPath(const QString & md5) const;
+    //
+    QString manifestPath() const;
+    // read the manifest, or walk the docs tree once when there's none
+    void load();
+    // replace the manifest with the known sidecars
+    void writeManifest();
+    // add a line to the manifest, a negative size records a removal
+    void appendManifest(const QString & md5, qint64 size, qint64 modified);
+    //
+    void remove(const QString & md5);
+    // drop old sidecars until bytes fit into the budget next to the ones being written
+    bool reserve(qint64 bytes);
+public:
+    //
+    DeflateCache(const QString & docsFolder, qint64 budget);
+    //
+    bool isEnabled() const { return budget_ > 0; }
+    // find a sidecar that matches the content hash and size, a stale one is removed
+    bool lookup(const QString & md5, qint64 size, Record & record);
+    // start a sidecar for a document of the given size, null when it doesn't fit the budget
+    std::unique_ptr<QSaveFile> begin(const QString & md5, qint64 size);
+    // write the header and put the sidecar in place
+    bool commit(QSaveFile & file, const QString & md5, qint64 size, quint32 crc);
+    // drop a sidecar that was begun for a document of the given size
+    void cancel(QSaveFile & file, qint64 size);
+};
+
+#endif // DEFLATE_CACHE_H
@@ -0,0 +1,554 @@
+#include "docexporter.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QThread>
+
+#include "quazipfile.h"
+
+#include <zlib.h>
+
+#include "docinfo.h"
+#include "savedata.h"
+
+namespace
+{
+    // pieces of a document are deflated independently, so large documents use all workers too
+    const qint64 kChunkSize = 1024 * 1024;
+    // chunks per worker that may wait in memory for the writer
+    const size_t kChunksPerWorker = 4;
+    // sidecars are copied into the archive in blocks of this size
+    const qint64 kCopyBlockSize = 1024 * 1024;
+    // leaves room for deflate overhead on incompressible data below the 4 GB zip limit
+    const qint64 kZip64Threshold = 0xF0000000LL;
+    const double kMegabyte = 1024.0 * 1024.0;
+}
+
+//=============================================================================
+// class DocExporter
+//=============================================================================
+DocExporter::Entry::Entry(const QString & path, const QString & zipPath)
+    : filePath(path)
+    , zipInfo(zipPath, path)
+    , size(0)
+    , crc(crc32(0L, Z_NULL, 0))
+    , method(CompressionPolicy::Deflate)
+    , failed(false)
+    , cached(false)
+{
+}
+
+DocExporter::Entry::~Entry()
+{
+}
+
+DocExporter::DocExporter(SaveData * save, const QString & zipPath, bool singleFolder)
+    : zip_(zipPath)
+    , delimiter_(singleFolder ? "-" : "/")
+    , policy_(save->compression)
+    , cache_(save->getDocsFilePath(), qint64(save->deflateCacheMegabytes) * 1024 * 1024)
+    , cancelled_(nullptr)
+    , entryIndex_(0)
+    , filesCount_(0)
+    , bytesCount_(0)
+    , storedCount_(0)
+    , cachedCount_(0)
+    , skippedCount_(0)
+    , broken_(false)
+    , unclaimed_(0)
+    , window_(0)
+    , stopping_(false)
+{
+}
+
+DocExporter::DocExporter(SaveData * save, QIODevice * device, bool singleFolder)
+    : zip_(device)
+    , delimiter_(singleFolder ? "-" : "/")
+    , policy_(save->compression)
+    , cache_(save->getDocsFilePath(), qint64(save->deflateCacheMegabytes) * 1024 * 1024)
+    , cancelled_(nullptr)
+    , entryIndex_(0)
+    , filesCount_(0)
+    , bytesCount_(0)
+    , storedCount_(0)
+    , cachedCount_(0)
+    , skippedCount_(0)
+    , broken_(false)
+    , unclaimed_(0)
+    , window_(0)
+    , stopping_(false)
+{
+    // the caller closes the device, stdout must stay usable
+    zip_.setAutoClose(false);
+}
+
+DocExporter::~DocExporter()
+{
+    stopWorkers();
+}
+
+void DocExporter::addFailure(const QString & path, const QString & reason)
+{
+    failures_.append(QString("%1: %2").arg(path, reason));
+}
+
+bool DocExporter::loadExistingEntries()
+{
+    QuaZip existing(zip_.getZipName());
+    if (!existing.open(QuaZip::mdUnzip))
+    {
+        return false;
+    }
+    const QList<QuaZipFileInfo64> entries = existing.getFileInfoList64();
+    existing.close();
+    if (existing.getZipError() != UNZ_OK)
+    {
+        return false;
+    }
+    for (const QuaZipFileInfo64 & entry : entries)
+    {
+        if (!entry.comment.isEmpty())
+        {
+            existingHashes_.insert(entry.comment);
+        }
+        // names are "<n>-<name>" or "<n>/<name>", new entries continue the numbering
+        int digits = 0;
+        while (digits < entry.name.size() && entry.name[digits].isDigit())
+        {
+            ++digits;
+        }
+        entryIndex_ = qMax(entryIndex_, entry.name.left(digits).toInt());
+    }
+    return true;
+}
+
+bool DocExporter::open(bool update)
+{
+    timer_.start();
+    QuaZip::Mode mode = QuaZip::mdCreate;
+    if (update && QFileInfo(zip_.getZipName()).isFile())
+    {
+        if (!loadExistingEntries())
+        {
+            return false;
+        }
+        // new entries go where the central directory was, existing data stays untouched
+        mode = QuaZip::mdAdd;
+    }
+    if (!zip_.open(mode))
+    {
+        return false;
+    }
+    const size_t threads = qMax(1, QThread::idealThreadCount());
+    window_ = threads * kChunksPerWorker;
+    stopping_ = false;
+    for (size_t i = 0; i < threads; ++i)
+    {
+        workers_.emplace_back(&DocExporter::runWorker, this);
+    }
+    return true;
+}
+
+void DocExporter::runWorker()
+{
+    for (;;)
+    {
+        std::shared_ptr<Chunk> chunk;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            chunkQueued_.wait(lock, [this]() { return stopping_ || unclaimed_ < chunks_.size(); });
+            if (unclaimed_ == chunks_.size())
+            {
+                return;
+            }
+            chunk = chunks_[unclaimed_++];
+            chunk->claimed = true;
+        }
+        if (chunk->done)
+        {
+            // nothing to deflate for a cached entry
+            continue;
+        }
+        compressChunk(*chunk);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            chunk->done = true;
+        }
+        chunkDone_.notify_all();
+    }
+}
+
+void DocExporter::compressChunk(Chunk & chunk) const
+{
+    if (isCancelled())
+    {
+        chunk.error = "cancelled";
+        return;
+    }
+    QFile file(chunk.entry->filePath);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        chunk.error = file.errorString();
+        return;
+    }
+    QByteArray buffer;
+    const uchar * input = chunk.size > 0 ? file.map(chunk.offset, chunk.size) : nullptr;
+    if (!input && chunk.size > 0)
+    {
+        if (!file.seek(chunk.offset) || (buffer = file.read(chunk.size)).size() != chunk.size)
+        {
+            chunk.error = "file changed while exporting";
+            return;
+        }
+        input = reinterpret_cast<const uchar *>(buffer.constData());
+    }
+    chunk.crc = crc32(0L, input, chunk.size);
+    if (chunk.entry->method == CompressionPolicy::Store)
+    {
+        chunk.data = buffer.isEmpty() ? QByteArray(reinterpret_cast<const char *>(input), chunk.size) : buffer;
+        return;
+    }
+
+    z_stream stream = {};
+    if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, DEF_MEM_LEVEL, Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+        chunk.error = "deflate init failed";
+        return;
+    }
+    // a sync flush adds an empty stored block on top of the bound
+    chunk.data.resize(deflateBound(&stream, chunk.size) + 16);
+    stream.next_in = const_cast<Bytef *>(input);
+    stream.avail_in = chunk.size;
+    stream.next_out = reinterpret_cast<Bytef *>(chunk.data.data());
+    stream.avail_out = chunk.data.size();
+    const int result = deflate(&stream, chunk.last ? Z_FINISH : Z_SYNC_FLUSH);
+    const bool complete = chunk.last ? result == Z_STREAM_END : result == Z_OK && stream.avail_out > 0;
+    chunk.data.resize(stream.total_out);
+    deflateEnd(&stream);
+    if (!complete)
+    {
+        chunk.error = QString("deflate error %1").arg(result);
+    }
+}
+
+bool DocExporter::openEntry(QuaZipFile & zipFile, Entry & entry)
+{
+    // sizes must fit the local header or, on a sequential device, the data descriptor
+    // which is written once the data has gone, so zip64 is decided up front
+    zip_.setZip64Enabled(entry.size >= kZip64Threshold);
+    if (!zipFile.open(QIODevice::WriteOnly, entry.zipInfo, nullptr, 0, entry.method, Z_DEFAULT_COMPRESSION, true))
+    {
+        entry.failed = true;
+        addFailure(entry.filePath, QString("zip error %1").arg(zipFile.getZipError()));
+        return false;
+    }
+    return true;
+}
+
+void DocExporter::discardEntry(QuaZipFile & zipFile)
+{
+    zipFile.discard();
+    // the data stays in the stream where a streaming reader takes it for an entry
+    QIODevice * device = zip_.getIoDevice();
+    if (device && device->isSequential())
+    {
+        broken_ = true;
+    }
+}
+
+void DocExporter::writeCachedEntry(Entry & entry)
+{
+    QFile file(entry.record.path);
+    QuaZipFile zipFile(&zip_);
+    if (!file.open(QIODevice::ReadOnly) || !file.seek(entry.record.dataOffset))
+    {
+        entry.failed = true;
+        addFailure(entry.filePath, "deflate sidecar can't be read");
+        return;
+    }
+    if (!openEntry(zipFile, entry))
+    {
+        return;
+    }
+    QByteArray buffer(kCopyBlockSize, Qt::Uninitialized);
+    qint64 left = entry.record.compressedSize;
+    while (left > 0 && !isCancelled())
+    {
+        const qint64 size = file.read(buffer.data(), qMin(left, kCopyBlockSize));
+        if (size <= 0 || zipFile.write(buffer.constData(), size) != size)
+        {
+            break;
+        }
+        left -= size;
+    }
+    if (left > 0)
+    {
+        entry.failed = true;
+        if (!isCancelled())
+        {
+            addFailure(entry.filePath, QString("copy from deflate sidecar failed, zip error %1").arg(zipFile.getZipError()));
+        }
+        discardEntry(zipFile);
+        return;
+    }
+    zipFile.closeRaw(entry.record.size, entry.record.crc);
+    if (zipFile.getZipError() != ZIP_OK)
+    {
+        entry.failed = true;
+        addFailure(entry.filePath, QString("zip error %1").arg(zipFile.getZipError()));
+        return;
+    }
+    bytesCount_ += entry.size;
+    ++filesCount_;
+    ++cachedCount_;
+}
+
+void DocExporter::writeChunk(Chunk & chunk)
+{
+    Entry & entry = *chunk.entry;
+    if (entry.cached)
+    {
+        writeCachedEntry(entry);
+        return;
+    }
+    if (!entry.failed && !chunk.error.isEmpty())
+    {
+        entry.failed = true;
+        if (!isCancelled())
+        {
+            addFailure(entry.filePath, chunk.error);
+        }
+    }
+    if (!entry.failed)
+    {
+        if (!entryFile_)
+        {
+            entryFile_.reset(new QuaZipFile(&zip_));
+            if (!openEntry(*entryFile_, entry))
+            {
+                entryFile_.reset();
+            }
+        }
+        if (entryFile_ && entryFile_->write(chunk.data) != chunk.data.size())
+        {
+            entry.failed = true;
+            addFailure(entry.filePath, QString("zip error %1").arg(entryFile_->getZipError()));
+        }
+        entry.crc = crc32_combine(entry.crc, chunk.crc, chunk.size);
+        bytesCount_ += chunk.size;
+        if (entry.sidecar && entry.sidecar->write(chunk.data) != chunk.data.size())
+        {
+            cache_.cancel(*entry.sidecar, entry.size);
+            entry.sidecar.reset();
+        }
+    }
+    if (chunk.last && entryFile_)
+    {
+        // the CRC and size of an entry that failed halfway don't match its data
+        if (entry.failed)
+        {
+            discardEntry(*entryFile_);
+        }
+        else
+        {
+            entryFile_->closeRaw(entry.size, entry.crc);
+        }
+        if (!entry.failed && entryFile_->getZipError() != ZIP_OK)
+        {
+            entry.failed = true;
+            addFailure(entry.filePath, QString("zip error %1").arg(entryFile_->getZipError()));
+        }
+        entryFile_.reset();
+        if (!entry.failed)
+        {
+            ++filesCount_;
+            if (entry.method == CompressionPolicy::Store)
+            {
+                ++storedCount_;
+            }
+        }
+    }
+    if (chunk.last && entry.sidecar)
+    {
+        // the reservation is given back either way
+        if (entry.failed)
+        {
+            cache_.cancel(*entry.sidecar, entry.size);
+        }
+        else
+        {
+            cache_.commit(*entry.sidecar, entry.md5, entry.size, entry.crc);
+        }
+        entry.sidecar.reset();
+    }
+}
+
+void DocExporter::writeChunks(size_t limit)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;)
+    {
+        while (!chunks_.empty() && chunks_.front()->done)
+        {
+            std::shared_ptr<Chunk> chunk = chunks_.front();
+            chunks_.pop_front();
+            // a cached chunk is done before any worker gets to it
+            if (chunk->claimed)
+            {
+                --unclaimed_;
+            }
+            lock.unlock();
+            writeChunk(*chunk);
+            lock.lock();
+        }
+        if (chunks_.size() < limit || chunks_.empty())
+        {
+            return;
+        }
+        chunkDone_.wait(lock);
+    }
+}
+
+CompressionPolicy::Method DocExporter::chooseMethod(const QString & filePath, const QString & fileName) const
+{
+    if (policy_.hasOverride(fileName))
+    {
+        return policy_.methodFor(fileName, nullptr, 0);
+    }
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return CompressionPolicy::Deflate;
+    }
+    const QByteArray sample = file.read(CompressionPolicy::kSampleSize);
+    return policy_.methodFor(fileName, sample.constData(), sample.size());
+}
+
+void DocExporter::stopWorkers()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    chunkQueued_.notify_all();
+    for (std::thread & worker : workers_)
+    {
+        worker.join();
+    }
+    workers_.clear();
+}
+
+bool DocExporter::addDocument(const DocInfo & info)
+{
+    if (isCancelled())
+    {
+        return false;
+    }
+    if (!info.md5.isEmpty() && existingHashes_.contains(info.md5))
+    {
+        ++skippedCount_;
+        return true;
+    }
+    const QFileInfo fileInfo(info.filePath);
+    if (!fileInfo.isFile() || !fileInfo.isReadable())
+    {
+        addFailure(info.filePath, "file can't be read");
+        return false;
+    }
+    const QString zipPath = QString::number(++entryIndex_).append(delimiter_).append(info.fileName);
+    std::shared_ptr<Entry> entry = std::make_shared<Entry>(info.filePath, zipPath);
+    entry->size = fileInfo.size();
+    entry->zipInfo.uncompressedSize = entry->size;
+    entry->md5 = info.md5;
+    if (!info.md5.isEmpty())
+    {
+        // lets a later update recognize the document
+        entry->zipInfo.comment = info.md5;
+        existingHashes_.insert(info.md5);
+    }
+    entry->method = chooseMethod(info.filePath, info.fileName);
+    if (entry->method == CompressionPolicy::Deflate && cache_.isEnabled())
+    {
+        entry->cached = cache_.lookup(info.md5, entry->size, entry->record);
+        if (entry->cached)
+        {
+            writeChunks(window_);
+            std::shared_ptr<Chunk> chunk = std::make_shared<Chunk>();
+            chunk->entry = entry;
+            chunk->offset = 0;
+            chunk->size = entry->size;
+            chunk->last = true;
+            chunk->crc = entry->record.crc;
+            chunk->claimed = false;
+            chunk->done = true;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                chunks_.push_back(chunk);
+            }
+            chunkDone_.notify_all();
+            return true;
+        }
+        entry->sidecar = cache_.begin(info.md5, entry->size);
+    }
+    qint64 offset = 0;
+    do
+    {
+        writeChunks(window_);
+        std::shared_ptr<Chunk> chunk = std::make_shared<Chunk>();
+        chunk->entry = entry;
+        chunk->offset = offset;
+        chunk->size = qMin(kChunkSize, entry->size - offset);
+        chunk->last = offset + chunk->size == entry->size;
+        chunk->crc = 0;
+        chunk->claimed = false;
+        chunk->done = false;
+        offset += chunk->size;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            chunks_.push_back(chunk);
+        }
+        chunkQueued_.notify_one();
+    }
+    while (offset < entry->size);
+    return true;
+}
+
+bool DocExporter::close()
+{
+    writeChunks(1);
+    stopWorkers();
+    zip_.close();
+    return zip_.getZipError() == ZIP_OK && !broken_;
+}
+
+double DocExporter::megabytesPerSecond() const
+{
+    const qint64 ms = timer_.isValid() ? timer_.elapsed() : 0;
+    return ms > 0 ? bytesCount_ / kMegabyte * 1000.0 / ms : 0.0;
+}
+
+QString DocExporter::statsMessage() const
+{
+    QString message = QString("Exported %1 files (%2 MB): %3 MB/s")
+        .arg(filesCount_.load())
+        .arg(bytesCount_ / kMegabyte, 0, 'f', 1)
+        .arg(megabytesPerSecond(), 0, 'f', 1);
+    if (storedCount_ > 0)
+    {
+        message.append(QString(", %1 stored without compression").arg(storedCount_.load()));
+    }
+    if (skippedCount_ > 0)
+    {
+        message.append(QString(", %1 already in the archive").arg(skippedCount_.load()));
+    }
+    if (cachedCount_ > 0)
+    {
+        message.append(QString(", %1 copied from deflate cache").arg(cachedCount_.load()));
+    }
+    if (!failures_.isEmpty())
+    {
+        message.append(QString(", %1 failed").arg(failures_.size()));
+    }
+    return message;
+}
@@ -0,0 +1,151 @@
+#ifndef DOC_EXPORTER_H
+#define DOC_EXPORTER_H
+
+#include <QStringList>
+#include <QSet>
+#include <QElapsedTimer>
+
+#include "quazip.h"
+#include "quazipnewinfo.h"
+
+#include "compressionpolicy.h"
+#include "deflatecache.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class QIODevice;
+class QuaZipFile;
+class QSaveFile;
+struct DocInfo;
+struct SaveData;
+
+class DocExporter
+{
+private:
+    // document being exported, shared by its chunks
+    struct Entry
+    {
+        QString filePath;
+        QString md5; // content hash, names the sidecar
+        QuaZipNewInfo zipInfo;
+        qint64 size;
+        quint32 crc; // combined from the chunks written so far
+        int method; // zip method chosen by the policy
+        bool failed;
+        bool cached; // written from the deflate sidecar, without workers
+        DeflateCache::Record record; // sidecar of a cached entry
+        std::unique_ptr<QSaveFile> sidecar; // filled while the entry is written
+
+        Entry(const QString & path, const QString & zipPath);
+        ~Entry();
+    };
+    // piece of a document that is read and deflated on its own by a worker
+    struct Chunk
+    {
+        std::shared_ptr<Entry> entry;
+        qint64 offset;
+        qint64 size;
+        bool last;
+        QByteArray data; // raw deflate stream ending on a byte boundary, or the bytes as they are when stored
+        quint32 crc;
+        QString error;
+        bool claimed; // taken by a worker, counts in unclaimed_
+        bool done;
+    };
+private:
+    QuaZip zip_;
+    QString delimiter_; // separates the entry number from the file name
+    CompressionPolicy policy_;
+    DeflateCache cache_;
+    QElapsedTimer timer_; // measures the whole export
+    const std::atomic<bool> * cancelled_; // set from another thread to stop the export
+    int entryIndex_; // number given to the last entry
+    // counters are read by the GUI thread while the export runs
+    std::atomic<qint64> filesCount_;
+    std::atomic<qint64> bytesCount_;
+    std::atomic<qint64> storedCount_; // files written without deflate
+    std::atomic<qint64> cachedCount_; // files copied from deflate sidecars
+    std::atomic<qint64> skippedCount_; // files the updated archive already has
+    QSet<QString> existingHashes_; // content hashes from entry comments of the updated archive
+    QStringList failures_; // documents that could not be exported, with the reason
+    bool broken_; // a streamed entry failed halfway, a streaming reader can't get past it
+    // chunks in archive order, workers take them from the front part, the writer
+    // removes finished ones from the front
+    std::deque<std::shared_ptr<Chunk>> chunks_;
+    size_t unclaimed_; // position of the first chunk no worker has taken yet
+    size_t window_; // limit of chunks held in memory
+    bool stopping_;
+    std::mutex mutex_;
+    std::condition_variable chunkQueued_;
+    std::condition_variable chunkDone_;
+    std::vector<std::thread> workers_;
+    std::unique_ptr<QuaZipFile> entryFile_; // entry the writer is filling
+private:
+    //
+    bool isCancelled() const { return cancelled_ && *cancelled_; }
+    //
+    void addFailure(const QString & path, const QString & reason);
+    // worker thread loop
+    void runWorker();
+    // read and deflate the chunk, runs on a worker thread
+    void compressChunk(Chunk & chunk) const;
+    // append the deflated chunk to the archive, runs on the caller's thread
+    void writeChunk(Chunk & chunk);
+    // start the entry in the archive, records a failure if that's impossible
+    bool openEntry(QuaZipFile & zipFile, Entry & entry);
+    // leave an entry that failed halfway out of the central directory
+    void discardEntry(QuaZipFile & zipFile);
+    // copy the sidecar stream of a cached entry into the archive
+    void writeCachedEntry(Entry & entry);
+    // write finished chunks in order until fewer than limit remain queued
+    void writeChunks(size_t limit);
+    // collect content hashes and the last entry number of the archive being updated
+    bool loadExistingEntries();
+    // sample the start of the document unless its extension decides
+    CompressionPolicy::Method chooseMethod(const QString & filePath, const QString & fileName) const;
+    //
+    void stopWorkers();
+public:
+    //
+    DocExporter(SaveData * save, const QString & zipPath, bool singleFolder);
+    // write to an open device, a sequential one like a pipe or socket is streamed with
+    // data descriptors and never seeked
+    DocExporter(SaveData * save, QIODevice * device, bool singleFolder);
+    //
+    ~DocExporter();
+    // the export stops at the next chunk once the flag is raised
+    void setCancelFlag(const std::atomic<bool> * cancelled) { cancelled_ = cancelled; }
+    // create the archive, start deflate workers and start measuring, with update an
+    // existing archive is opened for adding and its documents are not written again
+    bool open(bool update = false);
+    // queue the document as a numbered entry, chunks that are already deflated get
+    // written meanwhile, blocks while too many chunks wait to be written
+    bool addDocument(const DocInfo & info);
+    // write the remaining chunks and the central directory, fails if a streamed
+    // entry could not be written in full
+    bool close();
+    //
+    qint64 filesCount() const { return filesCount_; }
+    //
+    qint64 bytesCount() const { return bytesCount_; }
+    //
+    qint64 storedCount() const { return storedCount_; }
+    //
+    qint64 cachedCount() const { return cachedCount_; }
+    //
+    qint64 skippedCount() const { return skippedCount_; }
+    //
+    const QStringList & failures() const { return failures_; }
+    //
+    double megabytesPerSecond() const;
+    // human readable throughput report
+    QString statsMessage() const;
+};
+
+#endif // DOC_EXPORTER_H
@@ -0,0 +1,364 @@
+#include "docimporter.h"
+
+#include <QDir>
+#include <QDirIterator>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QCryptographicHash>
+#include <QTemporaryFile>
+
+#include "quazip.h"
+#include "quazipfile.h"
+
+#include "constants.h"
+#include "docinfo.h"
+#include "savedata.h"
+
+namespace
+{
+    const int kReadBufferSize = 256 * 1024;
+    const double kMegabyte = 1024.0 * 1024.0;
+}
+
+//=============================================================================
+// class DocImporter
+//=============================================================================
+DocImporter::DocImporter(SaveData * save)
+    : save_(save)
+    , nameFilters_(uploadNameFilters())
+    , index_(save->getIndexFilePath())
+    , mirror_(save->getTagMirror())
+    , cancelled_(nullptr)
+    , filesCount_(0)
+    , bytesCount_(0)
+    , skippedCount_(0)
+{
+}
+
+QStringList DocImporter::uploadNameFilters()
+{
+    QStringList filters;
+    const QStringList groups = Constants::kUploadFilters.split(";;");
+    for (const QString & group : groups)
+    {
+        const int begin = group.indexOf('(');
+        const int end = group.lastIndexOf(')');
+        if (begin < 0 || end <= begin)
+        {
+            continue;
+        }
+        const QStringList masks = group.mid(begin + 1, end - begin - 1).split(' ', QString::SkipEmptyParts);
+        for (const QString & mask : masks)
+        {
+            if (mask != "*.*" && !filters.contains(mask))
+            {
+                filters.append(mask);
+            }
+        }
+    }
+    return filters;
+}
+
+bool DocImporter::isTextFile(const QString & fileName)
+{
+    static const QStringList extensions = Constants::kTextExtensions.split(' ');
+    return extensions.contains(QFileInfo(fileName).suffix().toLower());
+}
+
+void DocImporter::start()
+{
+    filesCount_ = 0;
+    bytesCount_ = 0;
+    skippedCount_ = 0;
+    failures_.clear();
+    timer_.start();
+}
+
+void DocImporter::addFailure(const QString & path, const QString & reason)
+{
+    if (!isCancelled())
+    {
+        failures_.append(QString("%1: %2").arg(path).arg(reason));
+    }
+}
+
+bool DocImporter::isMarkupFile(const QString & fileName)
+{
+    const QString suffix = QFileInfo(fileName).suffix().toLower();
+    return suffix.startsWith("htm") || suffix == "xml";
+}
+
+bool DocImporter::readDocument(QIODevice & in, QIODevice * copy, DocInfo & info, QString & md5, TextTokenizer & tokenizer)
+{
+    const TagMatcher & matcher = save_->tagMatcher;
+    TagMatcher::Scan scan = matcher.begin();
+    matcher.feed(scan, info.filePath, TagRule::Path);
+    scan.node = 0;
+    matcher.feed(scan, info.fileName, TagRule::Path);
+    scan.node = 0;
+    const bool isText = isTextFile(info.fileName);
+    const bool scanContent = isText && matcher.hasScope(TagRule::Content);
+
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    QByteArray buffer(kReadBufferSize, Qt::Uninitialized);
+    qint64 size = 0;
+    while ((size = in.read(buffer.data(), buffer.size())) > 0)
+    {
+        if (isCancelled())
+        {
+            return false;
+        }
+        hash.addData(buffer.constData(), size);
+        if (scanContent)
+        {
+            matcher.feed(scan, buffer.constData(), size, TagRule::Content);
+        }
+        if (isText)
+        {
+            tokenizer.feed(buffer.constData(), size);
+        }
+        if (copy && copy->write(buffer.constData(), size) != size)
+        {
+            return false;
+        }
+        bytesCount_ += size;
+    }
+    if (size < 0)
+    {
+        return false;
+    }
+    md5 = hash.result().toHex();
+    tokenizer.finish();
+    matcher.apply(scan, info.tags);
+    return true;
+}
+
+bool DocImporter::storeDocument(const DocInfo & info, const QString & md5, const TextTokenizer & tokenizer, const PlaceFile & placeFile)
+{
+    if (info.tags.isEmpty())
+    {
+        // nothing tagged the document, it would never be found
+        ++skippedCount_;
+        return false;
+    }
+
+    bool isPlaced = false;
+    QString folderPath(save_->getDocsFilePath());
+    folderPath.append("/").append(md5);
+    if (!QDir(folderPath).exists())
+    {
+        QDir().mkdir(folderPath);
+        const QString filepath = QDir(folderPath).filePath(info.fileName);
+        isPlaced = placeFile(filepath) && writeInfoFile(folderPath, info);
+        if (!isPlaced)
+        {
+            // don't leave a half written document in the catalog
+            QDir(folderPath).removeRecursively();
+            addFailure(info.filePath, "can't write to the docs folder");
+            return false;
+        }
+        if (isTextFile(info.fileName))
+        {
+            index_.addDocument(md5, tokenizer.terms());
+        }
+        if (mirror_.isEnabled())
+        {
+            DocInfo stored(info);
+            stored.md5 = md5;
+            mirror_.add(stored);
+        }
+    }
+    ++filesCount_;
+    return isPlaced;
+}
+
+bool DocImporter::importFile(const DocInfo & source)
+{
+    DocInfo info = source;
+    TextTokenizer tokenizer(isMarkupFile(info.fileName));
+
+    QFile file(info.filePath);
+    QString md5;
+    if (!file.open(QFile::ReadOnly))
+    {
+        addFailure(info.filePath, file.errorString());
+        return false;
+    }
+    const bool isRead = readDocument(file, nullptr, info, md5, tokenizer);
+    file.close();
+    if (!isRead)
+    {
+        addFailure(info.filePath, "read error");
+        return false;
+    }
+
+    return storeDocument(info, md5, tokenizer, [&file](const QString & filePath)
+    {
+        return file.copy(filePath);
+    });
+}
+
+void DocImporter::importFolder(const DocInfo & folderInfo)
+{
+    // the iterator reads directory entries on demand, so the tree is never listed up front
+    QDirIterator it(folderInfo.filePath, nameFilters_, QDir::Files | QDir::Readable | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+    DocInfo info = folderInfo;
+    info.isFolder = false;
+    while (it.hasNext() && !isCancelled())
+    {
+        info.filePath = it.next();
+        info.fileName = it.fileName();
+        importFile(info);
+    }
+}
+
+void DocImporter::importArchive(const DocInfo & archiveInfo)
+{
+    QuaZip zip(archiveInfo.filePath);
+    // entries are inflated straight from the mapped archive
+    zip.setMemoryMappingEnabled(true);
+    if (!zip.open(QuaZip::mdUnzip))
+    {
+        addFailure(archiveInfo.filePath, "can't open the archive");
+        return;
+    }
+
+    // optional manifest maps entry names to a tag array or to an object with tags and comment
+    QJsonObject manifest;
+    if (zip.setCurrentFile(Constants::kTagsManifest))
+    {
+        QuaZipFile manifestFile(&zip);
+        if (manifestFile.open(QIODevice::ReadOnly))
+        {
+            manifest = QJsonDocument::fromJson(manifestFile.readAll()).object();
+            manifestFile.close();
+        }
+    }
+
+    // entries are taken in central directory order and written straight into the docs
+    // folder, only a rename is left once the md5 is known
+    const QString docsPath = save_->getDocsFilePath();
+    for (bool more = zip.goToFirstFile(); more && !isCancelled(); more = zip.goToNextFile())
+    {
+        const QString entryName = zip.getCurrentFileName();
+        const QString fileName = QFileInfo(entryName).fileName();
+        if (fileName.isEmpty() || entryName == Constants::kTagsManifest || !QDir::match(nameFilters_, fileName))
+        {
+            continue;
+        }
+
+        DocInfo info = archiveInfo;
+        info.isArchive = false;
+        info.filePath = QDir(archiveInfo.filePath).filePath(entryName);
+        info.fileName = fileName;
+        const QJsonValue entryValue = manifest.value(entryName);
+        const QJsonArray entryTags = entryValue.isObject() ? entryValue.toObject()[Constants::kTags].toArray() : entryValue.toArray();
+        for (int i = 0, iEnd = entryTags.size(); i < iEnd; ++i)
+        {
+            const QString tag = entryTags[i].toString();
+            if (!info.tags.contains(tag))
+            {
+                info.tags.append(tag);
+            }
+        }
+        if (entryValue.isObject() && entryValue.toObject().contains(Constants::kComment))
+        {
+            info.comment = entryValue.toObject()[Constants::kComment].toString();
+        }
+
+        QuaZipFile entry(&zip);
+        QTemporaryFile incoming(QDir(docsPath).filePath(".incoming-XXXXXX"));
+        if (!entry.open(QIODevice::ReadOnly) || !incoming.open())
+        {
+            addFailure(info.filePath, "can't open the entry");
+            continue;
+        }
+        TextTokenizer tokenizer(isMarkupFile(info.fileName));
+        QString md5;
+        const bool isRead = readDocument(entry, &incoming, info, md5, tokenizer);
+        entry.close();
+        incoming.close();
+        // a broken entry is caught by the CRC check on close
+        if (!isRead || entry.getZipError() != UNZ_OK)
+        {
+            addFailure(info.filePath, "damaged entry");
+            continue;
+        }
+
+        storeDocument(info, md5, tokenizer, [&incoming](const QString & filePath)
+        {
+            if (incoming.rename(filePath))
+            {
+                incoming.setAutoRemove(false);
+                return true;
+            }
+            return false;
+        });
+    }
+    zip.close();
+}
+
+void DocImporter::finish()
+{
+    index_.flush();
+    // documents deleted from the search screen only leave tombstones, their
+    // postings are dropped here on the worker thread
+    if (!isCancelled() && index_.isCompactionDue())
+    {
+        index_.compact();
+    }
+}
+
+bool DocImporter::writeInfoFile(const QString & folderPath, const DocInfo & info)
+{
+    const QString infoPath = QDir(folderPath).filePath(Constants::kInfoDocFile);
+    QFile infoFile(infoPath);
+    const QString val = "{}";
+    QJsonDocument jsonDoc = QJsonDocument::fromJson(val.toUtf8());
+    QJsonObject obj = jsonDoc.object();
+    obj[Constants::kComment] = info.comment;
+    obj[Constants::kFilename] = info.fileName;
+    obj[Constants::kTags] = QJsonArray::fromStringList(info.tags);
+    jsonDoc.setObject(obj);
+
+    QByteArray json = jsonDoc.toJson(QJsonDocument::Indented);
+
+    if (infoFile.open(QIODevice::WriteOnly))
+    {
+        infoFile.write(json);
+        infoFile.close();
+        return true;
+    }
+    return false;
+}
+
+double DocImporter::filesPerSecond() const
+{
+    const qint64 ms = timer_.isValid() ? timer_.elapsed() : 0;
+    return ms > 0 ? filesCount_ * 1000.0 / ms : 0.0;
+}
+
+double DocImporter::megabytesPerSecond() const
+{
+    const qint64 ms = timer_.isValid() ? timer_.elapsed() : 0;
+    return ms > 0 ? bytesCount_ / kMegabyte * 1000.0 / ms : 0.0;
+}
+
+QString DocImporter::statsMessage() const
+{
+    QString message = QString("Imported %1 files (%2 MB): %3 files/s, %4 MB/s")
+        .arg(filesCount_.load())
+        .arg(bytesCount_ / kMegabyte, 0, 'f', 1)
+        .arg(filesPerSecond(), 0, 'f', 1)
+        .arg(megabytesPerSecond(), 0, 'f', 1);
+    if (skippedCount_ > 0)
+    {
+        message.append(QString(", %1 untagged skipped").arg(skippedCount_.load()));
+    }
+    if (!failures_.isEmpty())
+    {
+        message.append(QString(", %1 failed").arg(failures_.size()));
+    }
+    return message;
+}
@@ -0,0 +1,88 @@
+#ifndef DOC_IMPORTER_H
+#define DOC_IMPORTER_H
+
+#include <QStringList>
+#include <QElapsedTimer>
+
+#include "fulltextindex.h"
+#include "tagmirror.h"
+
+#include <atomic>
+#include <functional>
+
+class QIODevice;
+struct DocInfo;
+struct SaveData;
+
+class DocImporter
+{
+public:
+    typedef std::function<bool(const QString & filePath)> PlaceFile;
+private:
+    SaveData * save_;
+    QStringList nameFilters_; // file masks taken from the upload dialog filters
+    QElapsedTimer timer_; // measures the whole import
+    FullTextIndex index_; // receives terms of text documents
+    TagMirror mirror_; // gets links to new documents
+    const std::atomic<bool> * cancelled_; // set from another thread to stop the import
+    // counters are read by the GUI thread while the import runs
+    std::atomic<qint64> filesCount_;
+    std::atomic<qint64> bytesCount_;
+    std::atomic<qint64> skippedCount_;
+    QStringList failures_; // documents that could not be imported, with the reason
+private:
+    //
+    bool isCancelled() const { return cancelled_ && *cancelled_; }
+    //
+    void addFailure(const QString & path, const QString & reason);
+    // single pass over the document: md5, tag rules and text terms, each chunk is also
+    // written to copy when it's given
+    bool readDocument(QIODevice & in, QIODevice * copy, DocInfo & info, QString & md5, TextTokenizer & tokenizer);
+    // create the md5 folder unless the document is already stored, placeFile puts
+    // the document itself there, returns true if it was called and succeeded,
+    // a folder whose document could not be placed is removed again
+    bool storeDocument(const DocInfo & info, const QString & md5, const TextTokenizer & tokenizer, const PlaceFile & placeFile);
+    //
+    bool writeInfoFile(const QString & folderPath, const DocInfo & info);
+public:
+    //
+    DocImporter(SaveData * save);
+    // file masks from Constants::kUploadFilters without the "All files" group
+    static QStringList uploadNameFilters();
+    // true for formats whose content is plain text
+    static bool isTextFile(const QString & fileName);
+    // true for html and xml
+    static bool isMarkupFile(const QString & fileName);
+    // the import stops at the next chunk once the flag is raised
+    void setCancelFlag(const std::atomic<bool> * cancelled) { cancelled_ = cancelled; }
+    // reset statistics and start measuring
+    void start();
+    // copy file into the docs folder, returns false if it isn't stored: a failure is recorded
+    // when it can't be read or placed, a document without tags or already in the folder is
+    // only counted
+    bool importFile(const DocInfo & source);
+    // walk the folder tree lazily and import every file that matches upload filters,
+    // files get tags and comment of the folder entry
+    void importFolder(const DocInfo & folderInfo);
+    // stream every matching entry of a zip archive into the docs folder, entries get tags
+    // and comment of the archive entry plus the ones from the embedded tags manifest
+    void importArchive(const DocInfo & archiveInfo);
+    // write what is still buffered to disk and compact the index if it's due
+    void finish();
+    //
+    qint64 filesCount() const { return filesCount_; }
+    //
+    qint64 bytesCount() const { return bytesCount_; }
+    //
+    qint64 skippedCount() const { return skippedCount_; }
+    //
+    const QStringList & failures() const { return failures_; }
+    //
+    double filesPerSecond() const;
+    //
+    double megabytesPerSecond() const;
+    // human readable throughput report
+    QString statsMessage() const;
+};
+
+#endif // DOC_IMPORTER_H
@@ -9,6 +9,9 @@ struct DocInfo
     QString fileName;
     QStringList tags;
     QString comment;
+    QString md5; // content hash, also the name of the document folder
+    bool isFolder = false; // entry stands for a whole folder tree
+    bool isArchive = false; // entry stands for every document of a zip archive
 };
 
 
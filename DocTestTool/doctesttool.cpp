@@ -5,6 +5,7 @@
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QDesktopServices>
+#include <QMessageBox>
 #include "quazip.h"
 #include "quazipfile.h"
 #include "quazipnewinfo.h"
@@ -12,6 +13,7 @@
 
 #include "constants.h"
 #include "docinfo.h"
+#include "backgroundjob.h"
 
 #include "mainscreen.h"
 #include "editscreen.h"
@@ -25,10 +27,16 @@
 DocTestTool::DocTestTool(QWidget * parent)
     : QMainWindow(parent)
     , screen_(Q_NULLPTR)
+    , jobsTimer_(Q_NULLPTR)
+    , isShowingJobs_(false)
+    , shownJob_(Q_NULLPTR)
 {
     ui.setupUi(this);
 
     QObject::connect(ui.actionExit, SIGNAL(triggered()), qApp, SLOT(quit()));
+    QObject::connect(ui.actionAddFolder, SIGNAL(triggered()), this, SLOT(onAddFolderTriggered()));
+    QObject::connect(ui.actionAddArchive, SIGNAL(triggered()), this, SLOT(onAddArchiveTriggered()));
+    QObject::connect(ui.actionExportFolder, SIGNAL(triggered()), this, SLOT(onExportFolderTriggered()));
 
     QObject::connect(ui.uploadBtn, SIGNAL(clicked()), this, SLOT(onUploadButtonClicked()));
     QObject::connect(ui.editBtn, SIGNAL(clicked()), this, SLOT(onEditButtonClicked()));
@@ -46,6 +54,7 @@ DocTestTool::DocTestTool(QWidget * parent)
     QObject::connect(ui.saveBtn, SIGNAL(clicked()), this, SLOT(onSaveButtonClicked()));
     QObject::connect(ui.clearBtn, SIGNAL(clicked()), this, SLOT(onClearTagButtonClicked()));
     QObject::connect(ui.loginBtn, SIGNAL(clicked()), this, SLOT(onLoginButtonClicked()));
+    QObject::connect(ui.cancelBtn, SIGNAL(clicked()), this, SLOT(onCancelButtonClicked()));
 
     QObject::connect(ui.tagsListWidget, SIGNAL(itemClicked(QListWidgetItem *)), this, SLOT(onTagsListClicked(QListWidgetItem *)));
     QObject::connect(ui.tagsListWidget, SIGNAL(itemDoubleClicked(QListWidgetItem *)), this, SLOT(onTagsListDoubleClicked(QListWidgetItem *)));
@@ -57,10 +66,22 @@ DocTestTool::DocTestTool(QWidget * parent)
     ui.docsListWidget->setSelectionMode(QAbstractItemView::SelectionMode::ExtendedSelection);
 
     switchToScreen(ScreenId::Login);
+
+    jobsTimer_ = new QTimer(this);
+    QObject::connect(jobsTimer_, &QTimer::timeout, [this]() { updateJobs(); });
+    jobsTimer_->start(500);
 }
 
 DocTestTool::~DocTestTool()
 {
+    for (BackgroundJob * job : save_.jobs)
+    {
+        job->cancel();
+        job->wait();
+        delete job;
+    }
+    save_.jobs.clear();
+
     if (screen_)
     {
         delete screen_;
@@ -164,6 +185,43 @@ void DocTestTool::onAddButtonClicked()
     }
 }
 
+void DocTestTool::onAddFolderTriggered()
+{
+    if (screen_ && screen_->isMain())
+    {
+        switchToScreen(ScreenId::Upload);
+    }
+    if (screen_ && screen_->isUpload())
+    {
+        screen_->processUserEvent(Screen::UserEvent::AddFolderClicked);
+    }
+}
+
+void DocTestTool::onAddArchiveTriggered()
+{
+    if (screen_ && screen_->isMain())
+    {
+        switchToScreen(ScreenId::Upload);
+    }
+    if (screen_ && screen_->isUpload())
+    {
+        screen_->processUserEvent(Screen::UserEvent::AddArchiveClicked);
+    }
+}
+
+void DocTestTool::onExportFolderTriggered()
+{
+    if (screen_ && screen_->isSearch())
+    {
+        screen_->processUserEvent(Screen::UserEvent::ExportFolderClicked);
+    }
+    else
+    {
+        ui.statusBar->setStyleSheet("color: red");
+        ui.statusBar->showMessage("Search for documents to export first!", 2000);
+    }
+}
+
 void DocTestTool::onClearTagButtonClicked()
 {
     if (screen_)
@@ -232,3 +290,101 @@ void DocTestTool::switchToScreen(ScreenId id)
         break;
     }
 }
+
+void DocTestTool::onCancelButtonClicked()
+{
+    // the job that was on screen when the user clicked, not one started since
+    if (shownJob_ && save_.jobs.contains(shownJob_))
+    {
+        shownJob_->cancel();
+    }
+}
+
+BackgroundJob * DocTestTool::pickShownJob() const
+{
+    for (int i = save_.jobs.size() - 1; i >= 0; --i)
+    {
+        if (save_.jobs[i]->type() != BackgroundJob::Type::Mirror)
+        {
+            return save_.jobs[i];
+        }
+    }
+    return save_.jobs.isEmpty() ? Q_NULLPTR : save_.jobs.last();
+}
+
+void DocTestTool::updateJobs()
+{
+    // take finished jobs out first, a report box spins the event loop and calls us again
+    QList<BackgroundJob *> finishedJobs;
+    for (int i = save_.jobs.size() - 1; i >= 0; --i)
+    {
+        if (save_.jobs[i]->isFinished())
+        {
+            finishedJobs.prepend(save_.jobs.takeAt(i));
+        }
+    }
+
+    shownJob_ = pickShownJob();
+    if (shownJob_)
+    {
+        BackgroundJob * job = shownJob_;
+        const qint64 total = job->bytesTotal();
+        ui.progressBar->setVisible(true);
+        ui.progressBar->setFormat(job->title() + " %p%");
+        ui.cancelBtn->setVisible(true);
+        ui.cancelBtn->setToolTip(QString("Cancel %1").arg(job->title()));
+        if (total > 0)
+        {
+            ui.progressBar->setMaximum(1000);
+            ui.progressBar->setValue(int(job->bytesDone() * 1000 / total));
+        }
+        else
+        {
+            // busy indicator
+            ui.progressBar->setMaximum(0);
+            ui.progressBar->setValue(0);
+        }
+
+        QStringList messages;
+        for (BackgroundJob * running : save_.jobs)
+        {
+            messages.append(running->progressMessage());
+        }
+        ui.statusBar->setStyleSheet("color: black");
+        ui.statusBar->showMessage(messages.join(" | "));
+        isShowingJobs_ = true;
+    }
+    else if (isShowingJobs_)
+    {
+        ui.progressBar->setMaximum(100);
+        ui.progressBar->setFormat("%p%");
+        ui.progressBar->setVisible(false);
+        ui.cancelBtn->setVisible(false);
+        ui.statusBar->clearMessage();
+        isShowingJobs_ = false;
+    }
+
+    for (BackgroundJob * job : finishedJobs)
+    {
+        job->wait();
+        const QString summary = job->finish(&save_);
+        const QStringList & failures = job->failures();
+        if (failures.isEmpty())
+        {
+            ui.statusBar->setStyleSheet("color: black");
+            ui.statusBar->showMessage(summary, 5000);
+        }
+        else
+        {
+            const int kMaxListed = 20;
+            QString report = summary;
+            report.append("\n\n").append(failures.mid(0, kMaxListed).join("\n"));
+            if (failures.size() > kMaxListed)
+            {
+                report.append(QString("\n... and %1 more").arg(failures.size() - kMaxListed));
+            }
+            QMessageBox::warning(this, job->title(), report);
+        }
+        delete job;
+    }
+}
\ No newline at end of file
@@ -3,6 +3,7 @@
 
 #include <QtWidgets/QMainWindow>
 #include <QtCore/QFile>
+#include <QtCore/QTimer>
 #include "ui_doctesttool.h"
 #include "savedata.h"
 
@@ -25,6 +26,9 @@ private:
 
     Screen * screen_;
     SaveData save_;
+    QTimer * jobsTimer_; // polls background jobs
+    bool isShowingJobs_;
+    BackgroundJob * shownJob_; // job the progress bar and the cancel button are for
 
 public:
     DocTestTool(QWidget * parent = Q_NULLPTR);
@@ -33,6 +37,10 @@ public:
 
     void switchToScreen(ScreenId id);
     void prepareFolders();
+    // show progress of running jobs and report the finished ones
+    void updateJobs();
+    // the newest job the user started, the tag mirror runs on its own
+    BackgroundJob * pickShownJob() const;
 public slots:
     void onEditButtonClicked();
     void onUploadButtonClicked();
@@ -51,6 +59,10 @@ public slots:
     void onListWidgetClicked(QListWidgetItem * item);
     void onListWidgetDoubleClicked(QListWidgetItem * item);
     void onEditorComboBoxChanged(const QString & text);
+    void onAddFolderTriggered();
+    void onAddArchiveTriggered();
+    void onExportFolderTriggered();
+    void onCancelButtonClicked();
 
 private:
     Ui::DocTestToolClass ui;
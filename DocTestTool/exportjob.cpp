@@ -0,0 +1,69 @@
+#include "exportjob.h"
+
+#include <QFile>
+#include <QFileInfo>
+
+//=============================================================================
+// class ExportJob
+//=============================================================================
+ExportJob::ExportJob(const SaveData & save, const QList<DocInfo> & docs, const QString & zipPath, bool singleFolder, bool update)
+    : save_(save)
+    , docs_(docs)
+    , zipPath_(zipPath)
+    , update_(update)
+    , exporter_(&save_, zipPath, singleFolder)
+    , closed_(false)
+    , bytesTotal_(0)
+{
+    save_.jobs.clear();
+    save_.folderDocsData.clear();
+    exporter_.setCancelFlag(&cancelled_);
+
+    for (const DocInfo & info : docs_)
+    {
+        bytesTotal_ += QFileInfo(info.filePath).size();
+    }
+}
+
+ExportJob::~ExportJob()
+{
+    wait();
+}
+
+void ExportJob::run()
+{
+    if (!exporter_.open(update_))
+    {
+        failures_.append(QString("%1: can't %2 the archive").arg(zipPath_, update_ ? "update" : "create"));
+        return;
+    }
+    for (const DocInfo & info : docs_)
+    {
+        if (isCancelled())
+        {
+            break;
+        }
+        exporter_.addDocument(info);
+    }
+    closed_ = exporter_.close();
+    failures_ = exporter_.failures();
+    if (isCancelled() && !update_ && QFileInfo(zipPath_).isFile())
+    {
+        // half an archive is worse than none, pipes and updated archives are left alone
+        QFile::remove(zipPath_);
+    }
+    else if (!closed_)
+    {
+        failures_.append(QString("%1: central directory could not be written").arg(zipPath_));
+    }
+}
+
+QString ExportJob::finish(SaveData * /*save*/)
+{
+    QString message = exporter_.statsMessage();
+    if (isCancelled())
+    {
+        message.prepend(update_ ? "Export cancelled, archive keeps what was added. " : "Export cancelled, partial archive removed. ");
+    }
+    return message;
+}
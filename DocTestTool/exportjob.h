@@ -0,0 +1,43 @@
+#ifndef EXPORT_JOB_H
+#define EXPORT_JOB_H
+
+#include "backgroundjob.h"
+#include "docexporter.h"
+#include "docinfo.h"
+#include "savedata.h"
+
+class ExportJob : public BackgroundJob
+{
+private:
+    SaveData save_; // snapshot of settings, the GUI may edit the original meanwhile
+    QList<DocInfo> docs_; // search results to export
+    QString zipPath_;
+    bool update_; // add to the existing archive instead of replacing it
+    DocExporter exporter_;
+    bool closed_; // central directory written
+    qint64 bytesTotal_;
+protected:
+    //
+    virtual void run() override;
+public:
+    //
+    ExportJob(const SaveData & save, const QList<DocInfo> & docs, const QString & zipPath, bool singleFolder, bool update);
+    //
+    virtual ~ExportJob();
+    //
+    virtual Type type() const override { return Type::Export; }
+    //
+    virtual QString title() const override { return "Export"; }
+    //
+    virtual qint64 filesDone() const override { return exporter_.filesCount(); }
+    //
+    virtual qint64 filesTotal() const override { return docs_.size(); }
+    //
+    virtual qint64 bytesDone() const override { return exporter_.bytesCount(); }
+    //
+    virtual qint64 bytesTotal() const override { return bytesTotal_; }
+    //
+    virtual QString finish(SaveData * save) override;
+};
+
+#endif // EXPORT_JOB_H
@@ -0,0 +1,205 @@
+#include "filelinker.h"
+
+#include <QDir>
+#include <QFile>
+
+#if defined(Q_OS_UNIX)
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#if defined(Q_OS_LINUX)
+#include <linux/fs.h>
+#include <sys/syscall.h>
+#endif
+#if defined(Q_OS_MACOS)
+#include <sys/clonefile.h>
+#endif
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#endif
+
+namespace
+{
+#if defined(Q_OS_LINUX)
+    // opens both ends for the descriptor based methods, target is created exclusively
+    bool openPair(const QByteArray & source, const QByteArray & target, int & in, int & out, struct stat & info)
+    {
+        in = ::open(source.constData(), O_RDONLY | O_CLOEXEC);
+        if (in < 0)
+        {
+            return false;
+        }
+        if (::fstat(in, &info) != 0)
+        {
+            ::close(in);
+            return false;
+        }
+        out = ::open(target.constData(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, info.st_mode & 0777);
+        if (out < 0)
+        {
+            ::close(in);
+            return false;
+        }
+        return true;
+    }
+
+    void closePair(int in, int out, bool keepTarget, const QByteArray & target)
+    {
+        ::close(in);
+        ::close(out);
+        if (!keepTarget)
+        {
+            ::unlink(target.constData());
+        }
+    }
+#endif
+
+    bool cloneFile(const QString & source, const QString & target)
+    {
+#if defined(Q_OS_LINUX) && defined(FICLONE)
+        const QByteArray from = QFile::encodeName(source);
+        const QByteArray to = QFile::encodeName(target);
+        int in = -1;
+        int out = -1;
+        struct stat info;
+        if (!openPair(from, to, in, out, info))
+        {
+            return false;
+        }
+        const bool cloned = ::ioctl(out, FICLONE, in) == 0;
+        closePair(in, out, cloned, to);
+        return cloned;
+#elif defined(Q_OS_MACOS)
+        return ::clonefile(QFile::encodeName(source).constData(), QFile::encodeName(target).constData(), 0) == 0;
+#else
+        Q_UNUSED(source);
+        Q_UNUSED(target);
+        return false;
+#endif
+    }
+
+    bool kernelCopy(const QString & source, const QString & target)
+    {
+#if defined(Q_OS_LINUX) && defined(__NR_copy_file_range)
+        const QByteArray from = QFile::encodeName(source);
+        const QByteArray to = QFile::encodeName(target);
+        int in = -1;
+        int out = -1;
+        struct stat info;
+        if (!openPair(from, to, in, out, info))
+        {
+            return false;
+        }
+        off_t left = info.st_size;
+        while (left > 0)
+        {
+            const long copied = ::syscall(__NR_copy_file_range, in, NULL, out, NULL, static_cast<size_t>(left), 0u);
+            if (copied <= 0)
+            {
+                break;
+            }
+            left -= copied;
+        }
+        closePair(in, out, left == 0, to);
+        return left == 0;
+#else
+        Q_UNUSED(source);
+        Q_UNUSED(target);
+        return false;
+#endif
+    }
+}
+
+//=============================================================================
+// class FileLinker
+//=============================================================================
+FileLinker::Method FileLinker::place(const QString & source, const QString & target)
+{
+    if (QFile::exists(target))
+    {
+        return Failed;
+    }
+    if (cloneFile(source, target))
+    {
+        return Clone;
+    }
+    if (hardLink(source, target))
+    {
+        return HardLink;
+    }
+    if (kernelCopy(source, target))
+    {
+        return KernelCopy;
+    }
+    return QFile::copy(source, target) ? Copy : Failed;
+}
+
+bool FileLinker::hardLink(const QString & source, const QString & target)
+{
+#if defined(Q_OS_UNIX)
+    return ::link(QFile::encodeName(source).constData(), QFile::encodeName(target).constData()) == 0;
+#elif defined(Q_OS_WIN)
+    const QString from = QDir::toNativeSeparators(source);
+    const QString to = QDir::toNativeSeparators(target);
+    return CreateHardLinkW(reinterpret_cast<LPCWSTR>(to.utf16()), reinterpret_cast<LPCWSTR>(from.utf16()), NULL) != 0;
+#else
+    Q_UNUSED(source);
+    Q_UNUSED(target);
+    return false;
+#endif
+}
+
+bool FileLinker::isSameFile(const QString & first, const QString & second)
+{
+#if defined(Q_OS_UNIX)
+    struct stat a;
+    struct stat b;
+    return ::stat(QFile::encodeName(first).constData(), &a) == 0
+        && ::stat(QFile::encodeName(second).constData(), &b) == 0
+        && a.st_dev == b.st_dev && a.st_ino == b.st_ino;
+#elif defined(Q_OS_WIN)
+    BY_HANDLE_FILE_INFORMATION info[2];
+    const QString paths[] = { QDir::toNativeSeparators(first), QDir::toNativeSeparators(second) };
+    for (int i = 0; i < 2; ++i)
+    {
+        const HANDLE handle = CreateFileW(reinterpret_cast<LPCWSTR>(paths[i].utf16()), 0,
+            FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, NULL);
+        if (handle == INVALID_HANDLE_VALUE)
+        {
+            return false;
+        }
+        const bool ok = GetFileInformationByHandle(handle, &info[i]) != 0;
+        CloseHandle(handle);
+        if (!ok)
+        {
+            return false;
+        }
+    }
+    return info[0].dwVolumeSerialNumber == info[1].dwVolumeSerialNumber
+        && info[0].nFileIndexHigh == info[1].nFileIndexHigh
+        && info[0].nFileIndexLow == info[1].nFileIndexLow;
+#else
+    Q_UNUSED(first);
+    Q_UNUSED(second);
+    return false;
+#endif
+}
+
+QString FileLinker::methodName(Method method)
+{
+    switch (method)
+    {
+        case Clone:
+            return "cloned";
+        case HardLink:
+            return "hard linked";
+        case KernelCopy:
+            return "copied in kernel";
+        case Copy:
+            return "copied";
+        default:
+            return "failed";
+    }
+}
@@ -0,0 +1,33 @@
+#ifndef FILE_LINKER_H
+#define FILE_LINKER_H
+
+#include <QString>
+
+// Puts a stored document at another path as cheaply as the file system allows.
+// A clone shares blocks copy-on-write and is as safe as a copy. A hard link shares
+// the file itself, so editing the exported file edits the stored document too.
+class FileLinker
+{
+public:
+    enum Method
+    {
+        Failed = 0,
+        Clone, // reflink, no data is copied
+        HardLink, // same volume, no data is copied
+        KernelCopy, // copy_file_range, data doesn't pass through user space
+        Copy,
+    };
+public:
+    // try a clone, a hard link, an in-kernel copy and a plain copy in that order,
+    // an existing target is never replaced
+    static Method place(const QString & source, const QString & target);
+    //
+    static bool hardLink(const QString & source, const QString & target);
+    // true if both paths are links to one file, compares device and inode or their
+    // Windows counterparts, false where they can't be told
+    static bool isSameFile(const QString & first, const QString & second);
+    //
+    static QString methodName(Method method);
+};
+
+#endif // FILE_LINKER_H
@@ -0,0 +1,91 @@
+#include "folderexportjob.h"
+
+#include <QDir>
+#include <QFileInfo>
+
+//=============================================================================
+// class FolderExportJob
+//=============================================================================
+FolderExportJob::FolderExportJob(const QList<DocInfo> & docs, const QString & folderPath, bool singleFolder)
+    : docs_(docs)
+    , folderPath_(folderPath)
+    , singleFolder_(singleFolder)
+    , bytesTotal_(0)
+    , filesCount_(0)
+    , bytesCount_(0)
+    , methodCounts_()
+{
+    for (const DocInfo & info : docs_)
+    {
+        bytesTotal_ += QFileInfo(info.filePath).size();
+    }
+}
+
+FolderExportJob::~FolderExportJob()
+{
+    wait();
+}
+
+void FolderExportJob::run()
+{
+    QDir folder(folderPath_);
+    if (!folder.mkpath("."))
+    {
+        failures_.append(QString("%1: can't create the folder").arg(folderPath_));
+        return;
+    }
+    int i = 0;
+    for (const DocInfo & info : docs_)
+    {
+        if (isCancelled())
+        {
+            break;
+        }
+        const QString number = QString::number(++i);
+        QString targetPath;
+        if (singleFolder_)
+        {
+            targetPath = folder.filePath(number + "-" + info.fileName);
+        }
+        else
+        {
+            folder.mkdir(number);
+            targetPath = folder.filePath(number + "/" + info.fileName);
+        }
+        const FileLinker::Method method = FileLinker::place(info.filePath, targetPath);
+        if (method == FileLinker::Failed)
+        {
+            failures_.append(QString("%1: can't be placed at %2").arg(info.filePath, targetPath));
+            continue;
+        }
+        ++methodCounts_[method];
+        ++filesCount_;
+        bytesCount_ += QFileInfo(targetPath).size();
+    }
+}
+
+QString FolderExportJob::finish(SaveData * /*save*/)
+{
+    QStringList methods;
+    for (int method = FileLinker::Clone; method <= FileLinker::Copy; ++method)
+    {
+        if (methodCounts_[method] > 0)
+        {
+            methods.append(QString("%1 %2").arg(methodCounts_[method]).arg(FileLinker::methodName(static_cast<FileLinker::Method>(method))));
+        }
+    }
+    QString message = QString("Exported %1 files to %2").arg(filesCount_.load()).arg(folderPath_);
+    if (!methods.isEmpty())
+    {
+        message.append(": ").append(methods.join(", "));
+    }
+    if (!failures_.isEmpty())
+    {
+        message.append(QString(", %1 failed").arg(failures_.size()));
+    }
+    if (isCancelled())
+    {
+        message.prepend("Folder export cancelled. ");
+    }
+    return message;
+}
@@ -0,0 +1,44 @@
+#ifndef FOLDER_EXPORT_JOB_H
+#define FOLDER_EXPORT_JOB_H
+
+#include "backgroundjob.h"
+#include "docinfo.h"
+#include "filelinker.h"
+
+// Materializes search results in a folder with links or clones instead of a zip,
+// entries are named like in the archive: "<n>-<name>" or "<n>/<name>".
+class FolderExportJob : public BackgroundJob
+{
+private:
+    QList<DocInfo> docs_; // search results to export
+    QString folderPath_;
+    bool singleFolder_;
+    qint64 bytesTotal_;
+    std::atomic<qint64> filesCount_;
+    std::atomic<qint64> bytesCount_;
+    qint64 methodCounts_[FileLinker::Copy + 1]; // files placed by each method
+protected:
+    //
+    virtual void run() override;
+public:
+    //
+    FolderExportJob(const QList<DocInfo> & docs, const QString & folderPath, bool singleFolder);
+    //
+    virtual ~FolderExportJob();
+    //
+    virtual Type type() const override { return Type::Export; }
+    //
+    virtual QString title() const override { return "Folder export"; }
+    //
+    virtual qint64 filesDone() const override { return filesCount_; }
+    //
+    virtual qint64 filesTotal() const override { return docs_.size(); }
+    //
+    virtual qint64 bytesDone() const override { return bytesCount_; }
+    //
+    virtual qint64 bytesTotal() const override { return bytesTotal_; }
+    //
+    virtual QString finish(SaveData * save) override;
+};
+
+#endif // FOLDER_EXPORT_JOB_H
@@ -0,0 +1,452 @@
+#include "fulltextindex.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+
+#include <algorithm>
+#include <string.h>
+
+namespace
+{
+    const int kShardCount = 256;
+    const int kMinTermLength = 2;
+    const int kMaxTermLength = 64;
+    const qint64 kMaxPendingBytes = 4 * 1024 * 1024;
+    // a tail is merged once it passes this size and an eighth of its shard
+    const qint64 kMinTailBytes = 256 * 1024;
+    const int kTailFraction = 8;
+    // removed documents that make the whole index due for compaction
+    const int kCompactAfterRemovals = 256;
+    const QString kRemovedFile = "removed.lst";
+
+    inline bool isWordChar(uchar c)
+    {
+        return c >= 0x80 || (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+    }
+
+    // byte order, the order shards are sorted in
+    inline bool lineLess(const char * line, qint64 size, const QByteArray & key)
+    {
+        const int result = memcmp(line, key.constData(), size_t(qMin<qint64>(size, key.size())));
+        return result < 0 || (result == 0 && size < key.size());
+    }
+
+    // adds the md5 of every posting of the term in sorted shard data
+    void findSorted(const char * data, qint64 size, const QByteArray & prefix, QSet<QString> & docs)
+    {
+        // find the first line that doesn't sort before the prefix, lo is always a line start
+        qint64 lo = 0;
+        qint64 hi = size;
+        while (lo < hi)
+        {
+            qint64 mid = lo + (hi - lo) / 2;
+            while (mid > lo && data[mid - 1] != '\n')
+            {
+                --mid;
+            }
+            const char * end = static_cast<const char *>(memchr(data + mid, '\n', size_t(size - mid)));
+            const qint64 lineEnd = end ? end - data : size;
+            if (lineLess(data + mid, lineEnd - mid, prefix))
+            {
+                lo = lineEnd + 1;
+            }
+            else
+            {
+                hi = mid;
+            }
+        }
+        // postings of one term follow each other
+        while (lo < size)
+        {
+            const char * end = static_cast<const char *>(memchr(data + lo, '\n', size_t(size - lo)));
+            const qint64 lineEnd = end ? end - data : size;
+            const QByteArray line = QByteArray::fromRawData(data + lo, int(lineEnd - lo));
+            if (!line.startsWith(prefix))
+            {
+                break;
+            }
+            docs.insert(QString::fromLatin1(line.mid(prefix.size()).trimmed()));
+            lo = lineEnd + 1;
+        }
+    }
+
+    void appendLines(const QByteArray & data, QVector<QByteArray> & lines)
+    {
+        for (const QByteArray & line : data.split('\n'))
+        {
+            if (!line.isEmpty())
+            {
+                lines.append(line);
+            }
+        }
+    }
+}
+
+//=============================================================================
+// class TextTokenizer
+//=============================================================================
+TextTokenizer::TextTokenizer(bool skipMarkup, int maxTerms)
+    : maxTerms_(maxTerms)
+    , skipMarkup_(skipMarkup)
+    , inMarkup_(false)
+{
+    token_.reserve(kMaxTermLength);
+}
+
+void TextTokenizer::feed(const char * data, qint64 size)
+{
+    for (qint64 i = 0; i < size; ++i)
+    {
+        const uchar c = uchar(data[i]);
+        if (skipMarkup_)
+        {
+            if (inMarkup_)
+            {
+                inMarkup_ = c != '>';
+                continue;
+            }
+            if (c == '<')
+            {
+                flushToken();
+                inMarkup_ = true;
+                continue;
+            }
+        }
+        if (isWordChar(c))
+        {
+            if (token_.size() < kMaxTermLength)
+            {
+                token_.append(char((c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c));
+            }
+        }
+        else if (!token_.isEmpty())
+        {
+            flushToken();
+        }
+    }
+}
+
+void TextTokenizer::flushToken()
+{
+    if (token_.size() >= kMinTermLength && terms_.size() < maxTerms_)
+    {
+        terms_.insert(token_);
+    }
+    token_.clear();
+}
+
+void TextTokenizer::finish()
+{
+    flushToken();
+    inMarkup_ = false;
+}
+
+void TextTokenizer::clear()
+{
+    token_.clear();
+    terms_.clear();
+    inMarkup_ = false;
+}
+
+//=============================================================================
+// class FullTextIndex
+//=============================================================================
+FullTextIndex::FullTextIndex(const QString & folderPath)
+    : folderPath_(folderPath)
+    , pending_(kShardCount)
+    , pendingBytes_(0)
+    , isRemovedLoaded_(false)
+{
+}
+
+FullTextIndex::~FullTextIndex()
+{
+    flush();
+}
+
+int FullTextIndex::shardOf(const QByteArray & term)
+{
+    // FNV-1a, the shard of a term must not change between runs or Qt versions
+    quint32 hash = 2166136261u;
+    for (char c : term)
+    {
+        hash ^= uchar(c);
+        hash *= 16777619u;
+    }
+    return hash % kShardCount;
+}
+
+QString FullTextIndex::shardPath(int shard) const
+{
+    return QDir(folderPath_).filePath(QString("%1.sorted").arg(shard, 2, 16, QChar('0')));
+}
+
+QString FullTextIndex::tailPath(int shard) const
+{
+    // the name shards had before they were sorted, an old index is all tails
+    return QDir(folderPath_).filePath(QString("%1.idx").arg(shard, 2, 16, QChar('0')));
+}
+
+QString FullTextIndex::removedPath() const
+{
+    return QDir(folderPath_).filePath(kRemovedFile);
+}
+
+QSet<QByteArray> FullTextIndex::readRemoved() const
+{
+    QSet<QByteArray> removed;
+    QFile file(removedPath());
+    if (file.open(QIODevice::ReadOnly))
+    {
+        for (const QByteArray & line : file.readAll().split('\n'))
+        {
+            if (!line.trimmed().isEmpty())
+            {
+                removed.insert(line.trimmed());
+            }
+        }
+    }
+    return removed;
+}
+
+void FullTextIndex::loadRemoved()
+{
+    if (!isRemovedLoaded_)
+    {
+        removed_ = readRemoved();
+        isRemovedLoaded_ = true;
+    }
+}
+
+void FullTextIndex::addDocument(const QString & md5, const QSet<QByteArray> & terms)
+{
+    const QByteArray id = md5.toLatin1();
+    loadRemoved();
+    if (removed_.remove(id))
+    {
+        // the same content is back, its old postings are valid again
+        QSaveFile file(removedPath());
+        if (file.open(QIODevice::WriteOnly))
+        {
+            for (const QByteArray & removed : removed_)
+            {
+                file.write(removed + '\n');
+            }
+            file.commit();
+        }
+    }
+    for (const QByteArray & term : terms)
+    {
+        QByteArray & shard = pending_[shardOf(term)];
+        shard.append(term).append('\t').append(id).append('\n');
+        pendingBytes_ += term.size() + id.size() + 2;
+    }
+    if (pendingBytes_ >= kMaxPendingBytes)
+    {
+        flush();
+    }
+}
+
+void FullTextIndex::flush()
+{
+    if (pendingBytes_ == 0)
+    {
+        return;
+    }
+    if (!QDir(folderPath_).exists())
+    {
+        QDir().mkpath(folderPath_);
+    }
+    for (int shard = 0; shard < kShardCount; ++shard)
+    {
+        QByteArray & postings = pending_[shard];
+        if (postings.isEmpty())
+        {
+            continue;
+        }
+        QFile file(tailPath(shard));
+        if (file.open(QIODevice::WriteOnly | QIODevice::Append))
+        {
+            file.write(postings);
+            file.close();
+        }
+        postings.clear();
+        const qint64 tailSize = QFileInfo(tailPath(shard)).size();
+        if (tailSize >= kMinTailBytes && tailSize * kTailFraction >= QFileInfo(shardPath(shard)).size())
+        {
+            compactShard(shard);
+        }
+    }
+    pendingBytes_ = 0;
+}
+
+bool FullTextIndex::compactShard(int shard)
+{
+    loadRemoved();
+    // taken aside first, postings another index object appends meanwhile start a new tail
+    const QString mergingPath = tailPath(shard) + ".merging";
+    if (!QFile::exists(mergingPath) && QFile::exists(tailPath(shard)) && !QFile::rename(tailPath(shard), mergingPath))
+    {
+        return false;
+    }
+    QVector<QByteArray> lines;
+    QFile shardFile(shardPath(shard));
+    if (shardFile.open(QIODevice::ReadOnly))
+    {
+        appendLines(shardFile.readAll(), lines);
+        shardFile.close();
+    }
+    QFile merging(mergingPath);
+    if (merging.open(QIODevice::ReadOnly))
+    {
+        appendLines(merging.readAll(), lines);
+        merging.close();
+    }
+    std::sort(lines.begin(), lines.end());
+    lines.erase(std::unique(lines.begin(), lines.end()), lines.end());
+
+    QSaveFile file(shardPath(shard));
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        return false;
+    }
+    for (const QByteArray & line : lines)
+    {
+        const int tab = line.indexOf('\t');
+        if (tab < 0 || removed_.contains(line.mid(tab + 1)))
+        {
+            continue;
+        }
+        file.write(line);
+        file.write("\n", 1);
+    }
+    if (!file.commit())
+    {
+        return false;
+    }
+    QFile::remove(mergingPath);
+    return true;
+}
+
+void FullTextIndex::removeDocument(const QString & md5)
+{
+    loadRemoved();
+    const QByteArray id = md5.toLatin1();
+    if (removed_.contains(id))
+    {
+        return;
+    }
+    removed_.insert(id);
+    if (!QDir(folderPath_).exists())
+    {
+        return;
+    }
+    QFile file(removedPath());
+    if (file.open(QIODevice::WriteOnly | QIODevice::Append))
+    {
+        file.write(id + '\n');
+        file.close();
+    }
+}
+
+bool FullTextIndex::isCompactionDue()
+{
+    // another instance may have appended to the list since it was loaded
+    removed_ = readRemoved();
+    isRemovedLoaded_ = true;
+    return removed_.size() >= kCompactAfterRemovals;
+}
+
+void FullTextIndex::compact()
+{
+    flush();
+    if (!QDir(folderPath_).exists())
+    {
+        return;
+    }
+    bool isComplete = true;
+    for (int shard = 0; shard < kShardCount; ++shard)
+    {
+        if (QFile::exists(shardPath(shard)) || QFile::exists(tailPath(shard)))
+        {
+            isComplete = compactShard(shard) && isComplete;
+        }
+    }
+    // the list is needed until no shard has postings of removed documents left
+    if (isComplete)
+    {
+        QFile::remove(removedPath());
+        removed_.clear();
+    }
+}
+
+QSet<QString> FullTextIndex::findTerm(const QByteArray & term) const
+{
+    QSet<QString> docs;
+    const QByteArray prefix = QByteArray(term).append('\t');
+    QFile file(shardPath(shardOf(term)));
+    if (file.open(QIODevice::ReadOnly) && file.size() > 0)
+    {
+        const uchar * mapped = file.map(0, file.size());
+        if (mapped)
+        {
+            findSorted(reinterpret_cast<const char *>(mapped), file.size(), prefix, docs);
+            file.unmap(const_cast<uchar *>(mapped));
+        }
+        else
+        {
+            const QByteArray data = file.readAll();
+            findSorted(data.constData(), data.size(), prefix, docs);
+        }
+        file.close();
+    }
+    // the tail is small, it's scanned
+    QFile tail(tailPath(shardOf(term)));
+    if (tail.open(QIODevice::ReadOnly))
+    {
+        while (!tail.atEnd())
+        {
+            const QByteArray line = tail.readLine();
+            if (line.startsWith(prefix))
+            {
+                docs.insert(QString::fromLatin1(line.mid(prefix.size()).trimmed()));
+            }
+        }
+        tail.close();
+    }
+    return docs;
+}
+
+QSet<QString> FullTextIndex::find(const QString & text) const
+{
+    TextTokenizer tokenizer;
+    const QByteArray data = text.toUtf8();
+    tokenizer.feed(data.constData(), data.size());
+    tokenizer.finish();
+
+    QSet<QString> docs;
+    bool isFirst = true;
+    for (const QByteArray & term : tokenizer.terms())
+    {
+        if (isFirst)
+        {
+            docs = findTerm(term);
+            isFirst = false;
+        }
+        else
+        {
+            docs.intersect(findTerm(term));
+        }
+        if (docs.isEmpty())
+        {
+            break;
+        }
+    }
+    for (const QByteArray & removed : readRemoved())
+    {
+        docs.remove(QString::fromLatin1(removed));
+    }
+    return docs;
+}
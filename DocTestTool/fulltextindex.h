@@ -0,0 +1,85 @@
+#ifndef FULL_TEXT_INDEX_H
+#define FULL_TEXT_INDEX_H
+
+#include <QStringList>
+#include <QVector>
+#include <QSet>
+
+// Splits streamed text into lower case terms, keeps at most maxTerms distinct terms
+// so memory stays bounded whatever the document size is.
+class TextTokenizer
+{
+private:
+    QByteArray token_; // term that may continue in the next chunk
+    QSet<QByteArray> terms_;
+    int maxTerms_;
+    bool skipMarkup_; // ignore everything between '<' and '>'
+    bool inMarkup_;
+private:
+    //
+    void flushToken();
+public:
+    //
+    TextTokenizer(bool skipMarkup = false, int maxTerms = 100000);
+    //
+    void feed(const char * data, qint64 size);
+    // must be called after the last chunk
+    void finish();
+    //
+    const QSet<QByteArray> & terms() const { return terms_; }
+    //
+    void clear();
+};
+
+// Inverted index kept in the working folder. Postings are spread over 256 shard
+// files by term hash, one "term<TAB>md5" line each, so a lookup reads one shard only.
+// A shard is kept sorted and binary searched, new postings go to a small unsorted tail
+// next to it that is merged in once it grows. Removed documents are listed until a
+// compaction drops their postings.
+class FullTextIndex
+{
+private:
+    QString folderPath_;
+    QVector<QByteArray> pending_; // postings waiting to be appended to their shard tails
+    qint64 pendingBytes_;
+    QSet<QByteArray> removed_; // md5 of removed documents, loaded on first use
+    bool isRemovedLoaded_;
+private:
+    //
+    static int shardOf(const QByteArray & term);
+    //
+    QString shardPath(int shard) const;
+    // unsorted postings not merged into the shard yet
+    QString tailPath(int shard) const;
+    //
+    QString removedPath() const;
+    //
+    QSet<QByteArray> readRemoved() const;
+    //
+    void loadRemoved();
+    // merge the tail into the sorted shard, dropping postings of removed documents
+    bool compactShard(int shard);
+    //
+    QSet<QString> findTerm(const QByteArray & term) const;
+public:
+    //
+    FullTextIndex(const QString & folderPath);
+    //
+    ~FullTextIndex();
+    //
+    void addDocument(const QString & md5, const QSet<QByteArray> & terms);
+    // the document is no longer found, its postings go with the next compaction;
+    // only appends to the removed list, so it's cheap enough for the GUI thread
+    void removeDocument(const QString & md5);
+    // enough documents were removed to make compact() worth it
+    bool isCompactionDue();
+    // write pending postings to disk
+    void flush();
+    // merge all tails and drop the postings of removed documents, rewrites every
+    // shard so it's run from a worker thread
+    void compact();
+    // md5 of documents that contain all words of the text
+    QSet<QString> find(const QString & text) const;
+};
+
+#endif // FULL_TEXT_INDEX_H
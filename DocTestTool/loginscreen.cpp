@@ -2,6 +2,7 @@
 
 #include <QDir>
 
+#include "mirrorjob.h"
 #include "savedata.h"
 
 //=============================================================================
@@ -58,6 +59,14 @@ void LoginScreen::login()
         save_->loadConfig();
         save_->loadFilesData();
 
+        const TagMirror mirror = save_->getTagMirror();
+        if (mirror.needsRebuild())
+        {
+            MirrorJob * job = new MirrorJob(mirror, save_->folderDocsData);
+            save_->jobs.append(job);
+            job->start();
+        }
+
         ui_->backBtn->click();
     }
 }
\ No newline at end of file
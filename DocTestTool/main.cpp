@@ -1,8 +1,239 @@
 #include "doctesttool.h"
 #include <QtWidgets/QApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+#include <QTextStream>
+
+#ifdef Q_OS_WIN
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+#include "constants.h"
+#include "docexporter.h"
+#include "docinfo.h"
+#include "savedata.h"
+#include "tarexporter.h"
+
+namespace
+{
+    const QString kExportOption = "--export";
+    const QString kBenchmarkOption = "--benchmark";
+    const double kMegabyte = 1024.0 * 1024.0;
+
+    // load the catalog of a database folder given on the command line
+    bool loadDatabase(const QString & folder, SaveData & save, QTextStream & err)
+    {
+        save.workingFolder = QDir(folder).absolutePath();
+        if (save.getDocsFilePath().isEmpty() || !QDir(save.getDocsFilePath()).exists())
+        {
+            err << "no documents in " << save.workingFolder << endl;
+            return false;
+        }
+        save.loadConfig();
+        save.loadFilesData();
+        return true;
+    }
+
+    // documents that have all the comma separated tags
+    QList<DocInfo> taggedDocuments(const SaveData & save, const QString & tagList)
+    {
+        QStringList tags = tagList.split(',', QString::SkipEmptyParts);
+        for (QString & tag : tags)
+        {
+            tag = tag.trimmed();
+        }
+        QList<DocInfo> docs;
+        for (const DocInfo & info : save.folderDocsData)
+        {
+            bool hasTags = true;
+            for (const QString & tag : tags)
+            {
+                if (!info.tags.contains(tag))
+                {
+                    hasTags = false;
+                    break;
+                }
+            }
+            if (hasTags)
+            {
+                docs.append(info);
+            }
+        }
+        return docs;
+    }
+
+    // works with every exporter, they share open, addDocument and close
+    template <typename Exporter>
+    bool exportAll(Exporter & exporter, const QList<DocInfo> & docs)
+    {
+        if (!exporter.open())
+        {
+            return false;
+        }
+        for (const DocInfo & info : docs)
+        {
+            exporter.addDocument(info);
+        }
+        return exporter.close();
+    }
+
+    template <typename Exporter>
+    int reportExport(const Exporter & exporter, bool exported, QTextStream & err)
+    {
+        err << exporter.statsMessage() << endl;
+        for (const QString & failure : exporter.failures())
+        {
+            err << failure << endl;
+        }
+        return exported && exporter.failures().isEmpty() ? 0 : 1;
+    }
+
+    // DocTestTool --export <database folder> <tag,tag> <archive|->
+    // zips documents that have all the tags without opening the window, "-" streams
+    // the archive to stdout so it can be piped into another tool, an archive named
+    // .tar.zst is written as tar+zstd when that's compiled in
+    int exportDocuments(const QStringList & args)
+    {
+        QTextStream err(stderr);
+        if (args.size() != 5)
+        {
+            err << "usage: DocTestTool " << kExportOption << " <database folder> <tag,tag> <archive|->" << endl;
+            return 2;
+        }
+        SaveData save;
+        if (!loadDatabase(args[2], save, err))
+        {
+            return 1;
+        }
+        const QList<DocInfo> docs = taggedDocuments(save, args[3]);
+
+#ifdef HAVE_ZSTD
+        if (args[4].endsWith(".tar.zst"))
+        {
+            TarExporter exporter(args[4], false);
+            const bool exported = exportAll(exporter, docs);
+            return reportExport(exporter, exported, err);
+        }
+#endif
+
+        QFile out;
+        bool opened = false;
+        if (args[4] == "-")
+        {
+#ifdef Q_OS_WIN
+            _setmode(_fileno(stdout), _O_BINARY);
+#endif
+            opened = out.open(stdout, QIODevice::WriteOnly);
+        }
+        else
+        {
+            out.setFileName(args[4]);
+            opened = out.open(QIODevice::WriteOnly);
+        }
+        if (!opened)
+        {
+            err << "can't write " << args[4] << ": " << out.errorString() << endl;
+            return 1;
+        }
+
+        DocExporter exporter(&save, &out, false);
+        const bool exported = exportAll(exporter, docs);
+        out.close();
+        return reportExport(exporter, exported, err);
+    }
+
+    // one line of the benchmark table
+    void printResult(QTextStream & out, const QString & format, bool exported, qint64 ms, qint64 inputSize, const QString & archivePath)
+    {
+        const qint64 archiveSize = QFileInfo(archivePath).size();
+        out << QString("%1 %2 %3 %4 %5")
+            .arg(format, -10)
+            .arg(ms / 1000.0, 9, 'f', 2)
+            .arg(ms > 0 ? inputSize / kMegabyte * 1000.0 / ms : 0.0, 9, 'f', 1)
+            .arg(archiveSize / kMegabyte, 11, 'f', 1)
+            .arg(archiveSize > 0 ? double(inputSize) / archiveSize : 0.0, 7, 'f', 2);
+        if (!exported)
+        {
+            out << "  (failed)";
+        }
+        out << endl;
+    }
+
+    // DocTestTool --benchmark <database folder> <tag,tag>
+    // exports the documents once in every format to a temporary folder and compares
+    // time and archive size, nothing is kept
+    int benchmarkFormats(const QStringList & args)
+    {
+        QTextStream err(stderr);
+        if (args.size() != 4)
+        {
+            err << "usage: DocTestTool " << kBenchmarkOption << " <database folder> <tag,tag>" << endl;
+            return 2;
+        }
+        SaveData save;
+        if (!loadDatabase(args[2], save, err))
+        {
+            return 1;
+        }
+        // the zip path must deflate everything to be comparable
+        save.deflateCacheMegabytes = 0;
+        const QList<DocInfo> docs = taggedDocuments(save, args[3]);
+        qint64 inputSize = 0;
+        for (const DocInfo & info : docs)
+        {
+            inputSize += QFileInfo(info.filePath).size();
+        }
+        QTemporaryDir folder;
+        if (!folder.isValid())
+        {
+            err << "can't create a temporary folder" << endl;
+            return 1;
+        }
+
+        QTextStream out(stdout);
+        out << docs.size() << " documents, " << QString::number(inputSize / kMegabyte, 'f', 1) << " MB" << endl;
+        out << "format       seconds      MB/s  archive MB   ratio" << endl;
+        QElapsedTimer timer;
+        bool succeeded = true;
+        {
+            const QString archivePath = folder.filePath("documents.zip");
+            timer.start();
+            DocExporter exporter(&save, archivePath, false);
+            const bool exported = exportAll(exporter, docs);
+            printResult(out, "zip", exported, timer.elapsed(), inputSize, archivePath);
+            succeeded = succeeded && exported;
+        }
+#ifdef HAVE_ZSTD
+        {
+            const QString archivePath = folder.filePath("documents.tar.zst");
+            timer.start();
+            TarExporter exporter(archivePath, false);
+            const bool exported = exportAll(exporter, docs);
+            printResult(out, "tar.zst", exported, timer.elapsed(), inputSize, archivePath);
+            succeeded = succeeded && exported;
+        }
+#endif
+        return succeeded ? 0 : 1;
+    }
+}
 
 int main(int argc, char *argv[])
 {
+    if (argc > 1 && kExportOption == argv[1])
+    {
+        QCoreApplication a(argc, argv);
+        return exportDocuments(a.arguments());
+    }
+    if (argc > 1 && kBenchmarkOption == argv[1])
+    {
+        QCoreApplication a(argc, argv);
+        return benchmarkFormats(a.arguments());
+    }
+
     QApplication a(argc, argv);
 
     DocTestTool w;
@@ -0,0 +1,35 @@
+#include "mirrorjob.h"
+
+//=============================================================================
+// class MirrorJob
+//=============================================================================
+MirrorJob::MirrorJob(const TagMirror & mirror, const QList<DocInfo> & docs)
+    : mirror_(mirror)
+    , docs_(docs)
+    , filesCount_(0)
+    , succeeded_(false)
+{
+}
+
+MirrorJob::~MirrorJob()
+{
+    wait();
+}
+
+void MirrorJob::run()
+{
+    succeeded_ = mirror_.rebuild(docs_, &cancelled_, &filesCount_);
+    if (!succeeded_ && !isCancelled())
+    {
+        failures_.append("some documents could not be linked into the by-tag folder");
+    }
+}
+
+QString MirrorJob::finish(SaveData * /*save*/)
+{
+    if (isCancelled())
+    {
+        return "Tag mirror cancelled, it's rebuilt on the next login.";
+    }
+    return QString("Tag mirror rebuilt for %1 documents").arg(filesCount_.load());
+}
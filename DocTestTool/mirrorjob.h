@@ -0,0 +1,41 @@
+#ifndef MIRROR_JOB_H
+#define MIRROR_JOB_H
+
+#include "backgroundjob.h"
+#include "docinfo.h"
+#include "tagmirror.h"
+
+// Builds the by-tag folder from scratch, after that it's kept up to date as documents
+// are uploaded and deleted.
+class MirrorJob : public BackgroundJob
+{
+private:
+    TagMirror mirror_;
+    QList<DocInfo> docs_; // whole catalog
+    std::atomic<qint64> filesCount_;
+    bool succeeded_;
+protected:
+    //
+    virtual void run() override;
+public:
+    //
+    MirrorJob(const TagMirror & mirror, const QList<DocInfo> & docs);
+    //
+    virtual ~MirrorJob();
+    //
+    virtual Type type() const override { return Type::Mirror; }
+    //
+    virtual QString title() const override { return "Tag mirror"; }
+    //
+    virtual qint64 filesDone() const override { return filesCount_; }
+    //
+    virtual qint64 filesTotal() const override { return docs_.size(); }
+    //
+    virtual qint64 bytesDone() const override { return 0; }
+    //
+    virtual qint64 bytesTotal() const override { return 0; }
+    //
+    virtual QString finish(SaveData * save) override;
+};
+
+#endif // MIRROR_JOB_H
@@ -24,13 +24,31 @@ see quazip/(un)zip.h files for details. Basically it's the zlib license.
 */
 
 #include "JlCompress.h"
+#include "checksum.h"
+#include "quazipsharedarchive.h"
+#include "quazipsharedfile.h"
 #include <QDebug>
+#include <QHash>
+#include <QMutex>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QSet>
+#include <QSharedPointer>
+#include <QTemporaryFile>
+#include <QThread>
+#include <QThreadPool>
+#include <QVector>
+#include <QWaitCondition>
+
+#include <zlib.h>
+
+#include <string.h>
 
 static bool copyData(QIODevice &inFile, QIODevice &outFile)
 {
     while (!inFile.atEnd()) {
-        char buf[4096];
-        qint64 readLen = inFile.read(buf, 4096);
+        char buf[64 * 1024];
+        qint64 readLen = inFile.read(buf, sizeof(buf));
         if (readLen <= 0)
             return false;
         if (outFile.write(buf, readLen) != readLen)
@@ -441,3 +459,409 @@ QStringList JlCompress::extractFiles(QIODevice *ioDevice, QStringList files, QSt
     QuaZip zip(ioDevice);
     return extractFiles(zip, files, dir);
 } 
+
+/// \cond internal
+static int jlWorkerCount(int threads)
+{
+    if (threads <= 0)
+        threads = QThread::idealThreadCount();
+    return qMax(threads, 1);
+}
+
+// State shared by the extraction workers.
+struct JlExtractTask {
+    const QuaZipSharedArchive *archive;
+    const QList<int> *entries;
+    const QStringList *destinations;
+    const QList<int> *work; // the positions in entries to extract
+    QAtomicInt next; // the first position in work nobody has taken yet
+    QAtomicInt failed;
+    char *extracted; // set by the worker that took the entry
+};
+
+static bool extractSharedEntry(const QuaZipSharedArchive &archive, int index,
+                               const QString &fileDest)
+{
+    QFile::Permissions srcPerm = archive.getFileInfo(index).getPermissions();
+    if (fileDest.endsWith('/')) {
+        // the directory was created before the workers started
+        if (srcPerm != 0) {
+            QFile(fileDest).setPermissions(srcPerm);
+        }
+        return true;
+    }
+    QuaZipSharedFile inFile(&archive, index);
+    if (!inFile.open(QIODevice::ReadOnly))
+        return false;
+    QFile outFile(fileDest);
+    if (!outFile.open(QIODevice::WriteOnly))
+        return false;
+    if (!copyData(inFile, outFile) || inFile.getZipError() != UNZ_OK) {
+        outFile.close();
+        QFile::remove(fileDest);
+        return false;
+    }
+    outFile.close();
+    inFile.close();
+    if (inFile.getZipError() != UNZ_OK) {
+        QFile::remove(fileDest);
+        return false;
+    }
+    if (srcPerm != 0) {
+        outFile.setPermissions(srcPerm);
+    }
+    return true;
+}
+
+class JlExtractWorker: public QRunnable {
+public:
+    explicit JlExtractWorker(JlExtractTask *task): task(task) {}
+    void run()
+    {
+        for (;;) {
+            const int next = task->next.fetchAndAddOrdered(1);
+            if (next >= task->work->size() || task->failed.load() != 0)
+                return;
+            const int i = task->work->at(next);
+            if (!extractSharedEntry(*task->archive, task->entries->at(i),
+                                    task->destinations->at(i))) {
+                task->failed.store(1);
+                return;
+            }
+            task->extracted[i] = 1;
+        }
+    }
+private:
+    JlExtractTask *task;
+};
+
+// Deflated data kept in memory, more goes to a temporary file, so that
+// the entries waiting for the writer take a bounded amount of memory.
+static const int JL_COMPRESS_MEMORY_MAX = 8 * 1024 * 1024;
+
+// A file or a directory to add to the archive, with its deflated data.
+struct JlCompressEntry {
+    JlCompressEntry(): isDir(false), crc(0), size(0), ok(false), done(false) {}
+    QString source;
+    QString name;
+    bool isDir;
+    QByteArray data;
+    QSharedPointer<QTemporaryFile> spill; // the data once it outgrows memory
+    quint32 crc;
+    qint64 size;
+    bool ok;
+    bool done;
+};
+
+// State shared by the compression workers and the writer.
+struct JlCompressTask {
+    JlCompressEntry *entries; // not resized while the workers run
+    int count;
+    QAtomicInt next;
+    QAtomicInt failed;
+    QSemaphore window; // entries taken by workers but not written yet
+    QMutex mutex;
+    QWaitCondition entryDone;
+};
+
+static bool keepDeflated(JlCompressEntry &entry, const char *data, int size)
+{
+    if (entry.spill.isNull()
+            && entry.data.size() + size <= JL_COMPRESS_MEMORY_MAX) {
+        // append() grows the buffer geometrically
+        entry.data.append(data, size);
+        return true;
+    }
+    if (entry.spill.isNull()) {
+        entry.spill = QSharedPointer<QTemporaryFile>(new QTemporaryFile());
+        if (!entry.spill->open()
+                || entry.spill->write(entry.data) != entry.data.size())
+            return false;
+        entry.data = QByteArray();
+    }
+    return entry.spill->write(data, size) == size;
+}
+
+static bool deflateEntry(JlCompressEntry &entry)
+{
+    QFile inFile(entry.source);
+    if (!inFile.open(QIODevice::ReadOnly))
+        return false;
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    // the parameters QuaZipFile uses for a new file
+    if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS,
+                     8, Z_DEFAULT_STRATEGY) != Z_OK)
+        return false;
+    const int chunk = 64 * 1024;
+    char buf[chunk];
+    char out[chunk];
+    entry.crc = crc32(0L, Z_NULL, 0);
+    entry.size = 0;
+    bool ok = true;
+    int flush = Z_NO_FLUSH;
+    do {
+        const qint64 readLen = inFile.read(buf, chunk);
+        if (readLen < 0) {
+            ok = false;
+            break;
+        }
+        entry.crc = quazip_crc32(entry.crc, reinterpret_cast<const unsigned char*>(buf),
+                                 static_cast<size_t>(readLen));
+        entry.size += readLen;
+        flush = readLen == 0 || inFile.atEnd() ? Z_FINISH : Z_NO_FLUSH;
+        stream.next_in = reinterpret_cast<Bytef*>(buf);
+        stream.avail_in = static_cast<uInt>(readLen);
+        do {
+            stream.next_out = reinterpret_cast<Bytef*>(out);
+            stream.avail_out = chunk;
+            deflate(&stream, flush);
+            if (!keepDeflated(entry, out, chunk - stream.avail_out)) {
+                ok = false;
+                break;
+            }
+        } while (stream.avail_out == 0);
+    } while (ok && flush != Z_FINISH);
+    deflateEnd(&stream);
+    return ok;
+}
+
+class JlCompressWorker: public QRunnable {
+public:
+    explicit JlCompressWorker(JlCompressTask *task): task(task) {}
+    void run()
+    {
+        for (;;) {
+            task->window.acquire();
+            const int i = task->next.fetchAndAddOrdered(1);
+            if (i >= task->count || task->failed.load() != 0) {
+                task->window.release();
+                return;
+            }
+            JlCompressEntry &entry = task->entries[i];
+            const bool ok = entry.isDir || deflateEntry(entry);
+            QMutexLocker locker(&task->mutex);
+            entry.ok = ok;
+            entry.done = true;
+            task->entryDone.wakeAll();
+        }
+    }
+private:
+    JlCompressTask *task;
+};
+
+// Lists what compressSubDir() would add, in the same order.
+static bool collectSubDir(QVector<JlCompressEntry> &entries, const QString &dir,
+                          const QString &origDir, bool recursive,
+                          QDir::Filters filters, const QString &zipName)
+{
+    QDir directory(dir);
+    if (!directory.exists()) return false;
+    QDir origDirectory(origDir);
+    if (dir != origDir) {
+        JlCompressEntry entry;
+        entry.source = dir;
+        entry.name = origDirectory.relativeFilePath(dir) + "/";
+        entry.isDir = true;
+        entries.append(entry);
+    }
+    if (recursive) {
+        QFileInfoList files = directory.entryInfoList(QDir::AllDirs|QDir::NoDotAndDotDot|filters);
+        Q_FOREACH (QFileInfo file, files) {
+            if (!collectSubDir(entries, file.absoluteFilePath(), origDir,
+                               recursive, filters, zipName))
+                return false;
+        }
+    }
+    QFileInfoList files = directory.entryInfoList(QDir::Files|filters);
+    Q_FOREACH (QFileInfo file, files) {
+        if (!file.isFile() || file.absoluteFilePath() == zipName) continue;
+        JlCompressEntry entry;
+        entry.source = file.absoluteFilePath();
+        entry.name = origDirectory.relativeFilePath(file.absoluteFilePath());
+        entries.append(entry);
+    }
+    return true;
+}
+/// \endcond
+
+bool JlCompress::compressDirParallel(QString fileCompressed, QString dir,
+                                     bool recursive, QDir::Filters filters,
+                                     int threads)
+{
+    QVector<JlCompressEntry> entries;
+    if (!collectSubDir(entries, dir, dir, recursive, filters,
+                       QFileInfo(fileCompressed).absoluteFilePath()))
+        return false;
+
+    QuaZip zip(fileCompressed);
+    QDir().mkpath(QFileInfo(fileCompressed).absolutePath());
+    if(!zip.open(QuaZip::mdCreate)) {
+        QFile::remove(fileCompressed);
+        return false;
+    }
+
+    const int workers = jlWorkerCount(threads);
+    JlCompressTask task;
+    task.entries = entries.data();
+    task.count = entries.size();
+    task.window.release(2 * workers);
+    QThreadPool pool;
+    pool.setMaxThreadCount(workers);
+    for (int i = 0; i < workers; ++i)
+        pool.start(new JlCompressWorker(&task));
+
+    // append in order, whatever order the workers finish in
+    bool ok = true;
+    for (int i = 0; i < task.count && ok; ++i) {
+        JlCompressEntry &entry = task.entries[i];
+        {
+            QMutexLocker locker(&task.mutex);
+            while (!entry.done)
+                task.entryDone.wait(&task.mutex);
+        }
+        ok = entry.ok;
+        if (!ok)
+            break;
+        QuaZipFile outFile(&zip);
+        if (entry.isDir) {
+            ok = outFile.open(QIODevice::WriteOnly,
+                              QuaZipNewInfo(entry.name, entry.source), 0, 0, 0);
+            if (ok)
+                outFile.close();
+        } else {
+            // the sizes are known already, zip64 only where they need it
+            const qint64 compressedSize = entry.spill.isNull()
+                ? entry.data.size() : entry.spill->size();
+            zip.setZip64Enabled(entry.size >= 0xffffffffLL
+                                || compressedSize >= 0xffffffffLL);
+            ok = outFile.open(QIODevice::WriteOnly,
+                              QuaZipNewInfo(entry.name, entry.source), NULL, 0,
+                              Z_DEFLATED, Z_DEFAULT_COMPRESSION, true);
+            if (ok && entry.spill.isNull())
+                ok = outFile.write(entry.data) == entry.data.size();
+            else if (ok)
+                ok = entry.spill->seek(0) && copyData(*entry.spill, outFile);
+            if (outFile.isOpen()) {
+                if (ok) {
+                    outFile.closeRaw(entry.size, entry.crc);
+                    ok = outFile.getZipError() == ZIP_OK;
+                } else {
+                    outFile.discard();
+                }
+            }
+        }
+        entry.data = QByteArray();
+        entry.spill.clear();
+        task.window.release();
+    }
+    if (!ok) {
+        // let the workers waiting for room see the failure
+        task.failed.store(1);
+        task.window.release(task.count + workers);
+    }
+    pool.waitForDone();
+
+    zip.close();
+    if (!ok || zip.getZipError() != 0) {
+        QFile::remove(fileCompressed);
+        return false;
+    }
+    return true;
+}
+
+QStringList JlCompress::extractEntriesParallel(const QuaZipSharedArchive &archive,
+                                               const QList<int> &entries,
+                                               const QStringList &destinations,
+                                               int threads)
+{
+    // every directory is created once, instead of once per file
+    QSet<QString> dirSet;
+    for (int i = 0; i < destinations.size(); ++i) {
+        const QString &fileDest = destinations.at(i);
+        dirSet.insert(fileDest.endsWith('/')
+                      ? fileDest : QFileInfo(fileDest).absolutePath());
+    }
+    QStringList dirs = dirSet.toList();
+    qSort(dirs);
+    QDir curDir;
+    Q_FOREACH (QString dirPath, dirs) {
+        if (!curDir.mkpath(dirPath))
+            return QStringList();
+    }
+
+    // Entries with the same destination would be written by two workers
+    // at once, so only the last one in the archive is extracted, which
+    // is what the serial extraction leaves behind.
+    QHash<QString, int> writers;
+    for (int i = 0; i < destinations.size(); ++i) {
+        const QString &fileDest = destinations.at(i);
+        if (!writers.contains(fileDest)
+                || entries.at(writers.value(fileDest)) <= entries.at(i))
+            writers.insert(fileDest, i);
+    }
+    QList<int> work;
+    for (int i = 0; i < destinations.size(); ++i) {
+        if (writers.value(destinations.at(i)) == i)
+            work.append(i);
+    }
+
+    JlExtractTask task;
+    task.archive = &archive;
+    task.entries = &entries;
+    task.destinations = &destinations;
+    task.work = &work;
+    QVector<char> extracted(entries.size(), 0);
+    task.extracted = extracted.data();
+    const int workers = jlWorkerCount(threads);
+    QThreadPool pool;
+    pool.setMaxThreadCount(workers);
+    for (int i = 0; i < workers; ++i)
+        pool.start(new JlExtractWorker(&task));
+    pool.waitForDone();
+
+    QStringList extractedFiles;
+    for (int i = 0; i < entries.size(); ++i) {
+        if (extracted.at(writers.value(destinations.at(i))) != 0)
+            extractedFiles.append(destinations.at(i));
+    }
+    if (task.failed.load() != 0) {
+        removeFile(extractedFiles);
+        return QStringList();
+    }
+    return extractedFiles;
+}
+
+QStringList JlCompress::extractFilesParallel(QString fileCompressed, QStringList files,
+                                             QString dir, int threads)
+{
+    QuaZipSharedArchive archive(fileCompressed);
+    if (!archive.open())
+        return QStringList();
+    QList<int> entries;
+    QStringList destinations;
+    for (int i = 0; i < files.count(); i++) {
+        const int index = archive.indexOf(files.at(i));
+        if (index == -1)
+            return QStringList();
+        entries.append(index);
+        destinations.append(QDir(dir).absoluteFilePath(files.at(i)));
+    }
+    return extractEntriesParallel(archive, entries, destinations, threads);
+}
+
+QStringList JlCompress::extractDirParallel(QString fileCompressed, QString dir,
+                                           int threads)
+{
+    QuaZipSharedArchive archive(fileCompressed);
+    if (!archive.open() || archive.getEntriesCount() == 0)
+        return QStringList();
+    QDir directory(dir);
+    QList<int> entries;
+    QStringList destinations;
+    for (int i = 0; i < archive.getEntriesCount(); ++i) {
+        entries.append(i);
+        destinations.append(directory.absoluteFilePath(archive.getFileInfo(i).name));
+    }
+    return extractEntriesParallel(archive, entries, destinations, threads);
+}
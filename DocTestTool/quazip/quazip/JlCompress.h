@@ -34,6 +34,8 @@ see quazip/(un)zip.h files for details. Basically it's the zlib license.
 #include <QFileInfo>
 #include <QFile>
 
+class QuaZipSharedArchive;
+
 /// Utility class for typical operations.
 /**
   This class contains a number of useful static functions to perform
@@ -79,6 +81,18 @@ private:
       \return true if success, false otherwise.
       */
     static bool removeFile(QStringList listFile);
+    /// Extract some files of a shared archive in parallel.
+    /**
+      \param archive The opened archive to extract from.
+      \param entries The numbers of the files to extract.
+      \param destinations The full destination paths, one for each file.
+      \param threads The number of worker threads.
+      \return The list of the full paths of the files extracted, empty on failure.
+      */
+    static QStringList extractEntriesParallel(const QuaZipSharedArchive &archive,
+                                              const QList<int> &entries,
+                                              const QStringList &destinations,
+                                              int threads);
 
 public:
     /// Compress a single file.
@@ -124,6 +138,26 @@ public:
      */
     static bool compressDir(QString fileCompressed, QString dir,
                             bool recursive, QDir::Filters filters);
+    /// Compress a whole directory using several threads.
+    /**
+      Packs the same entries as compressDir(QString, QString, bool, QDir::Filters),
+      in the same order. A pool of workers deflates the files into
+      memory while the calling thread appends the finished ones to the
+      archive as raw data. Only a couple of files per worker are held at
+      a time, in compressed form, and of each at most 8 MB in memory, the
+      rest of a large file waits in a temporary file.
+
+      \param fileCompressed path to the resulting archive
+      \param dir path to the directory being compressed
+      \param recursive if true, then the subdirectories are packed as well
+      \param filters what to pack, as in compressDir()
+      \param threads the number of worker threads, one per core if 0 or less
+      \return true on success, false otherwise
+      */
+    static bool compressDirParallel(QString fileCompressed, QString dir,
+                                    bool recursive = true,
+                                    QDir::Filters filters = 0,
+                                    int threads = 0);
 
 public:
     /// Extract a single file.
@@ -152,6 +186,38 @@ public:
       \return The list of the full paths of the files extracted, empty on failure.
       */
     static QStringList extractDir(QString fileCompressed, QString dir = QString());
+    /// Extract a list of files using several threads.
+    /**
+      Does the same as extractFiles(QString, QStringList, QString), but
+      the files are inflated by a pool of workers, each reading the
+      archive on its own through QuaZipSharedArchive. The destination
+      directories are all created before the workers start. If several
+      entries go to the same path, only the last one is extracted, which
+      leaves the same file as the serial extraction. Encrypted files
+      can't be extracted this way.
+
+      \param fileCompressed The name of the archive.
+      \param files The file list to extract.
+      \param dir The directory to put the files to, the current
+      directory if left empty.
+      \param threads The number of worker threads, one per core if 0 or less.
+      \return The list of the full paths of the files extracted, empty on failure.
+      */
+    static QStringList extractFilesParallel(QString fileCompressed, QStringList files,
+                                            QString dir = QString(), int threads = 0);
+    /// Extract a whole archive using several threads.
+    /**
+      Does the same as extractDir(QString, QString), see
+      extractFilesParallel() for how the work is shared.
+
+      \param fileCompressed The name of the archive.
+      \param dir The directory to extract to, the current directory if
+      left empty.
+      \param threads The number of worker threads, one per core if 0 or less.
+      \return The list of the full paths of the files extracted, empty on failure.
+      */
+    static QStringList extractDirParallel(QString fileCompressed, QString dir = QString(),
+                                          int threads = 0);
     /// Get the file list.
     /**
       \return The list of the files in the archive, or, more precisely, the
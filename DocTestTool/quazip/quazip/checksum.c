@@ -0,0 +1,247 @@
+/* checksum.c -- CRC32 and Adler32 with runtime-dispatched SIMD versions
+
+   Part of QuaZIP, see quazip/(un)zip.h files for the minizip license.
+
+   The CRC32 folding follows Intel's "Fast CRC Computation for Generic
+   Polynomials Using PCLMULQDQ Instruction" white paper, with the
+   constants for the bit-reflected zip polynomial. The SSE4.2 crc32
+   instruction can't be used, it computes the Castagnoli CRC. The
+   Adler32 sums follow the usual NMAX blocking of zlib's adler32.c.
+*/
+
+#include "checksum.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#  if defined(__GNUC__) || defined(__clang__)
+#    define QUAZIP_X86_SIMD
+#    define QUAZIP_TARGET(x) __attribute__((target(x)))
+#    include <cpuid.h>
+#  elif defined(_MSC_VER) && _MSC_VER >= 1700
+#    define QUAZIP_X86_SIMD
+#    define QUAZIP_TARGET(x)
+#    include <intrin.h>
+#  endif
+#endif
+
+#ifdef QUAZIP_X86_SIMD
+#include <immintrin.h>
+#endif
+
+/* zlib counts in uInt, longer buffers go in pieces */
+#define QUAZIP_ZLIB_CHUNK 0x40000000u
+
+static uLong zlib_crc32(uLong crc, const unsigned char *buf, size_t len)
+{
+    while (len > QUAZIP_ZLIB_CHUNK) {
+        crc = crc32(crc, buf, QUAZIP_ZLIB_CHUNK);
+        buf += QUAZIP_ZLIB_CHUNK;
+        len -= QUAZIP_ZLIB_CHUNK;
+    }
+    return crc32(crc, buf, (uInt)len);
+}
+
+static uLong zlib_adler32(uLong adler, const unsigned char *buf, size_t len)
+{
+    while (len > QUAZIP_ZLIB_CHUNK) {
+        adler = adler32(adler, buf, QUAZIP_ZLIB_CHUNK);
+        buf += QUAZIP_ZLIB_CHUNK;
+        len -= QUAZIP_ZLIB_CHUNK;
+    }
+    return adler32(adler, buf, (uInt)len);
+}
+
+#ifdef QUAZIP_X86_SIMD
+
+#define QUAZIP_CPU_PCLMUL 1
+#define QUAZIP_CPU_AVX2 2
+#define QUAZIP_CPU_KNOWN 0x80
+
+/* Computed once, racing threads all store the same value */
+static volatile int quazip_cpu_features = 0;
+
+static int quazip_cpu(void)
+{
+    int features = quazip_cpu_features;
+    unsigned int leaf1[4] = {0, 0, 0, 0};
+    unsigned int leaf7[4] = {0, 0, 0, 0};
+    unsigned int max_leaf, xcr0 = 0;
+    if (features != 0)
+        return features;
+    features = QUAZIP_CPU_KNOWN;
+#if defined(_MSC_VER) && !defined(__clang__)
+    {
+        int regs[4];
+        __cpuid(regs, 0);
+        max_leaf = (unsigned int)regs[0];
+        __cpuid(regs, 1);
+        leaf1[2] = (unsigned int)regs[2];
+        if (max_leaf >= 7) {
+            __cpuidex(regs, 7, 0);
+            leaf7[1] = (unsigned int)regs[1];
+        }
+        if (leaf1[2] & (1u << 27))
+            xcr0 = (unsigned int)_xgetbv(0);
+    }
+#else
+    max_leaf = __get_cpuid_max(0, NULL);
+    if (max_leaf >= 1)
+        __cpuid(1, leaf1[0], leaf1[1], leaf1[2], leaf1[3]);
+    if (max_leaf >= 7)
+        __cpuid_count(7, 0, leaf7[0], leaf7[1], leaf7[2], leaf7[3]);
+    if (leaf1[2] & (1u << 27)) {
+        unsigned int edx;
+        __asm__ ("xgetbv" : "=a" (xcr0), "=d" (edx) : "c" (0));
+    }
+#endif
+    /* PCLMULQDQ and SSE4.1 */
+    if ((leaf1[2] & (1u << 1)) && (leaf1[2] & (1u << 19)))
+        features |= QUAZIP_CPU_PCLMUL;
+    /* AVX2, with the YMM state enabled by the OS */
+    if ((leaf7[1] & (1u << 5)) && (xcr0 & 6) == 6)
+        features |= QUAZIP_CPU_AVX2;
+    quazip_cpu_features = features;
+    return features;
+}
+
+/* x^(4*128+32), x^(4*128-32), x^(128+32), x^(128-32), x^64 mod P and
+   the Barrett constants, all bit-reflected */
+static const unsigned long long quazip_crc_k1k2[2] = {0x0154442bd4ULL, 0x01c6e41596ULL};
+static const unsigned long long quazip_crc_k3k4[2] = {0x01751997d0ULL, 0x00ccaa009eULL};
+static const unsigned long long quazip_crc_k5k0[2] = {0x0163cd6124ULL, 0x0000000000ULL};
+static const unsigned long long quazip_crc_poly[2] = {0x01db710641ULL, 0x01f7011641ULL};
+
+#define QUAZIP_CRC_FOLD(x, k, y) \
+    _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128((x), (k), 0x00), \
+                                _mm_clmulepi64_si128((x), (k), 0x11)), (y))
+
+/* len must be at least 64 and a multiple of 16, crc is not inverted */
+QUAZIP_TARGET("pclmul,sse4.1")
+static unsigned int quazip_crc32_pclmul(unsigned int crc,
+                                        const unsigned char *buf, size_t len)
+{
+    __m128i x0, x1, x2, x3, x4;
+    const __m128i mask32 = _mm_setr_epi32(~0, 0, ~0, 0);
+    x1 = _mm_loadu_si128((const __m128i *)(buf + 0x00));
+    x2 = _mm_loadu_si128((const __m128i *)(buf + 0x10));
+    x3 = _mm_loadu_si128((const __m128i *)(buf + 0x20));
+    x4 = _mm_loadu_si128((const __m128i *)(buf + 0x30));
+    x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128((int)crc));
+    x0 = _mm_loadu_si128((const __m128i *)quazip_crc_k1k2);
+    buf += 64;
+    len -= 64;
+    /* fold four lanes 512 bits ahead */
+    while (len >= 64) {
+        x1 = QUAZIP_CRC_FOLD(x1, x0, _mm_loadu_si128((const __m128i *)(buf + 0x00)));
+        x2 = QUAZIP_CRC_FOLD(x2, x0, _mm_loadu_si128((const __m128i *)(buf + 0x10)));
+        x3 = QUAZIP_CRC_FOLD(x3, x0, _mm_loadu_si128((const __m128i *)(buf + 0x20)));
+        x4 = QUAZIP_CRC_FOLD(x4, x0, _mm_loadu_si128((const __m128i *)(buf + 0x30)));
+        buf += 64;
+        len -= 64;
+    }
+    /* fold the lanes into one */
+    x0 = _mm_loadu_si128((const __m128i *)quazip_crc_k3k4);
+    x1 = QUAZIP_CRC_FOLD(x1, x0, x2);
+    x1 = QUAZIP_CRC_FOLD(x1, x0, x3);
+    x1 = QUAZIP_CRC_FOLD(x1, x0, x4);
+    while (len >= 16) {
+        x1 = QUAZIP_CRC_FOLD(x1, x0, _mm_loadu_si128((const __m128i *)buf));
+        buf += 16;
+        len -= 16;
+    }
+    /* 128 bits to 64 */
+    x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+    x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+    x0 = _mm_loadl_epi64((const __m128i *)quazip_crc_k5k0);
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_and_si128(x1, mask32);
+    x1 = _mm_xor_si128(_mm_clmulepi64_si128(x1, x0, 0x00), x2);
+    /* Barrett reduction to 32 bits */
+    x0 = _mm_loadu_si128((const __m128i *)quazip_crc_poly);
+    x2 = _mm_and_si128(x1, mask32);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+    x2 = _mm_and_si128(x2, mask32);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+    return (unsigned int)_mm_extract_epi32(x1, 1);
+}
+
+#define QUAZIP_ADLER_BASE 65521u
+/* the most 32-byte blocks whose sums can't overflow 32 bits, NMAX / 32 */
+#define QUAZIP_ADLER_BLOCKS 173
+
+QUAZIP_TARGET("avx2")
+static uLong quazip_adler32_avx2(uLong adler, const unsigned char *buf,
+                                 size_t len)
+{
+    unsigned int s1 = (unsigned int)(adler & 0xffff);
+    unsigned int s2 = (unsigned int)((adler >> 16) & 0xffff);
+    const __m256i weights = _mm256_setr_epi8(
+        32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17,
+        16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1);
+    const __m256i ones = _mm256_set1_epi16(1);
+    const __m256i zero = _mm256_setzero_si256();
+    while (len >= 32) {
+        size_t blocks = len / 32;
+        __m256i v_s1, v_s2, v_ps;
+        __m128i h;
+        if (blocks > QUAZIP_ADLER_BLOCKS)
+            blocks = QUAZIP_ADLER_BLOCKS;
+        len -= blocks * 32;
+        /* every block adds 32 times the s1 it starts with to s2 */
+        v_ps = _mm256_setr_epi32((int)(s1 * (unsigned int)blocks), 0, 0, 0, 0, 0, 0, 0);
+        v_s2 = _mm256_setr_epi32((int)s2, 0, 0, 0, 0, 0, 0, 0);
+        v_s1 = zero;
+        do {
+            const __m256i bytes = _mm256_loadu_si256((const __m256i *)buf);
+            v_ps = _mm256_add_epi32(v_ps, v_s1);
+            v_s1 = _mm256_add_epi32(v_s1, _mm256_sad_epu8(bytes, zero));
+            v_s2 = _mm256_add_epi32(v_s2, _mm256_madd_epi16(
+                _mm256_maddubs_epi16(bytes, weights), ones));
+            buf += 32;
+        } while (--blocks);
+        v_s2 = _mm256_add_epi32(v_s2, _mm256_slli_epi32(v_ps, 5));
+        h = _mm_add_epi32(_mm256_castsi256_si128(v_s1),
+                          _mm256_extracti128_si256(v_s1, 1));
+        h = _mm_add_epi32(h, _mm_shuffle_epi32(h, _MM_SHUFFLE(1, 0, 3, 2)));
+        s1 += (unsigned int)_mm_cvtsi128_si32(h);
+        h = _mm_add_epi32(_mm256_castsi256_si128(v_s2),
+                          _mm256_extracti128_si256(v_s2, 1));
+        h = _mm_add_epi32(h, _mm_shuffle_epi32(h, _MM_SHUFFLE(1, 0, 3, 2)));
+        h = _mm_add_epi32(h, _mm_shuffle_epi32(h, _MM_SHUFFLE(2, 3, 0, 1)));
+        s2 = (unsigned int)_mm_cvtsi128_si32(h);
+        s1 %= QUAZIP_ADLER_BASE;
+        s2 %= QUAZIP_ADLER_BASE;
+    }
+    adler = ((uLong)s2 << 16) | s1;
+    return len != 0 ? adler32(adler, buf, (uInt)len) : adler;
+}
+
+#endif /* QUAZIP_X86_SIMD */
+
+uLong quazip_crc32(uLong crc, const unsigned char *buf, size_t len)
+{
+    if (buf == NULL)
+        return crc32(crc, NULL, 0);
+#ifdef QUAZIP_X86_SIMD
+    if (len >= 64 && (quazip_cpu() & QUAZIP_CPU_PCLMUL) != 0) {
+        const size_t folded = len & ~(size_t)15;
+        crc = ~quazip_crc32_pclmul(~(unsigned int)crc, buf, folded) & 0xffffffffUL;
+        buf += folded;
+        len -= folded;
+        if (len == 0)
+            return crc;
+    }
+#endif
+    return zlib_crc32(crc, buf, len);
+}
+
+uLong quazip_adler32(uLong adler, const unsigned char *buf, size_t len)
+{
+    if (buf == NULL)
+        return adler32(adler, NULL, 0);
+#ifdef QUAZIP_X86_SIMD
+    if (len >= 64 && (quazip_cpu() & QUAZIP_CPU_AVX2) != 0)
+        return quazip_adler32_avx2(adler, buf, len);
+#endif
+    return zlib_adler32(adler, buf, len);
+}
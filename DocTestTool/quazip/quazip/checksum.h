@@ -0,0 +1,33 @@
+/* checksum.h -- CRC32 and Adler32 with runtime-dispatched SIMD versions
+
+   Part of QuaZIP, see quazip/(un)zip.h files for the minizip license.
+
+   quazip_crc32() and quazip_adler32() return what zlib's crc32() and
+   adler32() return for the same arguments, so they can replace them
+   anywhere. On x86 CPUs with PCLMULQDQ and SSE4.1 the CRC is computed by
+   carry-less multiplication folding, on CPUs with AVX2 the Adler32
+   checksum by 32-byte vector sums. Elsewhere, and for short buffers,
+   they call zlib.
+
+   The length is a size_t, buffers over 4 GB need no splitting.
+*/
+
+#ifndef _QUAZIP_CHECKSUM_H
+#define _QUAZIP_CHECKSUM_H
+
+#include <stddef.h>
+
+#include "zlib.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+uLong quazip_crc32(uLong crc, const unsigned char *buf, size_t len);
+uLong quazip_adler32(uLong adler, const unsigned char *buf, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _QUAZIP_CHECKSUM_H */
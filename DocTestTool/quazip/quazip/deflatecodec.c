@@ -0,0 +1,215 @@
+/* deflatecodec.c -- selectable deflate implementations for whole buffers
+
+   Part of QuaZIP, see quazip/(un)zip.h files for the minizip license.
+*/
+
+#include "deflatecodec.h"
+
+#include <string.h>
+
+#ifdef HAVE_LIBDEFLATE
+#include <libdeflate.h>
+#endif
+
+/* zlib counts in uInt, longer buffers go in pieces */
+#define QUAZIP_CODEC_CHUNK 0x40000000u
+
+static int zlib_window_bits(int format)
+{
+    switch (format) {
+    case QUAZIP_FORMAT_ZLIB:
+        return MAX_WBITS;
+    case QUAZIP_FORMAT_GZIP:
+        return MAX_WBITS + 16;
+    default:
+        return -MAX_WBITS;
+    }
+}
+
+static int zlib_compress(int format, int level, const void *in, size_t in_len,
+                         void *out, size_t out_cap, size_t *out_len)
+{
+    z_stream stream;
+    size_t in_left = in_len, out_left = out_cap;
+    int err;
+    memset(&stream, 0, sizeof(stream));
+    err = deflateInit2(&stream, level, Z_DEFLATED, zlib_window_bits(format),
+                       8, Z_DEFAULT_STRATEGY);
+    if (err != Z_OK)
+        return err;
+    stream.next_in = (Bytef*)in;
+    stream.next_out = (Bytef*)out;
+    do {
+        uInt in_chunk, out_chunk;
+        in_chunk = in_left > QUAZIP_CODEC_CHUNK ? QUAZIP_CODEC_CHUNK : (uInt)in_left;
+        out_chunk = out_left > QUAZIP_CODEC_CHUNK ? QUAZIP_CODEC_CHUNK : (uInt)out_left;
+        stream.avail_in = in_chunk;
+        stream.avail_out = out_chunk;
+        err = deflate(&stream, in_chunk == in_left ? Z_FINISH : Z_NO_FLUSH);
+        in_left -= in_chunk - stream.avail_in;
+        out_left -= out_chunk - stream.avail_out;
+    } while (err == Z_OK && out_left > 0);
+    deflateEnd(&stream);
+    if (err != Z_STREAM_END)
+        return err == Z_OK ? Z_BUF_ERROR : err;
+    *out_len = out_cap - out_left;
+    return Z_OK;
+}
+
+static int zlib_decompress(int format, const void *in, size_t in_len,
+                           void *out, size_t out_len)
+{
+    z_stream stream;
+    size_t in_left = in_len, out_left = out_len;
+    int err;
+    memset(&stream, 0, sizeof(stream));
+    err = inflateInit2(&stream, zlib_window_bits(format));
+    if (err != Z_OK)
+        return err;
+    stream.next_in = (Bytef*)in;
+    stream.next_out = (Bytef*)out;
+    do {
+        uInt in_chunk, out_chunk;
+        in_chunk = in_left > QUAZIP_CODEC_CHUNK ? QUAZIP_CODEC_CHUNK : (uInt)in_left;
+        out_chunk = out_left > QUAZIP_CODEC_CHUNK ? QUAZIP_CODEC_CHUNK : (uInt)out_left;
+        stream.avail_in = in_chunk;
+        stream.avail_out = out_chunk;
+        err = inflate(&stream, Z_NO_FLUSH);
+        in_left -= in_chunk - stream.avail_in;
+        out_left -= out_chunk - stream.avail_out;
+    } while (err == Z_OK);
+    inflateEnd(&stream);
+    if (err == Z_STREAM_END)
+        return out_left == 0 ? Z_OK : Z_DATA_ERROR;
+    /* ran out of input or of output before the end of the stream */
+    return err == Z_BUF_ERROR ? Z_DATA_ERROR : err;
+}
+
+#ifdef HAVE_LIBDEFLATE
+
+static int libdeflate_level(int level)
+{
+    return level < 0 ? 6 : level;
+}
+
+static int libdeflate_compress(int format, int level, const void *in,
+                               size_t in_len, void *out, size_t out_cap,
+                               size_t *out_len)
+{
+    struct libdeflate_compressor *compressor;
+    size_t size;
+    compressor = libdeflate_alloc_compressor(libdeflate_level(level));
+    if (compressor == NULL)
+        return Z_MEM_ERROR;
+    switch (format) {
+    case QUAZIP_FORMAT_ZLIB:
+        size = libdeflate_zlib_compress(compressor, in, in_len, out, out_cap);
+        break;
+    case QUAZIP_FORMAT_GZIP:
+        size = libdeflate_gzip_compress(compressor, in, in_len, out, out_cap);
+        break;
+    default:
+        size = libdeflate_deflate_compress(compressor, in, in_len, out, out_cap);
+        break;
+    }
+    libdeflate_free_compressor(compressor);
+    if (size == 0)
+        return Z_BUF_ERROR;
+    *out_len = size;
+    return Z_OK;
+}
+
+static int libdeflate_decompress(int format, const void *in, size_t in_len,
+                                 void *out, size_t out_len)
+{
+    struct libdeflate_decompressor *decompressor;
+    enum libdeflate_result result;
+    decompressor = libdeflate_alloc_decompressor();
+    if (decompressor == NULL)
+        return Z_MEM_ERROR;
+    switch (format) {
+    case QUAZIP_FORMAT_ZLIB:
+        result = libdeflate_zlib_decompress(decompressor, in, in_len,
+                                            out, out_len, NULL);
+        break;
+    case QUAZIP_FORMAT_GZIP:
+        result = libdeflate_gzip_decompress(decompressor, in, in_len,
+                                            out, out_len, NULL);
+        break;
+    default:
+        result = libdeflate_deflate_decompress(decompressor, in, in_len,
+                                               out, out_len, NULL);
+        break;
+    }
+    libdeflate_free_decompressor(decompressor);
+    return result == LIBDEFLATE_SUCCESS ? Z_OK : Z_DATA_ERROR;
+}
+
+#endif /* HAVE_LIBDEFLATE */
+
+int quazip_codec_available(int codec)
+{
+#ifdef HAVE_LIBDEFLATE
+    if (codec == QUAZIP_CODEC_LIBDEFLATE)
+        return 1;
+#endif
+    return codec == QUAZIP_CODEC_ZLIB;
+}
+
+const char *quazip_codec_name(int codec)
+{
+    if (codec == QUAZIP_CODEC_ZLIB)
+        return zlibVersion();
+#ifdef HAVE_LIBDEFLATE
+    if (codec == QUAZIP_CODEC_LIBDEFLATE)
+        return "libdeflate " LIBDEFLATE_VERSION_STRING;
+#endif
+    return "unavailable";
+}
+
+size_t quazip_codec_bound(int codec, int format, size_t len)
+{
+#ifdef HAVE_LIBDEFLATE
+    if (codec == QUAZIP_CODEC_LIBDEFLATE) {
+        switch (format) {
+        case QUAZIP_FORMAT_ZLIB:
+            return libdeflate_zlib_compress_bound(NULL, len);
+        case QUAZIP_FORMAT_GZIP:
+            return libdeflate_gzip_compress_bound(NULL, len);
+        default:
+            return libdeflate_deflate_compress_bound(NULL, len);
+        }
+    }
+#endif
+    (void)codec;
+    (void)format;
+    /* compressBound() plus the gzip header and trailer */
+    return len + (len >> 12) + (len >> 14) + (len >> 25) + 13 + 18;
+}
+
+int quazip_codec_compress(int codec, int format, int level,
+                          const void *in, size_t in_len,
+                          void *out, size_t out_cap, size_t *out_len)
+{
+#ifdef HAVE_LIBDEFLATE
+    if (codec == QUAZIP_CODEC_LIBDEFLATE)
+        return libdeflate_compress(format, level, in, in_len,
+                                   out, out_cap, out_len);
+#endif
+    if (codec != QUAZIP_CODEC_ZLIB)
+        return Z_STREAM_ERROR;
+    return zlib_compress(format, level, in, in_len, out, out_cap, out_len);
+}
+
+int quazip_codec_decompress(int codec, int format,
+                            const void *in, size_t in_len,
+                            void *out, size_t out_len)
+{
+#ifdef HAVE_LIBDEFLATE
+    if (codec == QUAZIP_CODEC_LIBDEFLATE)
+        return libdeflate_decompress(format, in, in_len, out, out_len);
+#endif
+    if (codec != QUAZIP_CODEC_ZLIB)
+        return Z_STREAM_ERROR;
+    return zlib_decompress(format, in, in_len, out, out_len);
+}
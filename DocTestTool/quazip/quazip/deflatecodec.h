@@ -0,0 +1,69 @@
+/* deflatecodec.h -- selectable deflate implementations for whole buffers
+
+   Part of QuaZIP, see quazip/(un)zip.h files for the minizip license.
+
+   Deflate output is the same format whatever produced it, so any codec
+   can write zip entries, zlib streams or gzip members that every reader
+   understands. Two codecs are known:
+
+   QUAZIP_CODEC_ZLIB is the zlib QuaZIP is linked with. Building against
+   zlib-ng in zlib compatible mode makes it zlib-ng, the streaming code
+   of zip.c, unzip.c and QuaZIODevice then use zlib-ng as well.
+   quazip_codec_name() tells which one it is.
+
+   QUAZIP_CODEC_LIBDEFLATE is libdeflate, available when QuaZIP is built
+   with HAVE_LIBDEFLATE defined and linked with libdeflate. It only works
+   on whole buffers, which it compresses faster and a little smaller than
+   zlib at the same level.
+
+   The functions return zlib error codes: Z_OK, Z_BUF_ERROR if the output
+   doesn't fit, Z_DATA_ERROR for corrupt input, Z_MEM_ERROR, and
+   Z_STREAM_ERROR for a codec that isn't compiled in.
+*/
+
+#ifndef _QUAZIP_DEFLATECODEC_H
+#define _QUAZIP_DEFLATECODEC_H
+
+#include <stddef.h>
+
+#include "zlib.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define QUAZIP_CODEC_ZLIB 0
+#define QUAZIP_CODEC_LIBDEFLATE 1
+
+/* What wraps the deflate data */
+#define QUAZIP_FORMAT_RAW 0  /* nothing, as in zip entries */
+#define QUAZIP_FORMAT_ZLIB 1 /* RFC 1950 */
+#define QUAZIP_FORMAT_GZIP 2 /* RFC 1952 */
+
+/* Returns 1 if the codec is compiled in */
+int quazip_codec_available(int codec);
+
+/* Returns the codec version, for zlib the zlibVersion() string, which
+   ends in ".zlib-ng" for zlib-ng */
+const char *quazip_codec_name(int codec);
+
+/* Returns the most bytes compressing len bytes can produce */
+size_t quazip_codec_bound(int codec, int format, size_t len);
+
+/* Compresses in_len bytes at in with a zlib level, -1 to 9. The output
+   size goes to *out_len */
+int quazip_codec_compress(int codec, int format, int level,
+                          const void *in, size_t in_len,
+                          void *out, size_t out_cap, size_t *out_len);
+
+/* Decompresses in_len bytes at in, which must expand to exactly out_len
+   bytes */
+int quazip_codec_decompress(int codec, int format,
+                            const void *in, size_t in_len,
+                            void *out, size_t out_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _QUAZIP_DEFLATECODEC_H */
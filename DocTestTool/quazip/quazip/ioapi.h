@@ -171,6 +171,10 @@ typedef struct zlib_filefunc64_def_s
 
 void fill_qiodevice64_filefunc OF((zlib_filefunc64_def* pzlib_filefunc_def));
 void fill_qiodevice_filefunc OF((zlib_filefunc_def* pzlib_filefunc_def));
+/* reads a QFile through a memory mapping of the whole file, read only */
+void fill_qiodevice_mapped64_filefunc OF((zlib_filefunc64_def* pzlib_filefunc_def));
+/* the mapping made by the open function, NULL until then */
+const unsigned char* qiodevice_mapped_data OF((voidpf opaque, ZPOS64_T* size));
 
 /* now internal definition, only for zip.c and unzip.h */
 typedef struct zlib_filefunc64_32_def_s
@@ -15,6 +15,7 @@
 #include "zlib.h"
 #include "ioapi.h"
 #include "quazip_global.h"
+#include <QFile>
 #include <QIODevice>
 #if (QT_VERSION >= 0x050100)
 #define QUAZIP_QSAVEFILE_BUG_WORKAROUND
@@ -345,6 +346,160 @@ void fill_qiodevice64_filefunc (
     pzlib_filefunc_def->zfakeclose_file = qiodevice_fakeclose_file_func;
 }
 
+/// @cond internal
+struct QIODevice_mapping {
+    // The whole file, mapped by the open function.
+    const uchar *data;
+    qint64 size;
+    qint64 pos;
+    inline QIODevice_mapping():
+        data(NULL), size(0), pos(0)
+    {}
+};
+/// @endcond
+
+voidpf ZCALLBACK qiodevice_mapped_open_file_func (
+   voidpf opaque,
+   voidpf file,
+   int mode)
+{
+    QIODevice_mapping *m = reinterpret_cast<QIODevice_mapping*>(opaque);
+    QFile *device = qobject_cast<QFile*>(reinterpret_cast<QIODevice*>(file));
+    if (device == NULL
+            || (mode & ZLIB_FILEFUNC_MODE_READWRITEFILTER)!=ZLIB_FILEFUNC_MODE_READ) {
+        delete m;
+        return NULL;
+    }
+    bool opened = false;
+    if (!device->isOpen()) {
+        if (!device->open(QIODevice::ReadOnly)) {
+            delete m;
+            return NULL;
+        }
+        opened = true;
+    }
+    if ((device->openMode() & QIODevice::ReadOnly) != 0
+            && !device->isSequential()) {
+        m->size = device->size();
+        m->data = device->map(0, m->size);
+    }
+    if (m->data == NULL) {
+        if (opened)
+            device->close();
+        delete m;
+        return NULL;
+    }
+    return device;
+}
+
+uLong ZCALLBACK qiodevice_mapped_read_file_func (
+   voidpf opaque,
+   voidpf /*stream UNUSED*/,
+   void* buf,
+   uLong size)
+{
+    QIODevice_mapping *m = reinterpret_cast<QIODevice_mapping*>(opaque);
+    qint64 available = m->size - m->pos;
+    if (available < 0)
+        available = 0;
+    if (static_cast<qint64>(size) > available)
+        size = static_cast<uLong>(available);
+    memcpy(buf, m->data + m->pos, size);
+    m->pos += size;
+    return size;
+}
+
+uLong ZCALLBACK qiodevice_mapped_write_file_func (
+   voidpf /*opaque UNUSED*/,
+   voidpf /*stream UNUSED*/,
+   const void* /*buf UNUSED*/,
+   uLong /*size UNUSED*/)
+{
+    // the mapping is read only
+    return 0;
+}
+
+ZPOS64_T ZCALLBACK qiodevice_mapped_tell_file_func (
+   voidpf opaque,
+   voidpf /*stream UNUSED*/)
+{
+    QIODevice_mapping *m = reinterpret_cast<QIODevice_mapping*>(opaque);
+    return static_cast<ZPOS64_T>(m->pos);
+}
+
+int ZCALLBACK qiodevice_mapped_seek_file_func (
+   voidpf opaque,
+   voidpf /*stream UNUSED*/,
+   ZPOS64_T offset,
+   int origin)
+{
+    QIODevice_mapping *m = reinterpret_cast<QIODevice_mapping*>(opaque);
+    qint64 pos;
+    switch (origin)
+    {
+    case ZLIB_FILEFUNC_SEEK_CUR :
+        pos = m->pos + offset;
+        break;
+    case ZLIB_FILEFUNC_SEEK_END :
+        pos = m->size - offset;
+        break;
+    case ZLIB_FILEFUNC_SEEK_SET :
+        pos = offset;
+        break;
+    default:
+        return -1;
+    }
+    if (pos < 0 || pos > m->size)
+        return -1;
+    m->pos = pos;
+    return 0;
+}
+
+int ZCALLBACK qiodevice_mapped_close_file_func (
+   voidpf opaque,
+   voidpf stream)
+{
+    QIODevice_mapping *m = reinterpret_cast<QIODevice_mapping*>(opaque);
+    QFile *device = reinterpret_cast<QFile*>(stream);
+    device->unmap(const_cast<uchar*>(m->data));
+    delete m;
+    device->close();
+    return 0;
+}
+
+int ZCALLBACK qiodevice_mapped_fakeclose_file_func (
+   voidpf opaque,
+   voidpf stream)
+{
+    QIODevice_mapping *m = reinterpret_cast<QIODevice_mapping*>(opaque);
+    QFile *device = reinterpret_cast<QFile*>(stream);
+    device->unmap(const_cast<uchar*>(m->data));
+    delete m;
+    return 0;
+}
+
+void fill_qiodevice_mapped64_filefunc (
+  zlib_filefunc64_def* pzlib_filefunc_def)
+{
+    pzlib_filefunc_def->zopen64_file = qiodevice_mapped_open_file_func;
+    pzlib_filefunc_def->zread_file = qiodevice_mapped_read_file_func;
+    pzlib_filefunc_def->zwrite_file = qiodevice_mapped_write_file_func;
+    pzlib_filefunc_def->ztell64_file = qiodevice_mapped_tell_file_func;
+    pzlib_filefunc_def->zseek64_file = qiodevice_mapped_seek_file_func;
+    pzlib_filefunc_def->zclose_file = qiodevice_mapped_close_file_func;
+    pzlib_filefunc_def->zerror_file = qiodevice_error_file_func;
+    pzlib_filefunc_def->opaque = new QIODevice_mapping;
+    pzlib_filefunc_def->zfakeclose_file = qiodevice_mapped_fakeclose_file_func;
+}
+
+const unsigned char* qiodevice_mapped_data (voidpf opaque, ZPOS64_T* size)
+{
+    QIODevice_mapping *m = reinterpret_cast<QIODevice_mapping*>(opaque);
+    if (size != NULL)
+        *size = static_cast<ZPOS64_T>(m->size);
+    return m->data;
+}
+
 void fill_zlib_filefunc64_32_def_from_filefunc32(zlib_filefunc64_32_def* p_filefunc64_32,const zlib_filefunc_def* p_filefunc32)
 {
     p_filefunc64_32->zfile_func64.zopen64_file = NULL;
@@ -25,7 +25,7 @@ see quazip/(un)zip.h files for details. Basically it's the zlib license.
 
 #include "quaadler32.h"
 
-#include "zlib.h"
+#include "checksum.h"
 
 QuaAdler32::QuaAdler32()
 {
@@ -34,7 +34,12 @@ QuaAdler32::QuaAdler32()
 
 quint32 QuaAdler32::calculate(const QByteArray &data)
 {
-	return adler32( adler32(0L, Z_NULL, 0), (const Bytef*)data.data(), data.size() );
+	return calculate(data.constData(), data.size());
+}
+
+quint32 QuaAdler32::calculate(const char *data, qint64 size)
+{
+	return quazip_adler32( adler32(0L, Z_NULL, 0), (const unsigned char*)data, (size_t)size );
 }
 
 void QuaAdler32::reset()
@@ -44,7 +49,12 @@ void QuaAdler32::reset()
 
 void QuaAdler32::update(const QByteArray &buf)
 {
-	checksum = adler32( checksum, (const Bytef*)buf.data(), buf.size() );
+	update(buf.constData(), buf.size());
+}
+
+void QuaAdler32::update(const char *data, qint64 size)
+{
+	checksum = quazip_adler32( checksum, (const unsigned char*)data, (size_t)size );
 }
 
 quint32 QuaAdler32::value()
@@ -42,9 +42,11 @@ public:
 	QuaAdler32();
 
 	quint32 calculate(const QByteArray &data);
+	quint32 calculate(const char *data, qint64 size);
 
 	void reset();
 	void update(const QByteArray &buf);
+	void update(const char *data, qint64 size);
 	quint32 value();
 
 private:
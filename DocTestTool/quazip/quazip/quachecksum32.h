@@ -73,6 +73,22 @@ public:
 	/** \return checksum
 	 */
 	virtual quint32 value() = 0;
+	///Calculates the checksum for \a size bytes at \a data.
+	/** Same as calculate(const QByteArray &), without wrapping the data
+	 * in a QByteArray. The default implementation wraps it anyway.
+	 */
+	virtual quint32 calculate(const char *data, qint64 size)
+	{
+		return calculate(QByteArray::fromRawData(data, static_cast<int>(size)));
+	}
+	///Updates the calculated checksum with \a size bytes at \a data.
+	/** Same as update(const QByteArray &), without wrapping the data
+	 * in a QByteArray. The default implementation wraps it anyway.
+	 */
+	virtual void update(const char *data, qint64 size)
+	{
+		update(QByteArray::fromRawData(data, static_cast<int>(size)));
+	}
 };
 
 #endif //QUACHECKSUM32_H
@@ -23,23 +23,45 @@ see quazip/(un)zip.h files for details. Basically it's the zlib license.
 */
 
 #include <QFile>
+#include <QScopedPointer>
 
 #include "quagzipfile.h"
+#include "quaparalleldeflater.h"
 
 /// \cond internal
 class QuaGzipFilePrivate {
     friend class QuaGzipFile;
     QString fileName;
     gzFile gzd;
-    inline QuaGzipFilePrivate(): gzd(NULL) {}
-    inline QuaGzipFilePrivate(const QString &fileName): 
-        fileName(fileName), gzd(NULL) {}
+    QuaGzipFile::CompressionMode compression;
+    /// The file written in the cmParallel mode.
+    QFile file;
+    QScopedPointer<QuaParallelDeflater> deflater;
+    inline QuaGzipFilePrivate(): gzd(NULL),
+        compression(QuaGzipFile::cmSerial) {}
+    inline QuaGzipFilePrivate(const QString &fileName,
+            QuaGzipFile::CompressionMode compression = QuaGzipFile::cmSerial):
+        fileName(fileName), gzd(NULL), compression(compression) {}
     template<typename FileId> bool open(FileId id, 
         QIODevice::OpenMode mode, QString &error);
     gzFile open(int fd, const char *modeString);
     gzFile open(const QString &name, const char *modeString);
+    bool openFile(int fd);
+    bool openFile(const QString &name);
 };
 
+bool QuaGzipFilePrivate::openFile(const QString &name)
+{
+    file.setFileName(name);
+    return file.open(QIODevice::WriteOnly);
+}
+
+bool QuaGzipFilePrivate::openFile(int fd)
+{
+    // gzclose() would close the descriptor too
+    return file.open(fd, QIODevice::WriteOnly, QFileDevice::AutoCloseHandle);
+}
+
 gzFile QuaGzipFilePrivate::open(const QString &name, const char *modeString)
 {
     return gzopen(QFile::encodeName(name).constData(), modeString);
@@ -75,6 +97,16 @@ bool QuaGzipFilePrivate::open(FileId id, QIODevice::OpenMode mode,
             " or for writing. Which is it?");
         return false;
     }
+    if (modeString[0] == 'w' && compression == QuaGzipFile::cmParallel) {
+        if (!openFile(id)) {
+            error = QuaGzipFile::trUtf8("Could not open file: %1")
+                .arg(file.errorString());
+            return false;
+        }
+        deflater.reset(new QuaParallelDeflater(&file,
+                    QuaParallelDeflater::Gzip, Z_DEFAULT_COMPRESSION));
+        return true;
+    }
     gzd = open(id, modeString);
     if (gzd == NULL) {
         error = QuaGzipFile::trUtf8("Could not gzopen() file");
@@ -101,6 +133,13 @@ d(new QuaGzipFilePrivate(fileName))
 {
 }
 
+QuaGzipFile::QuaGzipFile(const QString &fileName, CompressionMode compression,
+                         QObject *parent):
+  QIODevice(parent),
+d(new QuaGzipFilePrivate(fileName, compression))
+{
+}
+
 QuaGzipFile::~QuaGzipFile()
 {
   if (isOpen()) {
@@ -119,6 +158,16 @@ QString QuaGzipFile::getFileName() const
     return d->fileName;
 }
 
+void QuaGzipFile::setCompressionMode(CompressionMode compression)
+{
+    d->compression = compression;
+}
+
+QuaGzipFile::CompressionMode QuaGzipFile::getCompressionMode() const
+{
+    return d->compression;
+}
+
 bool QuaGzipFile::isSequential() const
 {
   return true;
@@ -146,12 +195,26 @@ bool QuaGzipFile::open(int fd, QIODevice::OpenMode mode)
 
 bool QuaGzipFile::flush()
 {
+    if (!d->deflater.isNull()) {
+        if (!d->deflater->flush()) {
+            setErrorString(d->deflater->errorString());
+            return false;
+        }
+        return d->file.flush();
+    }
     return gzflush(d->gzd, Z_SYNC_FLUSH) == Z_OK;
 }
 
 void QuaGzipFile::close()
 {
   QIODevice::close();
+  if (!d->deflater.isNull()) {
+    if (!d->deflater->finish())
+      setErrorString(d->deflater->errorString());
+    d->deflater.reset();
+    d->file.close();
+    return;
+  }
   gzclose(d->gzd);
 }
 
@@ -164,6 +227,13 @@ qint64 QuaGzipFile::writeData(const char *data, qint64 maxSize)
 {
     if (maxSize == 0)
         return 0;
+    if (!d->deflater.isNull()) {
+        if (!d->deflater->write(data, maxSize)) {
+            setErrorString(d->deflater->errorString());
+            return -1;
+        }
+        return maxSize;
+    }
     int written = gzwrite(d->gzd, (voidp)data, (unsigned)maxSize);
     if (written == 0)
         return -1;
@@ -39,6 +39,13 @@ class QuaGzipFilePrivate;
 class QUAZIP_EXPORT QuaGzipFile: public QIODevice {
   Q_OBJECT
 public:
+  /// How a file opened for writing is compressed.
+  enum CompressionMode {
+    cmSerial, ///< By zlib's gzwrite(), in the calling thread.
+    cmParallel /**< In 128 KB blocks on all CPU cores, like pigz does.
+                 The blocks make one ordinary gzip stream, a fraction
+                 of a percent larger than a serial one. */
+  };
   /// Empty constructor.
   /**
     Must call setFileName() before trying to open.
@@ -56,12 +63,35 @@ public:
     \param parent The parent object, as per QObject logic.
     */
   QuaGzipFile(const QString &fileName, QObject *parent = NULL);
+  /// Constructor for a file written in the given \a compression mode.
+  /**
+    \param fileName The name of the GZIP file.
+    \param compression How the file is compressed when written.
+    \param parent The parent object, as per QObject logic.
+    \sa setCompressionMode()
+    */
+  QuaGzipFile(const QString &fileName, CompressionMode compression,
+              QObject *parent = NULL);
   /// Destructor.
   virtual ~QuaGzipFile();
   /// Sets the name of the GZIP file to be opened.
   void setFileName(const QString& fileName);
   /// Returns the name of the GZIP file.
   QString getFileName() const;
+  /// Sets how the file is compressed when it's opened for writing.
+  /**
+    In the cmParallel mode the data is cut into blocks that are
+    compressed on a pool of QThread::idealThreadCount() threads while
+    the caller goes on writing. Every block starts with the last 32 KB
+    of the data before it as its dictionary, and the checksums of the
+    blocks are combined, so the file is a single standard gzip stream.
+    flush() then waits for all the blocks written so far. Reading is
+    not affected. The mode must be set before open(), the default is
+    cmSerial.
+    */
+  void setCompressionMode(CompressionMode compression);
+  /// Returns how the file is compressed when written.
+  CompressionMode getCompressionMode() const;
   /// Returns true.
   /**
     Strictly speaking, zlib supports seeking for GZIP files, but it is
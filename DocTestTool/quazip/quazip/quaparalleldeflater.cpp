@@ -0,0 +1,279 @@
+/*
+Copyright (C) 2005-2014 Sergey A. Tachenov
+
+This file is part of QuaZIP.
+
+QuaZIP is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 of the License, or
+(at your option) any later version.
+
+QuaZIP is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with QuaZIP.  If not, see <http://www.gnu.org/licenses/>.
+
+See COPYING file for the full LGPL text.
+
+Original ZIP package is copyrighted by Gilles Vollant and contributors,
+see quazip/(un)zip.h files for details. Basically it's the zlib license.
+*/
+
+#include "quaparalleldeflater.h"
+
+#include "checksum.h"
+
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QThread>
+
+#include <string.h>
+
+// pigz uses the same block size, a block is then big enough that the
+// per-block overhead vanishes and small enough to spread a few MB
+#define QUAPARALLEL_BLOCK_SIZE (128 * 1024)
+#define QUAPARALLEL_DICT_SIZE 32768
+
+/// \cond internal
+struct QuaParallelDeflaterBlock {
+    QuaParallelDeflaterBlock():
+        inputSize(0), last(false), check(0), ok(false), done(false) {}
+    QByteArray input; ///< Freed once deflated.
+    int inputSize;
+    QByteArray dictionary; ///< The 32 KB of input before this block.
+    QByteArray output;
+    bool last; ///< Ends the stream instead of a sync flush.
+    uLong check;
+    bool ok;
+    bool done; ///< Guarded by the mutex of the deflater.
+};
+
+class QuaParallelDeflaterWorker: public QRunnable {
+public:
+    QuaParallelDeflaterWorker(QuaParallelDeflater *deflater,
+                              const QSharedPointer<QuaParallelDeflaterBlock> &block):
+        deflater(deflater), block(block) {}
+    void run()
+    {
+        QuaParallelDeflaterBlock &b = *block;
+        const unsigned char *in =
+            reinterpret_cast<const unsigned char*>(b.input.constData());
+        b.check = deflater->format == QuaParallelDeflater::Gzip
+            ? quazip_crc32(0L, in, b.input.size())
+            : quazip_adler32(1L, in, b.input.size());
+        b.ok = deflateBlock(b);
+        QMutexLocker locker(&deflater->mutex);
+        b.done = true;
+        deflater->blockDone.wakeAll();
+    }
+private:
+    bool deflateBlock(QuaParallelDeflaterBlock &b)
+    {
+        z_stream stream;
+        memset(&stream, 0, sizeof(stream));
+        if (deflateInit2(&stream, deflater->level, Z_DEFLATED, -MAX_WBITS,
+                         8, Z_DEFAULT_STRATEGY) != Z_OK)
+            return false;
+        if (!b.dictionary.isEmpty()
+                && deflateSetDictionary(&stream,
+                    reinterpret_cast<const Bytef*>(b.dictionary.constData()),
+                    b.dictionary.size()) != Z_OK) {
+            deflateEnd(&stream);
+            return false;
+        }
+        // the bound doesn't count the empty stored block of a sync flush
+        b.output.resize(static_cast<int>(deflateBound(&stream, b.input.size())) + 16);
+        stream.next_in = reinterpret_cast<Bytef*>(b.input.data());
+        stream.avail_in = b.input.size();
+        stream.next_out = reinterpret_cast<Bytef*>(b.output.data());
+        stream.avail_out = b.output.size();
+        const int flush = b.last ? Z_FINISH : Z_SYNC_FLUSH;
+        int err;
+        for (;;) {
+            err = deflate(&stream, flush);
+            if (err != Z_OK || stream.avail_out != 0)
+                break;
+            b.output.resize(b.output.size() + 65536);
+            stream.next_out = reinterpret_cast<Bytef*>(b.output.data())
+                + stream.total_out;
+            stream.avail_out = b.output.size() - stream.total_out;
+        }
+        b.output.resize(static_cast<int>(stream.total_out));
+        deflateEnd(&stream);
+        b.input.clear();
+        b.dictionary.clear();
+        return b.last ? err == Z_STREAM_END
+                      : err == Z_OK && stream.avail_in == 0;
+    }
+    QuaParallelDeflater *deflater;
+    QSharedPointer<QuaParallelDeflaterBlock> block;
+};
+/// \endcond
+
+QuaParallelDeflater::QuaParallelDeflater(QIODevice *out, Format format,
+                                         int level, int threads):
+    out(out),
+    format(format),
+    level(level),
+    window(0),
+    headerWritten(false),
+    finished(false),
+    check(format == Gzip ? 0L : 1L),
+    totalIn(0)
+{
+    if (threads <= 0)
+        threads = QThread::idealThreadCount();
+    threads = qMax(threads, 1);
+    pool.setMaxThreadCount(threads);
+    window = 2 * threads;
+    pending.reserve(QUAPARALLEL_BLOCK_SIZE);
+}
+
+QuaParallelDeflater::~QuaParallelDeflater()
+{
+    pool.waitForDone();
+}
+
+bool QuaParallelDeflater::write(const char *data, qint64 size)
+{
+    if (!error.isEmpty() || finished)
+        return false;
+    if (!headerWritten && !writeHeader())
+        return false;
+    while (size > 0) {
+        const int take = static_cast<int>(qMin<qint64>(
+                    size, QUAPARALLEL_BLOCK_SIZE - pending.size()));
+        pending.append(data, take);
+        data += take;
+        size -= take;
+        if (pending.size() == QUAPARALLEL_BLOCK_SIZE && !queueBlock(false))
+            return false;
+    }
+    return true;
+}
+
+bool QuaParallelDeflater::flush()
+{
+    if (!error.isEmpty() || finished)
+        return false;
+    if (!headerWritten && !writeHeader())
+        return false;
+    if (!pending.isEmpty() && !queueBlock(false))
+        return false;
+    return writeBlocks(0);
+}
+
+bool QuaParallelDeflater::finish()
+{
+    if (!error.isEmpty() || finished)
+        return false;
+    if (!headerWritten && !writeHeader())
+        return false;
+    // the last block may be empty, it still ends the deflate data
+    if (!queueBlock(true) || !writeBlocks(0))
+        return false;
+    finished = true;
+    uchar trailer[8];
+    if (format == Gzip) {
+        for (int i = 0; i < 4; ++i) {
+            trailer[i] = static_cast<uchar>(check >> (8 * i));
+            trailer[4 + i] = static_cast<uchar>(totalIn >> (8 * i));
+        }
+        return writeAll(reinterpret_cast<const char*>(trailer), 8);
+    }
+    for (int i = 0; i < 4; ++i)
+        trailer[i] = static_cast<uchar>(check >> (24 - 8 * i));
+    return writeAll(reinterpret_cast<const char*>(trailer), 4);
+}
+
+bool QuaParallelDeflater::writeAll(const char *data, qint64 size)
+{
+    while (size > 0) {
+        const qint64 written = out->write(data, size);
+        if (written <= 0) {
+            error = out->errorString();
+            if (error.isEmpty())
+                error = QString::fromLatin1("Could not write compressed data");
+            return false;
+        }
+        data += written;
+        size -= written;
+    }
+    return true;
+}
+
+bool QuaParallelDeflater::writeHeader()
+{
+    headerWritten = true;
+    const int effective = level == Z_DEFAULT_COMPRESSION ? 6 : level;
+    if (format == Gzip) {
+        // no name, no time stamp, the OS is unknown
+        uchar header[10] = {0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 255};
+        if (effective == 9)
+            header[8] = 2;
+        else if (effective <= 1)
+            header[8] = 4;
+        return writeAll(reinterpret_cast<const char*>(header), 10);
+    }
+    // the dictionaries stay internal, so there's no FDICT
+    const int levelFlags = effective < 2 ? 0 : effective < 6 ? 1
+                         : effective == 6 ? 2 : 3;
+    uint header = (0x78 << 8) | (levelFlags << 6);
+    header += 31 - header % 31;
+    const char bytes[2] = {static_cast<char>(header >> 8),
+                           static_cast<char>(header & 0xff)};
+    return writeAll(bytes, 2);
+}
+
+bool QuaParallelDeflater::queueBlock(bool last)
+{
+    // keep the memory bounded, the oldest block has to go first
+    if (!writeBlocks(window - 1))
+        return false;
+    BlockPointer block(new QuaParallelDeflaterBlock());
+    block->input = pending;
+    block->inputSize = pending.size();
+    block->dictionary = dictionary;
+    block->last = last;
+    if (pending.size() >= QUAPARALLEL_DICT_SIZE) {
+        dictionary = pending.right(QUAPARALLEL_DICT_SIZE);
+    } else {
+        dictionary.append(pending);
+        dictionary = dictionary.right(QUAPARALLEL_DICT_SIZE);
+    }
+    totalIn += pending.size();
+    pending.clear();
+    pending.reserve(QUAPARALLEL_BLOCK_SIZE);
+    queue.append(block);
+    pool.start(new QuaParallelDeflaterWorker(this, block));
+    return true;
+}
+
+bool QuaParallelDeflater::writeBlocks(int limit)
+{
+    while (!queue.isEmpty()) {
+        BlockPointer block = queue.first();
+        {
+            QMutexLocker locker(&mutex);
+            // past the limit wait, below it write only what is ready
+            if (!block->done && queue.size() <= limit)
+                return true;
+            while (!block->done)
+                blockDone.wait(&mutex);
+        }
+        queue.removeFirst();
+        if (!block->ok) {
+            error = QString::fromLatin1("Could not deflate a block");
+            return false;
+        }
+        if (!writeAll(block->output.constData(), block->output.size()))
+            return false;
+        check = format == Gzip
+            ? crc32_combine(check, block->check, block->inputSize)
+            : adler32_combine(check, block->check, block->inputSize);
+    }
+    return true;
+}
@@ -0,0 +1,109 @@
+#ifndef QUAZIP_QUAPARALLELDEFLATER_H
+#define QUAZIP_QUAPARALLELDEFLATER_H
+
+/*
+Copyright (C) 2005-2014 Sergey A. Tachenov
+
+This file is part of QuaZIP.
+
+QuaZIP is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 of the License, or
+(at your option) any later version.
+
+QuaZIP is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with QuaZIP.  If not, see <http://www.gnu.org/licenses/>.
+
+See COPYING file for the full LGPL text.
+
+Original ZIP package is copyrighted by Gilles Vollant and contributors,
+see quazip/(un)zip.h files for details. Basically it's the zlib license.
+*/
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QList>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QString>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+#include <zlib.h>
+
+struct QuaParallelDeflaterBlock;
+
+/// \cond internal
+/// Compresses a stream in blocks on several threads, like pigz does.
+/**
+  \internal
+
+  The input is cut into blocks that a thread pool deflates at the same
+  time. Every block is primed with the last 32 KB of the input before
+  it, so that matches can reach back across the block boundary as in a
+  single deflate stream, and ends byte-aligned with a sync flush. The
+  raw deflate data of the blocks then simply follows one another, and
+  the checksums of the blocks are combined, which makes the output an
+  ordinary gzip or zlib stream that any decoder reads.
+
+  Blocks are written to the device in order, by the thread that calls
+  write(), flush() or finish(). At most two blocks per thread are held
+  in memory, write() waits for the oldest one when there are more.
+  */
+class QuaParallelDeflater {
+  public:
+    /// What wraps the deflate data.
+    enum Format {
+      Gzip, ///< RFC 1952, as written by gzip and QuaGzipFile.
+      Zlib ///< RFC 1950, as written by QuaZIODevice.
+    };
+    /// Compresses into \a out with a zlib \a level on \a threads threads.
+    /**
+      0 threads means QThread::idealThreadCount().
+      */
+    QuaParallelDeflater(QIODevice *out, Format format, int level,
+                        int threads = 0);
+    /// Waits for the workers, the stream is left unfinished.
+    ~QuaParallelDeflater();
+    /// Queues \a size bytes for compression.
+    bool write(const char *data, qint64 size);
+    /// Writes everything queued so far, so that it can be decompressed.
+    bool flush();
+    /// Writes everything queued so far and ends the stream.
+    bool finish();
+    /// Returns the reason of the last failure.
+    QString errorString() const {return error;}
+  private:
+    Q_DISABLE_COPY(QuaParallelDeflater)
+    typedef QSharedPointer<QuaParallelDeflaterBlock> BlockPointer;
+    friend class QuaParallelDeflaterWorker;
+    QIODevice *out;
+    Format format;
+    int level;
+    int window; ///< Most blocks held in memory.
+    QThreadPool pool;
+    QByteArray pending; ///< Input of the next block.
+    QByteArray dictionary; ///< The last 32 KB of the input queued so far.
+    QList<BlockPointer> queue; ///< Blocks not written yet, in order.
+    QMutex mutex; ///< Guards the done flags of the queued blocks.
+    QWaitCondition blockDone;
+    bool headerWritten;
+    bool finished;
+    uLong check; ///< CRC32 or Adler-32 of the input written so far.
+    quint64 totalIn;
+    QString error;
+    bool writeAll(const char *data, qint64 size);
+    bool writeHeader();
+    /// Hands the pending input to the workers.
+    bool queueBlock(bool last);
+    /// Writes finished blocks in order, waits while more than \a limit remain.
+    bool writeBlocks(int limit);
+};
+/// \endcond
+
+#endif // QUAZIP_QUAPARALLELDEFLATER_H
@@ -23,16 +23,21 @@ see quazip/(un)zip.h files for details. Basically it's the zlib license.
 */
 
 #include "quaziodevice.h"
+#include "quaparalleldeflater.h"
 
-#define QUAZIO_INBUFSIZE 4096
-#define QUAZIO_OUTBUFSIZE 4096
+// large enough that the codec, not the per-call overhead, sets the pace
+#define QUAZIO_INBUFSIZE 65536
+#define QUAZIO_OUTBUFSIZE 65536
 
 /// \cond internal
 class QuaZIODevicePrivate {
     friend class QuaZIODevice;
-    QuaZIODevicePrivate(QIODevice *io);
+    QuaZIODevicePrivate(QIODevice *io, QuaZIODevice::CompressionMode compression);
     ~QuaZIODevicePrivate();
     QIODevice *io;
+    QuaZIODevice::CompressionMode compression;
+    /// Writes in the cmParallel mode, NULL otherwise.
+    QuaParallelDeflater *deflater;
     z_stream zins;
     z_stream zouts;
     char *inBuf;
@@ -46,8 +51,11 @@ class QuaZIODevicePrivate {
     int doFlush(QString &error);
 };
 
-QuaZIODevicePrivate::QuaZIODevicePrivate(QIODevice *io):
+QuaZIODevicePrivate::QuaZIODevicePrivate(QIODevice *io,
+        QuaZIODevice::CompressionMode compression):
   io(io),
+  compression(compression),
+  deflater(NULL),
   inBuf(NULL),
   inBufPos(0),
   inBufSize(0),
@@ -87,6 +95,7 @@ QuaZIODevicePrivate::~QuaZIODevicePrivate()
     delete[] inBuf;
   if (outBuf != NULL)
     delete[] outBuf;
+  delete deflater;
 }
 
 int QuaZIODevicePrivate::doFlush(QString &error)
@@ -124,7 +133,15 @@ static QFile indebug;
 
 QuaZIODevice::QuaZIODevice(QIODevice *io, QObject *parent):
     QIODevice(parent),
-    d(new QuaZIODevicePrivate(io))
+    d(new QuaZIODevicePrivate(io, cmSerial))
+{
+  connect(io, SIGNAL(readyRead()), SIGNAL(readyRead()));
+}
+
+QuaZIODevice::QuaZIODevice(QIODevice *io, CompressionMode compression,
+                           QObject *parent):
+    QIODevice(parent),
+    d(new QuaZIODevicePrivate(io, compression))
 {
   connect(io, SIGNAL(readyRead()), SIGNAL(readyRead()));
 }
@@ -159,7 +176,10 @@ bool QuaZIODevice::open(QIODevice::OpenMode mode)
             return false;
         }
     }
-    if ((mode & QIODevice::WriteOnly) != 0) {
+    if ((mode & QIODevice::WriteOnly) != 0 && d->compression == cmParallel) {
+        d->deflater = new QuaParallelDeflater(d->io,
+                QuaParallelDeflater::Zlib, Z_DEFAULT_COMPRESSION);
+    } else if ((mode & QIODevice::WriteOnly) != 0) {
         if (deflateInit(&d->zouts, Z_DEFAULT_COMPRESSION) != Z_OK) {
             setErrorString(d->zouts.msg);
             return false;
@@ -175,7 +195,12 @@ void QuaZIODevice::close()
             setErrorString(d->zins.msg);
         }
     }
-    if ((openMode() & QIODevice::WriteOnly) != 0) {
+    if (d->deflater != NULL) {
+        if (!d->deflater->finish())
+            setErrorString(d->deflater->errorString());
+        delete d->deflater;
+        d->deflater = NULL;
+    } else if ((openMode() & QIODevice::WriteOnly) != 0) {
         flush();
         if (deflateEnd(&d->zouts) != Z_OK) {
             setErrorString(d->zouts.msg);
@@ -247,6 +272,13 @@ qint64 QuaZIODevice::readData(char *data, qint64 maxSize)
 
 qint64 QuaZIODevice::writeData(const char *data, qint64 maxSize)
 {
+  if (d->deflater != NULL) {
+    if (!d->deflater->write(data, maxSize)) {
+      setErrorString(d->deflater->errorString());
+      return -1;
+    }
+    return maxSize;
+  }
   int written = 0;
   QString error;
   if (d->doFlush(error) == -1) {
@@ -283,6 +315,13 @@ qint64 QuaZIODevice::writeData(const char *data, qint64 maxSize)
 
 bool QuaZIODevice::flush()
 {
+    if (d->deflater != NULL) {
+        if (!d->deflater->flush()) {
+            setErrorString(d->deflater->errorString());
+            return false;
+        }
+        return true;
+    }
     QString error;
     if (d->doFlush(error) < 0) {
         setErrorString(error);
@@ -41,12 +41,33 @@ class QuaZIODevicePrivate;
 class QUAZIP_EXPORT QuaZIODevice: public QIODevice {
   Q_OBJECT
 public:
+  /// How the data is compressed when the device is opened for writing.
+  enum CompressionMode {
+    cmSerial, ///< Deflated in the calling thread.
+    cmParallel /**< Deflated in 128 KB blocks on all CPU cores. The
+                 blocks make one ordinary zlib stream, a fraction of
+                 a percent larger than a serial one. */
+  };
   /// Constructor.
   /**
     \param io The QIODevice to read/write.
     \param parent The parent object, as per QObject logic.
     */
   QuaZIODevice(QIODevice *io, QObject *parent = NULL);
+  /// Constructor for a device written in the given \a compression mode.
+  /**
+    In the cmParallel mode the data written is compressed on a pool of
+    QThread::idealThreadCount() threads while the caller goes on
+    writing. flush() then waits for all the blocks written so far, and
+    close() ends the compressed stream, so the reader sees atEnd().
+    Reading is not affected.
+
+    \param io The QIODevice to read/write.
+    \param compression How the data is compressed when written.
+    \param parent The parent object, as per QObject logic.
+    */
+  QuaZIODevice(QIODevice *io, CompressionMode compression,
+               QObject *parent = NULL);
   /// Destructor.
   ~QuaZIODevice();
   /// Flushes data waiting to be written.
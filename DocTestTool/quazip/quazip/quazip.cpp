@@ -22,11 +22,18 @@ Original ZIP package is copyrighted by Gilles Vollant, see
 quazip/(un)zip.h files for details, basically it's zlib license.
  **/
 
+#include <QDateTime>
 #include <QFile>
+#include <QFileInfo>
 #include <QFlags>
 #include <QHash>
+#include <QScopedPointer>
 
 #include "quazip.h"
+#include "checksum.h"
+#include "deflatecodec.h"
+#include "quazipdirtree.h"
+#include "quazipnameindex.h"
 
 /// All the internal stuff for the QuaZip class.
 /**
@@ -70,6 +77,24 @@ class QuaZipPrivate {
     bool zip64;
     /// The auto-close flag.
     bool autoClose;
+    /// Whether \ref QuaZip::setNameIndexEnabled() "the persistent name index" is enabled.
+    bool nameIndexEnabled;
+    /// The mapped name index, if it matched the archive.
+    QuaZipNameIndex nameIndex;
+    /// Whether \ref QuaZip::setCentralDirBufferingEnabled() "the central directory is read in one go".
+    bool centralDirBufferingEnabled;
+    /// Whether \ref QuaZip::setMemoryMappingEnabled() "the archive is mapped" when possible.
+    bool memoryMappingEnabled;
+    /// The mapped archive, if it is mapped.
+    const uchar *mappedData;
+    /// The size of the mapped archive.
+    qint64 mappedSize;
+    /// The \ref QuaZip::setDeflateCodec() "deflate codec" for new entries.
+    QuaZip::DeflateCodec deflateCodec;
+    /// The \ref QuaZip::setZstdWorkers() "zstd worker threads".
+    int zstdWorkers;
+    /// The directory tree for QuaZipDir, built on first use.
+    QScopedPointer<QuaZipDirTree> dirTree;
     inline QTextCodec *getDefaultFileNameCodec()
     {
         if (defaultFileNameCodec == NULL) {
@@ -89,7 +114,14 @@ class QuaZipPrivate {
       zipError(UNZ_OK),
       dataDescriptorWritingEnabled(true),
       zip64(false),
-      autoClose(true)
+      autoClose(true),
+      nameIndexEnabled(false),
+      centralDirBufferingEnabled(true),
+      memoryMappingEnabled(false),
+      mappedData(NULL),
+      mappedSize(0),
+      deflateCodec(QuaZip::dcZlib),
+      zstdWorkers(0)
     {
         unzFile_f = NULL;
         zipFile_f = NULL;
@@ -108,7 +140,14 @@ class QuaZipPrivate {
       zipError(UNZ_OK),
       dataDescriptorWritingEnabled(true),
       zip64(false),
-      autoClose(true)
+      autoClose(true),
+      nameIndexEnabled(false),
+      centralDirBufferingEnabled(true),
+      memoryMappingEnabled(false),
+      mappedData(NULL),
+      mappedSize(0),
+      deflateCodec(QuaZip::dcZlib),
+      zstdWorkers(0)
     {
         unzFile_f = NULL;
         zipFile_f = NULL;
@@ -126,7 +165,14 @@ class QuaZipPrivate {
       zipError(UNZ_OK),
       dataDescriptorWritingEnabled(true),
       zip64(false),
-      autoClose(true)
+      autoClose(true),
+      nameIndexEnabled(false),
+      centralDirBufferingEnabled(true),
+      memoryMappingEnabled(false),
+      mappedData(NULL),
+      mappedSize(0),
+      deflateCodec(QuaZip::dcZlib),
+      zstdWorkers(0)
     {
         unzFile_f = NULL;
         zipFile_f = NULL;
@@ -141,6 +187,14 @@ class QuaZipPrivate {
       inline void clearDirectoryMap();
       inline void addCurrentFileToDirectoryMap(const QString &fileName);
       bool goToFirstUnmappedFile();
+      /// Maps the name index of the archive, writing it first if needed.
+      void openNameIndex();
+      /// Reads what the name index must have been written for.
+      bool readNameIndexStamp(QuaZipNameIndex::Stamp *stamp);
+      /// Sets the current file to the entry called \a key using the name index.
+      bool locateInNameIndex(const QString &key, bool caseSensitive);
+      /// Opens the archive through a memory mapping of the file.
+      unzFile openMapped(QIODevice *ioDevice, unsigned flags);
       QHash<QString, unz64_file_pos> directoryCaseSensitive;
       QHash<QString, unz64_file_pos> directoryCaseInsensitive;
       unz64_file_pos lastMappedDirectoryEntry;
@@ -149,6 +203,25 @@ class QuaZipPrivate {
 
 QTextCodec *QuaZipPrivate::defaultFileNameCodec = NULL;
 
+unzFile QuaZipPrivate::openMapped(QIODevice *ioDevice, unsigned flags)
+{
+    zlib_filefunc64_32_def mappedApi;
+    fill_qiodevice_mapped64_filefunc(&mappedApi.zfile_func64);
+    mappedApi.zopen32_file = NULL;
+    mappedApi.ztell32_file = NULL;
+    mappedApi.zseek32_file = NULL;
+    // freed by the IO functions when the archive is closed or fails to open
+    voidpf mapping = mappedApi.zfile_func64.opaque;
+    unzFile unz = unzOpenInternal(ioDevice, &mappedApi, 1, flags);
+    if (unz != NULL) {
+        ZPOS64_T size;
+        mappedData = qiodevice_mapped_data(mapping, &size);
+        mappedSize = static_cast<qint64>(size);
+        unzSetMappedData(unz, mappedData, size);
+    }
+    return unz;
+}
+
 void QuaZipPrivate::clearDirectoryMap()
 {
     directoryCaseInsensitive.clear();
@@ -197,6 +270,81 @@ bool QuaZipPrivate::goToFirstUnmappedFile()
     return hasCurrentFile_f;
 }
 
+bool QuaZipPrivate::readNameIndexStamp(QuaZipNameIndex::Stamp *stamp)
+{
+    unz_global_info64 globalInfo;
+    ZPOS64_T dirOffset, dirSize;
+    if (unzGetGlobalInfo64(unzFile_f, &globalInfo) != UNZ_OK
+            || unzGetCentralDirInfo64(unzFile_f, &dirOffset, &dirSize) != UNZ_OK)
+        return false;
+    QFileInfo zipInfo(zipName);
+    stamp->archiveSize = zipInfo.size();
+    stamp->modified = zipInfo.lastModified().toMSecsSinceEpoch();
+    stamp->dirOffset = dirOffset;
+    stamp->dirSize = dirSize;
+    stamp->entries = globalInfo.number_entry;
+    stamp->codecMib = fileNameCodec->mibEnum();
+    // reading the raw central directory is far cheaper than parsing it
+    if (!ioDevice->seek(dirOffset))
+        return false;
+    uLong crc = crc32(0L, Z_NULL, 0);
+    QByteArray buffer(1024 * 1024, '\0');
+    for (quint64 left = dirSize; left > 0; ) {
+        const qint64 read = ioDevice->read(buffer.data(),
+                qMin<quint64>(left, buffer.size()));
+        if (read <= 0)
+            return false;
+        crc = quazip_crc32(crc,
+                reinterpret_cast<const unsigned char*>(buffer.constData()),
+                static_cast<size_t>(read));
+        left -= read;
+    }
+    stamp->dirCrc = static_cast<quint32>(crc);
+    return true;
+}
+
+void QuaZipPrivate::openNameIndex()
+{
+    if (!nameIndexEnabled || zipName.isEmpty())
+        return;
+    QuaZipNameIndex::Stamp stamp;
+    if (!readNameIndexStamp(&stamp))
+        return;
+    const QString indexPath = QuaZipNameIndex::indexPath(zipName);
+    if (nameIndex.open(indexPath, stamp))
+        return;
+    // missing or stale, one walk over the central directory fills both
+    // maps and they are saved for the next process
+    for (bool more = q->goToFirstFile(); more; more = q->goToNextFile()) {
+        if (q->getCurrentFileName().isEmpty() && zipError != UNZ_OK)
+            break;
+    }
+    const bool complete = zipError == UNZ_OK;
+    unzGoToFirstFile(unzFile_f);
+    hasCurrentFile_f = false;
+    zipError = UNZ_OK;
+    if (complete && QuaZipNameIndex::write(indexPath, stamp,
+                directoryCaseSensitive, directoryCaseInsensitive))
+        nameIndex.open(indexPath, stamp);
+}
+
+bool QuaZipPrivate::locateInNameIndex(const QString &key, bool caseSensitive)
+{
+    const QList<unz64_file_pos> candidates =
+        nameIndex.candidates(key, caseSensitive);
+    foreach (const unz64_file_pos &pos, candidates) {
+        zipError = unzGoToFilePos64(unzFile_f, &pos);
+        if (zipError != UNZ_OK)
+            break;
+        hasCurrentFile_f = true;
+        const QString current = q->getCurrentFileName();
+        if (caseSensitive ? current == key : current.toLower() == key)
+            return true;
+    }
+    hasCurrentFile_f = false;
+    return false;
+}
+
 QuaZip::QuaZip():
   p(new QuaZipPrivate(this))
 {
@@ -241,7 +389,14 @@ bool QuaZip::open(Mode mode, zlib_filefunc_def* ioApi)
       if (ioApi == NULL) {
           if (p->autoClose)
               flags |= UNZ_AUTO_CLOSE;
-          p->unzFile_f=unzOpenInternal(ioDevice, NULL, 1, flags);
+          if (p->centralDirBufferingEnabled)
+              flags |= UNZ_BUFFER_CENTRAL_DIR;
+          p->unzFile_f = NULL;
+          // a file that can't be mapped is read through the device
+          if (p->memoryMappingEnabled && qobject_cast<QFile*>(ioDevice) != NULL)
+              p->unzFile_f = p->openMapped(ioDevice, flags);
+          if (p->unzFile_f == NULL)
+              p->unzFile_f=unzOpenInternal(ioDevice, NULL, 1, flags);
       } else {
           // QuaZIP pre-zip64 compatibility mode
           p->unzFile_f=unzOpen2(ioDevice, ioApi);
@@ -265,6 +420,7 @@ bool QuaZip::open(Mode mode, zlib_filefunc_def* ioApi)
         }
         p->mode=mode;
         p->ioDevice = ioDevice;
+        p->openNameIndex();
         return true;
       } else {
         p->zipError=UNZ_OPENERROR;
@@ -298,6 +454,8 @@ bool QuaZip::open(Mode mode, zlib_filefunc_def* ioApi)
           }
       }
       if(p->zipFile_f!=NULL) {
+        zipSetDeflateCodec(p->zipFile_f, p->deflateCodec);
+        zipSetZstdWorkers(p->zipFile_f, p->zstdWorkers);
         if (ioDevice->isSequential()) {
             if (mode != mdCreate) {
                 zipClose(p->zipFile_f, NULL);
@@ -355,6 +513,10 @@ void QuaZip::close()
       p->ioDevice = NULL;
   }
   p->clearDirectoryMap();
+  p->nameIndex.close();
+  p->dirTree.reset();
+  p->mappedData = NULL;
+  p->mappedSize = 0;
   if(p->zipError==UNZ_OK)
     p->mode=mdNotOpen;
 }
@@ -457,6 +619,10 @@ bool QuaZip::setCurrentFile(const QString& fileName, CaseSensitivity cs)
   if (p->hasCurrentFile_f)
       return p->hasCurrentFile_f;
 
+  // The index knows every name, so a miss there needs no scan
+  if (p->nameIndex.isOpen())
+      return p->locateInNameIndex(sens ? fileName : lower, sens);
+
   // Not mapped yet, start from where we have got to so far
   for(bool more=p->goToFirstUnmappedFile(); more; more=goToNextFile()) {
     current=getCurrentFileName();
@@ -482,6 +648,18 @@ bool QuaZip::goToFirstFile()
   return p->hasCurrentFile_f;
 }
 
+bool QuaZip::goToEntryOffset(qint64 offset)
+{
+  p->zipError=UNZ_OK;
+  if(p->mode!=mdUnzip) {
+    qWarning("QuaZip::goToEntryOffset(): ZIP is not open in mdUnzip mode");
+    return false;
+  }
+  p->zipError=unzSetOffset64(p->unzFile_f, static_cast<ZPOS64_T>(offset));
+  p->hasCurrentFile_f=p->zipError==UNZ_OK;
+  return p->hasCurrentFile_f;
+}
+
 bool QuaZip::goToNextFile()
 {
   p->zipError=UNZ_OK;
@@ -579,11 +757,14 @@ QString QuaZip::getCurrentFileName()const
 void QuaZip::setFileNameCodec(QTextCodec *fileNameCodec)
 {
   p->fileNameCodec=fileNameCodec;
+  // the tree holds names decoded with the old codec
+  p->dirTree.reset();
 }
 
 void QuaZip::setFileNameCodec(const char *fileNameCodecName)
 {
   p->fileNameCodec=QTextCodec::codecForName(fileNameCodecName);
+  p->dirTree.reset();
 }
 
 QTextCodec *QuaZip::getFileNameCodec()const
@@ -653,6 +834,31 @@ zipFile QuaZip::getZipFile()
   return p->zipFile_f;
 }
 
+const QuaZipDirTree *QuaZip::getDirTree()
+{
+  if (p->mode != mdUnzip) {
+    qWarning("QuaZip::getDirTree(): ZIP is not open in mdUnzip mode");
+    return NULL;
+  }
+  if (p->dirTree.isNull()) {
+    QScopedPointer<QuaZipDirTree> tree(new QuaZipDirTree());
+    // there is no first file to go to in an empty archive
+    if (getEntriesCount() != 0) {
+      for (bool more = goToFirstFile(); more; more = goToNextFile()) {
+        QString name = getCurrentFileName();
+        if (p->zipError != UNZ_OK)
+          return NULL;
+        tree->addPath(name, static_cast<qint64>(
+                          unzGetOffset64(p->unzFile_f)));
+      }
+    }
+    if (p->zipError != UNZ_OK)
+      return NULL;
+    p->dirTree.reset(tree.take());
+  }
+  return p->dirTree.data();
+}
+
 void QuaZip::setDataDescriptorWritingEnabled(bool enabled)
 {
     p->dataDescriptorWritingEnabled = enabled;
@@ -793,3 +999,95 @@ void QuaZip::setAutoClose(bool autoClose) const
 {
     p->autoClose = autoClose;
 }
+
+void QuaZip::setNameIndexEnabled(bool enabled)
+{
+    p->nameIndexEnabled = enabled;
+}
+
+bool QuaZip::isNameIndexEnabled() const
+{
+    return p->nameIndexEnabled;
+}
+
+bool QuaZip::isNameIndexUsed() const
+{
+    return p->nameIndex.isOpen();
+}
+
+void QuaZip::setCentralDirBufferingEnabled(bool enabled)
+{
+    p->centralDirBufferingEnabled = enabled;
+}
+
+bool QuaZip::isCentralDirBufferingEnabled() const
+{
+    return p->centralDirBufferingEnabled;
+}
+
+void QuaZip::setMemoryMappingEnabled(bool enabled)
+{
+    p->memoryMappingEnabled = enabled;
+}
+
+bool QuaZip::isMemoryMappingEnabled() const
+{
+    return p->memoryMappingEnabled;
+}
+
+bool QuaZip::isMemoryMapped() const
+{
+    return p->mappedData != NULL;
+}
+
+void QuaZip::setDeflateCodec(DeflateCodec codec)
+{
+    p->deflateCodec = isDeflateCodecAvailable(codec) ? codec : dcZlib;
+    if (p->mode == mdCreate || p->mode == mdAppend || p->mode == mdAdd)
+        zipSetDeflateCodec(p->zipFile_f, p->deflateCodec);
+}
+
+QuaZip::DeflateCodec QuaZip::getDeflateCodec() const
+{
+    return p->deflateCodec;
+}
+
+bool QuaZip::isDeflateCodecAvailable(DeflateCodec codec)
+{
+    return quazip_codec_available(codec) != 0;
+}
+
+QString QuaZip::getDeflateCodecName(DeflateCodec codec)
+{
+    if (!isDeflateCodecAvailable(codec))
+        return QString();
+    return QString::fromLatin1(quazip_codec_name(codec));
+}
+
+bool QuaZip::isZstdAvailable()
+{
+#ifdef HAVE_ZSTD
+    return true;
+#else
+    return false;
+#endif
+}
+
+void QuaZip::setZstdWorkers(int workers)
+{
+    p->zstdWorkers = qMax(workers, 0);
+    if (p->mode == mdCreate || p->mode == mdAppend || p->mode == mdAdd)
+        zipSetZstdWorkers(p->zipFile_f, p->zstdWorkers);
+}
+
+int QuaZip::getZstdWorkers() const
+{
+    return p->zstdWorkers;
+}
+
+const uchar *QuaZip::getMappedData(qint64 *size) const
+{
+    if (size != NULL)
+        *size = p->mappedSize;
+    return p->mappedData;
+}
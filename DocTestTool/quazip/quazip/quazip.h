@@ -42,6 +42,7 @@ quazip/(un)zip.h files for details, basically it's zlib license.
 #endif
 
 class QuaZipPrivate;
+class QuaZipDirTree;
 
 /// ZIP archive.
 /** \class QuaZip quazip.h <quazip/quazip.h>
@@ -83,6 +84,8 @@ class QuaZipPrivate;
  **/
 class QUAZIP_EXPORT QuaZip {
   friend class QuaZipPrivate;
+  friend class QuaZipDirPrivate;
+  friend class QuaZipFile;
   public:
     /// Useful constants.
     enum Constants {
@@ -116,6 +119,12 @@ class QUAZIP_EXPORT QuaZip {
       csSensitive=1, ///< Case sensitive.
       csInsensitive=2 ///< Case insensitive.
     };
+    /// Deflate implementation used to compress new entries.
+    /** \sa setDeflateCodec() */
+    enum DeflateCodec {
+      dcZlib=0, ///< The zlib QuaZIP is linked with, zlib-ng if built in its compatible mode.
+      dcLibdeflate=1 ///< libdeflate, if QuaZIP was built with \c HAVE_LIBDEFLATE.
+    };
     /// Returns the actual case sensitivity for the specified QuaZIP one.
     /**
       \param cs The value to convert.
@@ -131,6 +140,22 @@ class QUAZIP_EXPORT QuaZip {
     QuaZip(const QuaZip& that);
     // not (and will not be) implemented
     QuaZip& operator=(const QuaZip& that);
+    /// Returns the directory tree of the archive, building it if needed.
+    /**
+      Used by QuaZipDir. The walk moves the current file, so the caller
+      has to restore it. Returns \c NULL if the archive isn't open in
+      mdUnzip mode or its central directory can't be read.
+      */
+    const QuaZipDirTree *getDirTree();
+    /// Makes the entry at \a offset in the central directory current.
+    /**
+      Used by QuaZipDir with the offsets of the directory tree, to get
+      to a given entry when several have the same name. goToNextFile()
+      doesn't work after it, setCurrentFile() or goToFirstFile() does.
+      */
+    bool goToEntryOffset(qint64 offset);
+    /// Returns the mapped archive and its size, \c NULL if it isn't mapped.
+    const uchar *getMappedData(qint64 *size) const;
   public:
     /// Constructs QuaZip object.
     /** Call setName() before opening constructed object. */
@@ -529,6 +554,143 @@ class QUAZIP_EXPORT QuaZip {
       @sa setIoDevice()
       */
     void setAutoClose(bool autoClose) const;
+    /// Enables the persistent name index.
+    /**
+      Locating a file by name with setCurrentFile() has to walk the
+      central directory, and what the walk learns is lost once the
+      archive is closed. With the name index enabled, open() in the
+      mdUnzip mode maps a sidecar file "<zip name>.qzindex" that takes
+      setCurrentFile() straight to the entry, in this and every later
+      process that opens the archive.
+
+      The index is trusted only while the archive size, modification
+      time, central directory position, size and CRC and the file name
+      codec match the ones it was written for. If it's missing or stale,
+      open() walks the central directory once and writes a new one. The
+      central directory is still read once on every open to check its
+      CRC, but it isn't parsed.
+
+      Only archives opened by name can have an index, and it must be
+      enabled before open() is called. The index is disabled by default.
+
+      \sa isNameIndexEnabled()
+      \sa isNameIndexUsed()
+      */
+    void setNameIndexEnabled(bool enabled);
+    /// Returns whether the persistent name index is enabled.
+    /**
+      \sa setNameIndexEnabled()
+      */
+    bool isNameIndexEnabled() const;
+    /// Returns \c true if the archive is open and its name index is mapped.
+    /**
+      \sa setNameIndexEnabled()
+      */
+    bool isNameIndexUsed() const;
+    /// Enables reading the central directory in large blocks.
+    /**
+      Walking the central directory of an archive opened in the mdUnzip
+      mode, for example with goToNextFile() or a name lookup, reads every
+      file header with a seek and a few small reads on the IO device.
+      With buffering enabled, the central directory is read in windows
+      of up to 1 MB (UNZ_CENTRAL_DIR_BUFSIZE in unzip.c) and the headers
+      are parsed from memory, which makes opening and listing large
+      archives much faster while keeping the memory use bounded. If the
+      buffer can't be allocated or read, the headers are read from the
+      device as usual.
+
+      The setting is taken into account by open() and only if no
+      custom \ref open() "ioApi" is given. Buffering is enabled by
+      default.
+
+      \sa isCentralDirBufferingEnabled()
+      */
+    void setCentralDirBufferingEnabled(bool enabled);
+    /// Returns whether the central directory is read in one go.
+    /**
+      \sa setCentralDirBufferingEnabled()
+      */
+    bool isCentralDirBufferingEnabled() const;
+    /// Enables reading the archive through a memory mapping.
+    /**
+      If enabled, open() in the mdUnzip mode maps the whole archive
+      into memory when the device is a QFile, which includes archives
+      opened by name. Headers are then read from the mapping, the
+      inflater takes its input straight from it instead of copying the
+      compressed data into a buffer first, and QuaZipFile::mappedData()
+      gives the contents of stored entries without any copying at all.
+      Encrypted entries are still read the usual way.
+
+      If the file can't be mapped, the archive is read through the
+      device as if mapping was disabled, isMemoryMapped() tells which
+      way it went. The archive must not be truncated by anyone while it
+      is mapped. Mapping is disabled by default.
+
+      \sa isMemoryMappingEnabled()
+      */
+    void setMemoryMappingEnabled(bool enabled);
+    /// Returns whether the archive is mapped when possible.
+    /**
+      \sa setMemoryMappingEnabled()
+      */
+    bool isMemoryMappingEnabled() const;
+    /// Returns \c true if the archive is open and mapped into memory.
+    /**
+      \sa setMemoryMappingEnabled()
+      */
+    bool isMemoryMapped() const;
+    /// Selects the deflate implementation for entries added from now on.
+    /**
+      zlib compresses entries as a stream while they are written.
+      libdeflate is faster and compresses a little better at the same
+      level, but it only works on whole buffers, so with it QuaZipFile
+      keeps each deflated entry in memory until it's closed and
+      compresses it then. Entries larger than 64 MB, raw, encrypted or
+      with a non-default strategy still go through zlib. Either way the
+      archive is an ordinary ZIP file.
+
+      A codec that isn't available falls back to dcZlib. The codec may
+      be changed while the archive is open, the change applies to the
+      next entry opened. The default is dcZlib.
+
+      \sa getDeflateCodec()
+      \sa isDeflateCodecAvailable()
+      */
+    void setDeflateCodec(DeflateCodec codec);
+    /// Returns the deflate implementation for new entries.
+    /**
+      \sa setDeflateCodec()
+      */
+    DeflateCodec getDeflateCodec() const;
+    /// Returns \c true if QuaZIP was built with the codec.
+    static bool isDeflateCodecAvailable(DeflateCodec codec);
+    /// Returns the name and version of the codec, empty if unavailable.
+    static QString getDeflateCodecName(DeflateCodec codec);
+    /// Returns \c true if QuaZIP was built with Zstandard support.
+    /**
+      With \c HAVE_ZSTD defined and libzstd linked, QuaZipFile reads
+      and writes entries of the Z_ZSTD compression method (93).
+      */
+    static bool isZstdAvailable();
+    /// Sets the number of threads that compress Z_ZSTD entries.
+    /**
+      With 0 workers, the default, zstd compresses in the thread that
+      writes the entry. Otherwise an entry larger than a few megabytes
+      is cut into jobs that the workers compress at the same time,
+      smaller entries gain nothing. The threads are started for the
+      first Z_ZSTD entry and kept until the archive is closed. A libzstd
+      built without thread support ignores the setting.
+
+      The setting applies to entries opened from now on.
+
+      \sa getZstdWorkers()
+      */
+    void setZstdWorkers(int workers);
+    /// Returns the number of threads that compress Z_ZSTD entries.
+    /**
+      \sa setZstdWorkers()
+      */
+    int getZstdWorkers() const;
     /// Sets the default file name codec to use.
     /**
      * The default codec is used by the constructors, so calling this function
@@ -2,32 +2,46 @@ INCLUDEPATH += $$PWD
 DEPENDPATH += $$PWD
 HEADERS += \
         $$PWD/crypt.h \
+        $$PWD/checksum.h \
+        $$PWD/deflatecodec.h \
         $$PWD/ioapi.h \
         $$PWD/JlCompress.h \
         $$PWD/quaadler32.h \
         $$PWD/quachecksum32.h \
         $$PWD/quacrc32.h \
         $$PWD/quagzipfile.h \
+        $$PWD/quaparalleldeflater.h \
         $$PWD/quaziodevice.h \
         $$PWD/quazipdir.h \
         $$PWD/quazipfile.h \
         $$PWD/quazipfileinfo.h \
         $$PWD/quazip_global.h \
         $$PWD/quazip.h \
+        $$PWD/quazipdirtree.h \
+        $$PWD/quazipnameindex.h \
         $$PWD/quazipnewinfo.h \
+        $$PWD/quazipsharedarchive.h \
+        $$PWD/quazipsharedfile.h \
         $$PWD/unzip.h \
         $$PWD/zip.h
 
 SOURCES += $$PWD/qioapi.cpp \
+           $$PWD/checksum.c \
+           $$PWD/deflatecodec.c \
            $$PWD/JlCompress.cpp \
            $$PWD/quaadler32.cpp \
            $$PWD/quacrc32.cpp \
            $$PWD/quagzipfile.cpp \
+           $$PWD/quaparalleldeflater.cpp \
            $$PWD/quaziodevice.cpp \
            $$PWD/quazip.cpp \
            $$PWD/quazipdir.cpp \
+           $$PWD/quazipdirtree.cpp \
            $$PWD/quazipfile.cpp \
            $$PWD/quazipfileinfo.cpp \
+           $$PWD/quazipnameindex.cpp \
            $$PWD/quazipnewinfo.cpp \
+           $$PWD/quazipsharedarchive.cpp \
+           $$PWD/quazipsharedfile.cpp \
            $$PWD/unzip.c \
            $$PWD/zip.c
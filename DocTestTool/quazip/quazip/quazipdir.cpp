@@ -23,8 +23,8 @@ see quazip/(un)zip.h files for details. Basically it's the zlib license.
 */
 
 #include "quazipdir.h"
+#include "quazipdirtree.h"
 
-#include <QSet>
 #include <QSharedData>
 
 /// \cond internal
@@ -43,6 +43,7 @@ private:
     template<typename TFileInfoList>
     bool entryInfoList(QStringList nameFilters, QDir::Filters filter,
         QDir::SortFlags sort, TFileInfoList &result) const;
+    bool hasEntry(const QString &name, bool dirOnly) const;
     inline QString simplePath() const {return QDir::cleanPath(dir);}
 };
 /// \endcond
@@ -319,19 +320,30 @@ bool QuaZipDirComparator::operator()(const QuaZipFileInfo64 &info1,
     return (sort & QDir::Reversed) ? !result : result;
 }
 
+static bool QuaZipDir_needsFileInfo(const QStringList &)
+{
+    return false;
+}
+
+template<typename TFileInfoList>
+static bool QuaZipDir_needsFileInfo(const TFileInfoList &)
+{
+    return true;
+}
+
 template<typename TFileInfoList>
 bool QuaZipDirPrivate::entryInfoList(QStringList nameFilters, 
     QDir::Filters filter, QDir::SortFlags sort, TFileInfoList &result) const
 {
-    QString basePath = simplePath();
-    if (!basePath.isEmpty())
-        basePath += "/";
-    int baseLength = basePath.length();
     result.clear();
     QuaZipDirRestoreCurrent saveCurrent(zip);
-    if (!zip->goToFirstFile()) {
+    const QuaZipDirTree *tree = zip->getDirTree();
+    if (tree == NULL) {
         return zip->getZipError() == UNZ_OK;
     }
+    const int dirNode = tree->findDir(simplePath());
+    if (dirNode == -1)
+        return true;
     QDir::Filters fltr = filter;
     if (fltr == QDir::NoFilter)
         fltr = this->filter;
@@ -340,44 +352,48 @@ bool QuaZipDirPrivate::entryInfoList(QStringList nameFilters,
     QStringList nmfltr = nameFilters;
     if (nmfltr.isEmpty())
         nmfltr = this->nameFilters;
-    QSet<QString> dirsFound;
+    QDir::SortFlags srt = sort;
+    if (srt == QDir::NoSort)
+        srt = sorting;
+    const bool sorted = srt != QDir::NoSort
+        && (srt & QDir::Unsorted) != QDir::Unsorted;
+    const QDir::SortFlags order = srt
+        & (QDir::Name | QDir::Time | QDir::Size | QDir::Type);
+    // names alone don't need the central directory records
+    const bool needInfo = QuaZipDir_needsFileInfo(result)
+        || (sorted && (order == QDir::Time || order == QDir::Size));
+    const QList<int> &children = tree->node(dirNode).children;
     QList<QuaZipFileInfo64> list;
-    do {
-        QString name = zip->getCurrentFileName();
-        if (!name.startsWith(basePath))
-            continue;
-        QString relativeName = name.mid(baseLength);
-        if (relativeName.isEmpty())
-            continue;
-        bool isDir = false;
-        bool isReal = true;
-        if (relativeName.contains('/')) {
-            int indexOfSlash = relativeName.indexOf('/');
-            // something like "subdir/"
-            isReal = indexOfSlash == relativeName.length() - 1;
-            relativeName = relativeName.left(indexOfSlash + 1);
-            if (dirsFound.contains(relativeName))
-                continue;
-            isDir = true;
-        }
-        dirsFound.insert(relativeName);
+    for (QList<int>::const_iterator i = children.constBegin();
+            i != children.constEnd();
+            ++i) {
+        const QuaZipDirTree::Node &entry = tree->node(*i);
+        const QString &relativeName = entry.name;
+        bool isDir = relativeName.endsWith('/');
         if ((fltr & QDir::Dirs) == 0 && isDir)
             continue;
         if ((fltr & QDir::Files) == 0 && !isDir)
             continue;
         if (!nmfltr.isEmpty() && !QDir::match(nmfltr, relativeName))
             continue;
+        if (!needInfo) {
+            QuaZipFileInfo64 info;
+            info.name = relativeName;
+            list.append(info);
+            continue;
+        }
+        // by offset, a name could belong to several entries
+        if (entry.isReal && !zip->goToEntryOffset(entry.offset)) {
+            return false;
+        }
         bool ok;
         QuaZipFileInfo64 info = QuaZipDir_getFileInfo(zip, &ok, relativeName,
-            isReal);
+            entry.isReal);
         if (!ok) {
             return false;
         }
         list.append(info);
-    } while (zip->goToNextFile());
-    QDir::SortFlags srt = sort;
-    if (srt == QDir::NoSort)
-        srt = sorting;
+    }
 #ifdef QUAZIP_QUAZIPDIR_DEBUG
     qDebug("QuaZipDirPrivate::entryInfoList(): before sort:");
     foreach (QuaZipFileInfo64 info, list) {
@@ -385,7 +401,7 @@ bool QuaZipDirPrivate::entryInfoList(QStringList nameFilters,
                 info.dateTime.toString(Qt::ISODate).toUtf8().constData());
     }
 #endif
-    if (srt != QDir::NoSort && (srt & QDir::Unsorted) != QDir::Unsorted) {
+    if (sorted) {
         if (QuaZip::convertCaseSensitivity(caseSensitivity)
                 == Qt::CaseInsensitive)
             srt |= QDir::IgnoreCase;
@@ -396,6 +412,32 @@ bool QuaZipDirPrivate::entryInfoList(QStringList nameFilters,
     return true;
 }
 
+bool QuaZipDirPrivate::hasEntry(const QString &name, bool dirOnly) const
+{
+    QuaZipDirRestoreCurrent saveCurrent(zip);
+    const QuaZipDirTree *tree = zip->getDirTree();
+    if (tree == NULL)
+        return false;
+    const int dirNode = tree->findDir(simplePath());
+    if (dirNode == -1)
+        return false;
+    Qt::CaseSensitivity cs = QuaZip::convertCaseSensitivity(caseSensitivity);
+    QStringList candidates;
+    if (!dirOnly)
+        candidates << name;
+    candidates << name + "/";
+    for (QStringList::const_iterator i = candidates.constBegin();
+            i != candidates.constEnd();
+            ++i) {
+        const int child = tree->findChild(dirNode, *i, cs);
+        // same as looking it up in entryList(), the name filters apply
+        if (child != -1 && (nameFilters.isEmpty()
+                    || QDir::match(nameFilters, tree->node(child).name)))
+            return true;
+    }
+    return false;
+}
+
 /// \endcond
 
 QList<QuaZipFileInfo> QuaZipDir::entryInfoList(const QStringList &nameFilters,
@@ -469,25 +511,11 @@ bool QuaZipDir::exists(const QString &filePath) const
         } else if (fileName == ".") {
             return true;
         } else {
-            QStringList entries = entryList(QDir::AllEntries, QDir::NoSort);
 #ifdef QUAZIP_QUAZIPDIR_DEBUG
             qDebug("QuaZipDir::exists(): looking for %s",
                     fileName.toUtf8().constData());
-            for (QStringList::const_iterator i = entries.constBegin();
-                    i != entries.constEnd();
-                    ++i) {
-                qDebug("QuaZipDir::exists(): entry: %s",
-                        i->toUtf8().constData());
-            }
 #endif
-            Qt::CaseSensitivity cs = QuaZip::convertCaseSensitivity(
-                    d->caseSensitivity);
-            if (filePath.endsWith('/')) {
-                return entries.contains(filePath, cs);
-            } else {
-                return entries.contains(fileName, cs)
-                    || entries.contains(fileName + "/", cs);
-            }
+            return d->hasEntry(fileName, filePath.endsWith('/'));
         }
     }
 }
@@ -0,0 +1,108 @@
+/*
+Copyright (C) 2005-2014 Sergey A. Tachenov
+
+This file is part of QuaZIP.
+
+QuaZIP is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 of the License, or
+(at your option) any later version.
+
+QuaZIP is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with QuaZIP.  If not, see <http://www.gnu.org/licenses/>.
+
+See COPYING file for the full LGPL text.
+
+Original ZIP package is copyrighted by Gilles Vollant and contributors,
+see quazip/(un)zip.h files for details. Basically it's the zlib license.
+*/
+
+#include "quazipdirtree.h"
+
+#include <QStringList>
+
+QuaZipDirTree::QuaZipDirTree()
+{
+    Node root;
+    root.isReal = false;
+    root.offset = -1;
+    nodes.append(root);
+}
+
+int QuaZipDirTree::addChild(int dir, const QString &name, qint64 offset)
+{
+    Node child;
+    child.name = name;
+    child.isReal = offset != -1;
+    child.offset = offset;
+    const int index = nodes.size();
+    nodes.append(child);
+    Node &parent = nodes[dir];
+    parent.children.append(index);
+    // an archive may have the same file twice, both are listed with
+    // their own info and the last one wins a lookup, as on extraction
+    parent.lookup.insert(name, index);
+    return index;
+}
+
+void QuaZipDirTree::addPath(const QString &path, qint64 offset)
+{
+    int dir = 0;
+    int start = 0;
+    for (;;) {
+        const int slash = path.indexOf('/', start);
+        if (slash == -1) {
+            if (start < path.length())
+                addChild(dir, path.mid(start), offset);
+            return;
+        }
+        const QString name = path.mid(start, slash - start + 1);
+        // something like "subdir/" is the directory's own entry
+        const qint64 dirOffset = slash == path.length() - 1 ? offset : -1;
+        int child = nodes.at(dir).lookup.value(name, -1);
+        if (child == -1) {
+            child = addChild(dir, name, dirOffset);
+        } else if (dirOffset != -1) {
+            nodes[child].isReal = true;
+            nodes[child].offset = dirOffset;
+        }
+        dir = child;
+        start = slash + 1;
+    }
+}
+
+int QuaZipDirTree::findDir(const QString &path) const
+{
+    int dir = 0;
+    if (path.isEmpty())
+        return dir;
+    const QStringList steps = path.split('/');
+    for (QStringList::const_iterator i = steps.constBegin();
+            i != steps.constEnd();
+            ++i) {
+        dir = nodes.at(dir).lookup.value(*i + "/", -1);
+        if (dir == -1)
+            return -1;
+    }
+    return dir;
+}
+
+int QuaZipDirTree::findChild(int dir, const QString &name,
+                             Qt::CaseSensitivity cs) const
+{
+    const Node &parent = nodes.at(dir);
+    if (cs == Qt::CaseSensitive)
+        return parent.lookup.value(name, -1);
+    for (QList<int>::const_iterator i = parent.children.constBegin();
+            i != parent.children.constEnd();
+            ++i) {
+        if (nodes.at(*i).name.compare(name, cs) == 0)
+            return *i;
+    }
+    return -1;
+}
@@ -0,0 +1,89 @@
+#ifndef QUAZIP_QUAZIPDIRTREE_H
+#define QUAZIP_QUAZIPDIRTREE_H
+
+/*
+Copyright (C) 2005-2014 Sergey A. Tachenov
+
+This file is part of QuaZIP.
+
+QuaZIP is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 of the License, or
+(at your option) any later version.
+
+QuaZIP is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with QuaZIP.  If not, see <http://www.gnu.org/licenses/>.
+
+See COPYING file for the full LGPL text.
+
+Original ZIP package is copyrighted by Gilles Vollant and contributors,
+see quazip/(un)zip.h files for details. Basically it's the zlib license.
+*/
+
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QVector>
+
+/// \cond internal
+/// In-memory tree of the entry paths of a ZIP archive.
+/**
+  \internal
+
+  QuaZip builds it with a single walk over the central directory the
+  first time a QuaZipDir needs it and drops it when the archive is
+  closed, so that listing a directory or checking whether a name exists
+  in it only touches that directory's children.
+
+  Directories that have no entry of their own, but only appear as a
+  part of other entries' paths, are in the tree too.
+  */
+class QuaZipDirTree {
+  public:
+    /// A file or a directory.
+    struct Node {
+      /// The name as QuaZipDir lists it, directories end with a slash.
+      QString name;
+      /// Whether the archive has an entry for this node.
+      bool isReal;
+      /// Central directory offset of the node's entry, -1 if not real.
+      /**
+        A directory with several entries of its own keeps the last one,
+        the same file twice gets a node for each entry.
+        */
+      qint64 offset;
+      /// Indexes of the children, in the order of the archive.
+      QList<int> children;
+      /// Index of the last child with each name.
+      QHash<QString, int> lookup;
+    };
+    /// Constructs a tree that only has the root.
+    QuaZipDirTree();
+    /// Adds an entry path and the directories leading to it.
+    /**
+      \a offset is the entry's offset in the central directory, as
+      returned by unzGetOffset64().
+      */
+    void addPath(const QString &path, qint64 offset);
+    /// Returns the node of the directory \a path, -1 if there is none.
+    /**
+      The path is relative to the root, without a trailing slash, empty
+      for the root itself. It is matched case sensitively.
+      */
+    int findDir(const QString &path) const;
+    /// Returns the child of \a dir called \a name, -1 if there is none.
+    int findChild(int dir, const QString &name, Qt::CaseSensitivity cs) const;
+    /// Returns the node with the index \a index, the root is 0.
+    const Node &node(int index) const {return nodes.at(index);}
+  private:
+    int addChild(int dir, const QString &name, qint64 offset);
+    QVector<Node> nodes;
+};
+/// \endcond
+
+#endif // QUAZIP_QUAZIPDIRTREE_H
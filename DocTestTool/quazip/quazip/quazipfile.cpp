@@ -24,6 +24,8 @@ quazip/(un)zip.h files for details, basically it's zlib license.
 
 #include "quazipfile.h"
 
+#include <limits.h>
+
 using namespace std;
 
 /// The implementation class for QuaZip.
@@ -58,6 +60,8 @@ class QuaZipFilePrivate {
     quint64 uncompressedSize;
     /// CRC to write along with a raw file.
     quint32 crc;
+    /// Where the data of the file opened for reading starts in the archive.
+    quint64 dataPos;
     /// Whether \ref zip points to an internal QuaZip instance.
     /**
       This is true if the archive was opened by name, rather than by
@@ -84,6 +88,7 @@ class QuaZipFilePrivate {
       writePos(0),
       uncompressedSize(0),
       crc(0),
+      dataPos(0),
       internal(true),
       zipError(UNZ_OK) {}
     /// The constructor for the corresponding QuaZipFile constructor.
@@ -94,6 +99,7 @@ class QuaZipFilePrivate {
       writePos(0),
       uncompressedSize(0),
       crc(0),
+      dataPos(0),
       internal(true),
       zipError(UNZ_OK)
       {
@@ -107,6 +113,7 @@ class QuaZipFilePrivate {
       writePos(0),
       uncompressedSize(0),
       crc(0),
+      dataPos(0),
       internal(true),
       zipError(UNZ_OK)
       {
@@ -124,6 +131,7 @@ class QuaZipFilePrivate {
       writePos(0),
       uncompressedSize(0),
       crc(0),
+      dataPos(0),
       internal(false),
       zipError(UNZ_OK) {}
     /// The destructor.
@@ -293,6 +301,7 @@ bool QuaZipFile::open(OpenMode mode, int *method, int *level, bool raw, const ch
     if(p->zipError==UNZ_OK) {
       setOpenMode(mode);
       p->raw=raw;
+      p->dataPos=unzGetCurrentFileZStreamPos64(p->zip->getUnzFile());
       return true;
     } else
       return false;
@@ -483,6 +492,34 @@ void QuaZipFile::close()
   }
 }
 
+void QuaZipFile::closeRaw(qint64 uncompressedSize, quint32 crc)
+{
+  if(!isRaw()) {
+    qWarning("QuaZipFile::closeRaw(): file isn't open in the raw mode");
+    return;
+  }
+  p->uncompressedSize=uncompressedSize;
+  p->crc=crc;
+  close();
+}
+
+void QuaZipFile::discard()
+{
+  p->resetZipError();
+  if(p->zip==NULL||!p->zip->isOpen()) return;
+  if(!isOpen()||(openMode()&WriteOnly)==0) {
+    qWarning("QuaZipFile::discard(): file isn't open for writing");
+    return;
+  }
+  p->setZipError(zipDiscardFileInZip(p->zip->getZipFile()));
+  if(p->zipError==ZIP_OK) setOpenMode(QIODevice::NotOpen);
+  else return;
+  if(p->internal) {
+    p->zip->close();
+    p->setZipError(p->zip->getZipError());
+  }
+}
+
 qint64 QuaZipFile::readData(char *data, qint64 maxSize)
 {
   p->setZipError(UNZ_OK);
@@ -520,6 +557,28 @@ bool QuaZipFile::isRaw() const
   return p->raw;
 }
 
+QByteArray QuaZipFile::mappedData() const
+{
+  if(!isOpen() || (openMode()&WriteOnly))
+    return QByteArray();
+  qint64 mappedSize;
+  const uchar *mapped=p->zip->getMappedData(&mappedSize);
+  if(mapped==NULL)
+    return QByteArray();
+  QuaZipFileInfo64 info;
+  if(!p->zip->getCurrentFileInfo(&info))
+    return QByteArray();
+  // only stored data is the contents as it is
+  if(!p->raw && (info.method!=0 || (info.flags&1)!=0))
+    return QByteArray();
+  const quint64 available=static_cast<quint64>(mappedSize);
+  if(p->dataPos>available || info.compressedSize>available-p->dataPos
+      || info.compressedSize>static_cast<quint64>(INT_MAX))
+    return QByteArray();
+  return QByteArray::fromRawData(reinterpret_cast<const char*>(mapped+p->dataPos),
+      static_cast<int>(info.compressedSize));
+}
+
 int QuaZipFile::getZipError() const
 {
   return p->zipError;
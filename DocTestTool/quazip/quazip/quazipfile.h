@@ -258,6 +258,22 @@ class QUAZIP_EXPORT QuaZipFile: public QIODevice {
      * \sa open(OpenMode,int*,int*,bool,const char*)
      **/
     bool isRaw() const;
+    /// Returns the data of the open file as a view into the mapped archive.
+    /** The returned array doesn't own its data, nothing is copied. It
+     * stays valid until the archive is closed.
+     *
+     * This only works for a file opened for reading from an archive that
+     * \ref QuaZip::isMemoryMapped() "is mapped", and only for a stored
+     * (method 0) file that isn't encrypted. In the raw mode, the view
+     * holds the compressed data of a file of any method. Otherwise a
+     * null array is returned and the file has to be read the usual way.
+     *
+     * Unlike read(), this doesn't check the CRC, nor does it move the
+     * read position.
+     *
+     * \sa QuaZip::setMemoryMappingEnabled()
+     **/
+    QByteArray mappedData() const;
     /// Binds to the existing QuaZip instance.
     /** This function destroys internal QuaZip object, if any, and makes
      * this QuaZipFile to use current file in the \a zip object for any
@@ -323,8 +339,13 @@ class QUAZIP_EXPORT QuaZipFile: public QIODevice {
      * use the raw mode (see below).
      *
      * Arguments \a method and \a level specify compression method and
-     * level. The only method supported is Z_DEFLATED, but you may also
-     * specify 0 for no compression. If all of the files in the archive
+     * level. The methods supported are Z_DEFLATED and, if QuaZIP is
+     * built with \c HAVE_ZSTD, Z_ZSTD (method 93), see
+     * QuaZip::isZstdAvailable(). You may also specify 0 for no
+     * compression. For Z_ZSTD \a level is a zstd level,
+     * Z_DEFAULT_COMPRESSION picks the zstd default. Zstandard entries
+     * can only be read by tools that support method 93, such as recent
+     * versions of 7-Zip and libzip. If all of the files in the archive
      * use both method 0 and either level 0 is explicitly specified or
      * data descriptor writing is disabled with
      * QuaZip::setDataDescriptorWritingEnabled(), then the
@@ -447,6 +468,21 @@ class QUAZIP_EXPORT QuaZipFile: public QIODevice {
     /** Call getZipError() to determine if the close was successful.
      **/
     virtual void close();
+    /// Closes a file opened for writing in the raw mode.
+    /** Same as close(), but takes the CRC and the uncompressed size
+     * here instead of at open(). Useful when the raw data is produced
+     * piece by piece, so the CRC isn't known until the last piece is
+     * written (see crc32_combine() in zlib).
+     **/
+    void closeRaw(qint64 uncompressedSize, quint32 crc);
+    /// Closes a file opened for writing, leaving it out of the archive.
+    /** For an entry that failed halfway, instead of closing it with a
+     * CRC and a size that don't match its data. The data written so far
+     * stays in the archive file, unreferenced. A reader that streams
+     * the archive instead of using the central directory still comes
+     * across it, so this is of no use on a sequential device.
+     **/
+    void discard();
     /// Returns the error code returned by the last ZIP/UNZIP API call.
     int getZipError() const;
     /// Returns the number of bytes available for reading.
@@ -0,0 +1,241 @@
+/*
+Copyright (C) 2005-2014 Sergey A. Tachenov
+
+This file is part of QuaZIP.
+
+QuaZIP is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 of the License, or
+(at your option) any later version.
+
+QuaZIP is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with QuaZIP.  If not, see <http://www.gnu.org/licenses/>.
+
+See COPYING file for the full LGPL text.
+
+Original ZIP package is copyrighted by Gilles Vollant and contributors,
+see quazip/(un)zip.h files for details. Basically it's the zlib license.
+*/
+
+#include "quazipnameindex.h"
+
+#include <QtEndian>
+#if (QT_VERSION >= 0x050100)
+#include <QSaveFile>
+#else
+#include <QTemporaryFile>
+#endif
+
+#include <string.h>
+
+/*
+  The index file, all numbers little endian:
+
+  header (64 bytes):
+    0  "QZNI"
+    4  quint32 version
+    8  quint64 archive size
+   16  qint64  modification time
+   24  quint64 central directory offset
+   32  quint64 central directory size
+   40  quint64 number of entries
+   48  quint32 central directory CRC32
+   52  qint32  file name codec MIB
+   56  quint32 number of slots in each table
+   60  quint32 reserved
+
+  followed by the case sensitive table and the case insensitive table,
+  open addressing with linear probing, each slot is 16 bytes:
+    0  quint32 name hash
+    4  quint32 num_of_file
+    8  quint64 pos_in_zip_directory, 0 for an empty slot since local
+       headers always come before the central directory
+  */
+
+static const char QUAZIP_NAME_INDEX_MAGIC[4] = {'Q', 'Z', 'N', 'I'};
+static const quint32 QUAZIP_NAME_INDEX_VERSION = 1;
+static const int QUAZIP_NAME_INDEX_HEADER_SIZE = 64;
+static const int QUAZIP_NAME_INDEX_SLOT_SIZE = 16;
+
+QuaZipNameIndex::QuaZipNameIndex():
+    data(NULL), buckets(0)
+{
+}
+
+QuaZipNameIndex::~QuaZipNameIndex()
+{
+    close();
+}
+
+QString QuaZipNameIndex::indexPath(const QString &zipName)
+{
+    return zipName + ".qzindex";
+}
+
+quint32 QuaZipNameIndex::hash(const QString &name)
+{
+    // FNV-1a over the UTF-16 code units
+    quint32 h = 2166136261u;
+    const ushort *c = name.utf16();
+    for (int i = 0; i < name.size(); ++i) {
+        h ^= c[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+bool QuaZipNameIndex::open(const QString &indexPath, const Stamp &stamp)
+{
+    close();
+    file.setFileName(indexPath);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+    const qint64 size = file.size();
+    if (size < QUAZIP_NAME_INDEX_HEADER_SIZE) {
+        file.close();
+        return false;
+    }
+    const uchar *header = file.map(0, size);
+    if (header == NULL) {
+        file.close();
+        return false;
+    }
+    const quint32 slots = qFromLittleEndian<quint32>(header + 56);
+    const bool valid =
+        memcmp(header, QUAZIP_NAME_INDEX_MAGIC, 4) == 0
+        && qFromLittleEndian<quint32>(header + 4) == QUAZIP_NAME_INDEX_VERSION
+        && qFromLittleEndian<quint64>(header + 8) == stamp.archiveSize
+        && qFromLittleEndian<qint64>(header + 16) == stamp.modified
+        && qFromLittleEndian<quint64>(header + 24) == stamp.dirOffset
+        && qFromLittleEndian<quint64>(header + 32) == stamp.dirSize
+        && qFromLittleEndian<quint64>(header + 40) == stamp.entries
+        && qFromLittleEndian<quint32>(header + 48) == stamp.dirCrc
+        && qFromLittleEndian<qint32>(header + 52) == stamp.codecMib
+        && slots != 0 && (slots & (slots - 1)) == 0
+        && size == QUAZIP_NAME_INDEX_HEADER_SIZE
+            + 2 * static_cast<qint64>(slots) * QUAZIP_NAME_INDEX_SLOT_SIZE;
+    if (!valid) {
+        file.unmap(const_cast<uchar*>(header));
+        file.close();
+        return false;
+    }
+    data = header;
+    buckets = slots;
+    return true;
+}
+
+void QuaZipNameIndex::close()
+{
+    if (data != NULL) {
+        file.unmap(const_cast<uchar*>(data));
+        data = NULL;
+        buckets = 0;
+    }
+    if (file.isOpen())
+        file.close();
+}
+
+QList<unz64_file_pos> QuaZipNameIndex::candidates(const QString &key,
+                                                 bool caseSensitive) const
+{
+    QList<unz64_file_pos> result;
+    if (data == NULL)
+        return result;
+    const uchar *table = data + QUAZIP_NAME_INDEX_HEADER_SIZE;
+    if (!caseSensitive)
+        table += static_cast<qint64>(buckets) * QUAZIP_NAME_INDEX_SLOT_SIZE;
+    const quint32 h = hash(key);
+    const quint32 mask = buckets - 1;
+    // tables are at most half full, so an empty slot ends the probe long
+    // before it wraps around, the bound only guards against a damaged file
+    quint32 i = h & mask;
+    for (quint32 probes = 0; probes < buckets; ++probes, i = (i + 1) & mask) {
+        const uchar *slot = table + static_cast<qint64>(i) * QUAZIP_NAME_INDEX_SLOT_SIZE;
+        const quint64 position = qFromLittleEndian<quint64>(slot + 8);
+        if (position == 0)
+            break;
+        if (qFromLittleEndian<quint32>(slot) == h) {
+            unz64_file_pos pos;
+            pos.pos_in_zip_directory = position;
+            pos.num_of_file = qFromLittleEndian<quint32>(slot + 4);
+            result.append(pos);
+        }
+    }
+    return result;
+}
+
+static void writeNameIndexTable(uchar *table, quint32 buckets,
+                                const QHash<QString, unz64_file_pos> &map)
+{
+    const quint32 mask = buckets - 1;
+    for (QHash<QString, unz64_file_pos>::const_iterator it = map.constBegin();
+            it != map.constEnd(); ++it) {
+        const quint32 h = QuaZipNameIndex::hash(it.key());
+        quint32 i = h & mask;
+        while (qFromLittleEndian<quint64>(table + static_cast<qint64>(i) * QUAZIP_NAME_INDEX_SLOT_SIZE + 8) != 0)
+            i = (i + 1) & mask;
+        uchar *slot = table + static_cast<qint64>(i) * QUAZIP_NAME_INDEX_SLOT_SIZE;
+        qToLittleEndian<quint32>(h, slot);
+        qToLittleEndian<quint32>(static_cast<quint32>(it.value().num_of_file), slot + 4);
+        qToLittleEndian<quint64>(it.value().pos_in_zip_directory, slot + 8);
+    }
+}
+
+bool QuaZipNameIndex::write(const QString &indexPath, const Stamp &stamp,
+                            const QHash<QString, unz64_file_pos> &caseSensitive,
+                            const QHash<QString, unz64_file_pos> &caseInsensitive)
+{
+    if (stamp.entries > 0xFFFFFFFFu)
+        return false;
+    quint32 slots = 16;
+    const int entries = qMax(caseSensitive.size(), caseInsensitive.size());
+    while (slots < 2u * static_cast<quint32>(entries))
+        slots *= 2;
+    QByteArray index(QUAZIP_NAME_INDEX_HEADER_SIZE
+            + 2 * static_cast<int>(slots) * QUAZIP_NAME_INDEX_SLOT_SIZE, '\0');
+    uchar *header = reinterpret_cast<uchar*>(index.data());
+    memcpy(header, QUAZIP_NAME_INDEX_MAGIC, 4);
+    qToLittleEndian<quint32>(QUAZIP_NAME_INDEX_VERSION, header + 4);
+    qToLittleEndian<quint64>(stamp.archiveSize, header + 8);
+    qToLittleEndian<qint64>(stamp.modified, header + 16);
+    qToLittleEndian<quint64>(stamp.dirOffset, header + 24);
+    qToLittleEndian<quint64>(stamp.dirSize, header + 32);
+    qToLittleEndian<quint64>(stamp.entries, header + 40);
+    qToLittleEndian<quint32>(stamp.dirCrc, header + 48);
+    qToLittleEndian<qint32>(stamp.codecMib, header + 52);
+    qToLittleEndian<quint32>(slots, header + 56);
+    uchar *table = header + QUAZIP_NAME_INDEX_HEADER_SIZE;
+    writeNameIndexTable(table, slots, caseSensitive);
+    writeNameIndexTable(table + static_cast<qint64>(slots) * QUAZIP_NAME_INDEX_SLOT_SIZE,
+                        slots, caseInsensitive);
+    // written aside under a unique name and renamed, so a reader never
+    // maps half an index and two writers don't share a temporary file
+#if (QT_VERSION >= 0x050100)
+    QSaveFile tmp(indexPath);
+    if (!tmp.open(QIODevice::WriteOnly))
+        return false;
+    if (tmp.write(index) != index.size()) {
+        tmp.cancelWriting();
+        return false;
+    }
+    return tmp.commit();
+#else
+    QTemporaryFile tmp(indexPath + ".XXXXXX");
+    if (!tmp.open() || tmp.write(index) != index.size())
+        return false;
+    tmp.close();
+    QFile::remove(indexPath);
+    // a renamed file would be removed as well
+    tmp.setAutoRemove(false);
+    if (!tmp.rename(indexPath)) {
+        tmp.remove();
+        return false;
+    }
+    return true;
+#endif
+}
@@ -0,0 +1,98 @@
+#ifndef QUAZIP_QUAZIPNAMEINDEX_H
+#define QUAZIP_QUAZIPNAMEINDEX_H
+
+/*
+Copyright (C) 2005-2014 Sergey A. Tachenov
+
+This file is part of QuaZIP.
+
+QuaZIP is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 of the License, or
+(at your option) any later version.
+
+QuaZIP is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with QuaZIP.  If not, see <http://www.gnu.org/licenses/>.
+
+See COPYING file for the full LGPL text.
+
+Original ZIP package is copyrighted by Gilles Vollant and contributors,
+see quazip/(un)zip.h files for details. Basically it's the zlib license.
+*/
+
+#include <QFile>
+#include <QHash>
+#include <QList>
+#include <QString>
+
+#include "unzip.h"
+
+/// \cond internal
+/// Persistent index of the entry names of a ZIP archive.
+/**
+  \internal
+
+  Maps hashes of entry names to their positions in the central
+  directory, so that an archive opened again by another process can
+  locate its entries without walking and decoding the whole central
+  directory. The index is kept in a sidecar file next to the archive
+  and is memory-mapped while the archive is open.
+
+  The index is only trusted while the Stamp it was written with still
+  matches the archive. Hashes may collide, so every candidate position
+  has to be checked against the actual entry name.
+  */
+class QuaZipNameIndex {
+  public:
+    /// What the index was built for, it's stale once any of this changes.
+    struct Stamp {
+      quint64 archiveSize;
+      qint64 modified; ///< Modification time, milliseconds since the epoch.
+      quint64 dirOffset; ///< Central directory position.
+      quint64 dirSize; ///< Central directory size.
+      quint64 entries;
+      quint32 dirCrc; ///< CRC32 of the central directory bytes.
+      qint32 codecMib; ///< MIB of the codec that decoded the names.
+    };
+    /// Constructs a closed index.
+    QuaZipNameIndex();
+    /// Unmaps the index.
+    ~QuaZipNameIndex();
+    /// Maps the index file if it was written for \a stamp.
+    bool open(const QString &indexPath, const Stamp &stamp);
+    /// Unmaps the index.
+    void close();
+    /// Returns \c true if the index is mapped.
+    bool isOpen() const {return data != NULL;}
+    /// Returns the positions of the entries that may be called \a key.
+    /**
+      For a case insensitive lookup \a key must be lower case already.
+      */
+    QList<unz64_file_pos> candidates(const QString &key,
+                                     bool caseSensitive) const;
+    /// Writes an index of both name maps of an archive.
+    /**
+      The maps are the ones QuaZip fills while walking the central
+      directory, the case insensitive one has lower case keys.
+      */
+    static bool write(const QString &indexPath, const Stamp &stamp,
+                      const QHash<QString, unz64_file_pos> &caseSensitive,
+                      const QHash<QString, unz64_file_pos> &caseInsensitive);
+    /// Returns the sidecar path for the archive \a zipName.
+    static QString indexPath(const QString &zipName);
+    /// Name hash that doesn't change between processes, unlike qHash().
+    static quint32 hash(const QString &name);
+  private:
+    Q_DISABLE_COPY(QuaZipNameIndex)
+    QFile file;
+    const uchar *data;
+    quint32 buckets; ///< Slots in each of the two tables.
+};
+/// \endcond
+
+#endif // QUAZIP_QUAZIPNAMEINDEX_H
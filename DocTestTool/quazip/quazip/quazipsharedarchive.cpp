@@ -0,0 +1,233 @@
+/*
+Copyright (C) 2005-2014 Sergey A. Tachenov
+
+This file is part of QuaZIP.
+
+QuaZIP is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 of the License, or
+(at your option) any later version.
+
+QuaZIP is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with QuaZIP.  If not, see <http://www.gnu.org/licenses/>.
+
+See COPYING file for the full LGPL text.
+
+Original ZIP package is copyrighted by Gilles Vollant and contributors,
+see quazip/(un)zip.h files for details. Basically it's the zlib license.
+*/
+
+#include "quazipsharedarchive.h"
+
+#include <QFile>
+#include <QHash>
+#include <QVector>
+
+/// \cond internal
+class QuaZipSharedArchivePrivate {
+  friend class QuaZipSharedArchive;
+  private:
+    inline QuaZipSharedArchivePrivate(const QString &zipName):
+      zipName(zipName),
+      mapped(NULL),
+      size(0),
+      zipError(UNZ_OK),
+      open(false),
+      deflateCodec(QuaZip::dcZlib) {}
+    /// The archive file name.
+    QString zipName;
+    /// The archive file, kept open while it's mapped.
+    QFile file;
+    /// The mapped archive, or \c NULL.
+    const uchar *mapped;
+    /// The size of the mapped archive.
+    qint64 size;
+    /// The files, in the central directory order.
+    QList<QuaZipFileInfo64> entries;
+    /// The local header positions of the files.
+    QVector<quint64> localHeaders;
+    /// The first file with each name.
+    QHash<QString, int> caseSensitive;
+    /// The first file with each lower case name.
+    QHash<QString, int> caseInsensitive;
+    /// The last error.
+    int zipError;
+    /// Whether the archive is open.
+    bool open;
+    /// The codec the readers decompress with.
+    QuaZip::DeflateCodec deflateCodec;
+    /// Forgets the entries.
+    void clear();
+};
+/// \endcond
+
+void QuaZipSharedArchivePrivate::clear()
+{
+    entries.clear();
+    localHeaders.clear();
+    caseSensitive.clear();
+    caseInsensitive.clear();
+}
+
+QuaZipSharedArchive::QuaZipSharedArchive(const QString &zipName):
+    p(new QuaZipSharedArchivePrivate(zipName))
+{
+}
+
+QuaZipSharedArchive::~QuaZipSharedArchive()
+{
+    if (isOpen())
+        close();
+    delete p;
+}
+
+bool QuaZipSharedArchive::open()
+{
+    if (p->open) {
+        qWarning("QuaZipSharedArchive::open(): already opened");
+        return false;
+    }
+    p->zipError = UNZ_OK;
+    QuaZip zip(p->zipName);
+    if (!zip.open(QuaZip::mdUnzip)) {
+        p->zipError = zip.getZipError() != UNZ_OK
+            ? zip.getZipError() : UNZ_OPENERROR;
+        return false;
+    }
+    // there is no first file to go to in an empty archive
+    if (zip.getEntriesCount() > 0) {
+        for (bool more = zip.goToFirstFile(); more; more = zip.goToNextFile()) {
+            QuaZipFileInfo64 info;
+            if (!zip.getCurrentFileInfo(&info))
+                break;
+            const int index = p->entries.size();
+            p->entries.append(info);
+            p->localHeaders.append(
+                unzGetCurrentFileLocalHeaderOffset64(zip.getUnzFile()));
+            if (!p->caseSensitive.contains(info.name))
+                p->caseSensitive.insert(info.name, index);
+            const QString lower = info.name.toLower();
+            if (!p->caseInsensitive.contains(lower))
+                p->caseInsensitive.insert(lower, index);
+        }
+    }
+    p->zipError = zip.getZipError();
+    zip.close();
+    if (p->zipError != UNZ_OK) {
+        p->clear();
+        return false;
+    }
+    p->file.setFileName(p->zipName);
+    if (p->file.open(QIODevice::ReadOnly)) {
+        p->size = p->file.size();
+        p->mapped = p->file.map(0, p->size);
+        if (p->mapped == NULL) {
+            // the readers open the file on their own
+            p->size = 0;
+            p->file.close();
+        }
+    }
+    p->open = true;
+    return true;
+}
+
+void QuaZipSharedArchive::close()
+{
+    if (!p->open) {
+        qWarning("QuaZipSharedArchive::close(): not open");
+        return;
+    }
+    if (p->mapped != NULL) {
+        p->file.unmap(const_cast<uchar*>(p->mapped));
+        p->mapped = NULL;
+        p->size = 0;
+    }
+    if (p->file.isOpen())
+        p->file.close();
+    p->clear();
+    p->open = false;
+}
+
+bool QuaZipSharedArchive::isOpen() const
+{
+    return p->open;
+}
+
+bool QuaZipSharedArchive::isMapped() const
+{
+    return p->mapped != NULL;
+}
+
+QString QuaZipSharedArchive::getZipName() const
+{
+    return p->zipName;
+}
+
+int QuaZipSharedArchive::getZipError() const
+{
+    return p->zipError;
+}
+
+int QuaZipSharedArchive::getEntriesCount() const
+{
+    return p->entries.size();
+}
+
+QuaZipFileInfo64 QuaZipSharedArchive::getFileInfo(int index) const
+{
+    if (index < 0 || index >= p->entries.size())
+        return QuaZipFileInfo64();
+    return p->entries.at(index);
+}
+
+QList<QuaZipFileInfo64> QuaZipSharedArchive::getFileInfoList64() const
+{
+    return p->entries;
+}
+
+QStringList QuaZipSharedArchive::getFileNameList() const
+{
+    QStringList names;
+    for (QList<QuaZipFileInfo64>::const_iterator i = p->entries.constBegin();
+            i != p->entries.constEnd();
+            ++i) {
+        names.append(i->name);
+    }
+    return names;
+}
+
+int QuaZipSharedArchive::indexOf(const QString &fileName,
+                                 QuaZip::CaseSensitivity cs) const
+{
+    if (QuaZip::convertCaseSensitivity(cs) == Qt::CaseSensitive)
+        return p->caseSensitive.value(fileName, -1);
+    return p->caseInsensitive.value(fileName.toLower(), -1);
+}
+
+void QuaZipSharedArchive::setDeflateCodec(QuaZip::DeflateCodec codec)
+{
+    p->deflateCodec = QuaZip::isDeflateCodecAvailable(codec)
+        ? codec : QuaZip::dcZlib;
+}
+
+QuaZip::DeflateCodec QuaZipSharedArchive::getDeflateCodec() const
+{
+    return p->deflateCodec;
+}
+
+const uchar *QuaZipSharedArchive::getMappedData(qint64 *size) const
+{
+    if (size != NULL)
+        *size = p->size;
+    return p->mapped;
+}
+
+quint64 QuaZipSharedArchive::getLocalHeaderOffset(int index) const
+{
+    return p->localHeaders.at(index);
+}
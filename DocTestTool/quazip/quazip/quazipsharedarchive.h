@@ -0,0 +1,131 @@
+#ifndef QUAZIP_QUAZIPSHAREDARCHIVE_H
+#define QUAZIP_QUAZIPSHAREDARCHIVE_H
+
+
+/*
+Copyright (C) 2005-2014 Sergey A. Tachenov
+
+This file is part of QuaZIP.
+
+QuaZIP is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 of the License, or
+(at your option) any later version.
+
+QuaZIP is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with QuaZIP.  If not, see <http://www.gnu.org/licenses/>.
+
+See COPYING file for the full LGPL text.
+
+Original ZIP package is copyrighted by Gilles Vollant and contributors,
+see quazip/(un)zip.h files for details. Basically it's the zlib license.
+*/
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+#include "quazip_global.h"
+#include "quazip.h"
+#include "quazipfileinfo.h"
+
+class QuaZipSharedArchivePrivate;
+
+/// A read-only ZIP archive that many threads can read at once.
+/** \class QuaZipSharedArchive quazipsharedarchive.h <quazip/quazipsharedarchive.h>
+  QuaZip has a single current file. Reading several files of one
+  archive at the same time therefore takes a QuaZip instance for each
+  of them, and each instance parses the central directory again.
+
+  QuaZipSharedArchive parses the central directory once, in open(), and
+  doesn't change after that. Any number of QuaZipSharedFile readers, in
+  any threads, can then read its files concurrently. Where possible the
+  archive is memory-mapped and the readers read the mapping. Otherwise
+  every reader opens a file handle of its own. Either way the readers
+  don't share a file position, so they don't contend for one.
+
+  The const functions are thread-safe while the archive is open. open()
+  and close() are not. The archive must stay open until all of its
+  readers are closed.
+
+  Only archives opened by name are supported. Files are read with the
+  default file name codec of QuaZip.
+
+  \sa QuaZipSharedFile
+  */
+class QUAZIP_EXPORT QuaZipSharedArchive {
+  friend class QuaZipSharedFile;
+  public:
+    /// Constructs an archive object for the file \a zipName.
+    explicit QuaZipSharedArchive(const QString &zipName);
+    /// Closes the archive if it's open.
+    ~QuaZipSharedArchive();
+    /// Parses the central directory and maps the archive.
+    /**
+      Returns \c false and sets the error code if the archive can't be
+      read. An archive that can't be mapped can still be opened.
+      */
+    bool open();
+    /// Unmaps the archive and forgets its entries.
+    void close();
+    /// Returns \c true if the archive is open.
+    bool isOpen() const;
+    /// Returns \c true if the archive is open and memory-mapped.
+    bool isMapped() const;
+    /// Returns the archive file name.
+    QString getZipName() const;
+    /// Returns the error code of the last open() call.
+    int getZipError() const;
+    /// Returns the number of files in the archive.
+    int getEntriesCount() const;
+    /// Returns information about the file number \a index.
+    /**
+      The files are numbered in the central directory order, starting
+      from 0.
+      */
+    QuaZipFileInfo64 getFileInfo(int index) const;
+    /// Returns information about all files, in the central directory order.
+    QList<QuaZipFileInfo64> getFileInfoList64() const;
+    /// Returns the names of all files, in the central directory order.
+    QStringList getFileNameList() const;
+    /// Returns the number of the file called \a fileName, -1 if there is none.
+    /**
+      If there are several files with the same name, returns the first
+      of them.
+      */
+    int indexOf(const QString &fileName,
+                QuaZip::CaseSensitivity cs = QuaZip::csDefault) const;
+    /// Selects the deflate implementation the readers decompress with.
+    /**
+      With QuaZip::dcLibdeflate a reader of a mapped archive decompresses
+      a deflated file of up to 64 MB in one go on its first read, either
+      straight into the caller's buffer if the whole file fits or into a
+      buffer of its own. Larger files, and all files of an archive that
+      isn't mapped, are inflated by zlib as usual. The result is the same
+      either way.
+
+      A codec that isn't available falls back to QuaZip::dcZlib, which is
+      the default. Readers take the setting when they are opened, so it
+      must not be changed while readers are being opened in other
+      threads.
+
+      \sa QuaZip::setDeflateCodec()
+      */
+    void setDeflateCodec(QuaZip::DeflateCodec codec);
+    /// Returns the deflate implementation the readers decompress with.
+    QuaZip::DeflateCodec getDeflateCodec() const;
+  private:
+    Q_DISABLE_COPY(QuaZipSharedArchive)
+    /// Returns the mapping of the archive and its size, or \c NULL.
+    const uchar *getMappedData(qint64 *size) const;
+    /// Returns the position of the local header of the file number \a index.
+    quint64 getLocalHeaderOffset(int index) const;
+    QuaZipSharedArchivePrivate *p;
+};
+
+#endif // QUAZIP_QUAZIPSHAREDARCHIVE_H
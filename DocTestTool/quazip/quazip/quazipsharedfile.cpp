@@ -0,0 +1,480 @@
+/*
+Copyright (C) 2005-2014 Sergey A. Tachenov
+
+This file is part of QuaZIP.
+
+QuaZIP is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 of the License, or
+(at your option) any later version.
+
+QuaZIP is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with QuaZIP.  If not, see <http://www.gnu.org/licenses/>.
+
+See COPYING file for the full LGPL text.
+
+Original ZIP package is copyrighted by Gilles Vollant and contributors,
+see quazip/(un)zip.h files for details. Basically it's the zlib license.
+*/
+
+#include "quazipsharedfile.h"
+
+#include "quazipsharedarchive.h"
+#include "checksum.h"
+#include "deflatecodec.h"
+
+#include <QFile>
+#include <QtEndian>
+
+#include <zlib.h>
+
+#include <string.h>
+
+// the largest file decompressed in one go by a whole buffer codec
+#define QUAZIP_SHARED_WHOLE_MAX (64 * 1024 * 1024)
+
+/// \cond internal
+class QuaZipSharedFilePrivate {
+  friend class QuaZipSharedFile;
+  private:
+    QuaZipSharedFilePrivate(const QuaZipSharedArchive *archive, int index):
+      archive(archive),
+      index(index),
+      mapped(NULL),
+      archiveSize(0),
+      dataPos(0),
+      compressedRead(0),
+      uncompressedRead(0),
+      crc(0),
+      wholeCodec(QUAZIP_CODEC_ZLIB),
+      wholePos(0),
+      inflating(false),
+#ifdef HAVE_ZSTD
+      zstd(NULL),
+#endif
+      finished(false),
+      zipError(UNZ_OK)
+    {
+        memset(&stream, 0, sizeof(stream));
+    }
+    /// The archive.
+    const QuaZipSharedArchive *archive;
+    /// The file number in the archive, -1 if there's no such file.
+    int index;
+    /// The file information.
+    QuaZipFileInfo64 info;
+    /// The archive mapping, shared with other readers, or \c NULL.
+    const uchar *mapped;
+    /// The archive size.
+    qint64 archiveSize;
+    /// Own handle of the archive, used when it isn't mapped.
+    QFile file;
+    /// Compressed data read from the file.
+    QByteArray input;
+    /// The position of the compressed data in the archive.
+    quint64 dataPos;
+    /// The compressed bytes consumed so far.
+    quint64 compressedRead;
+    /// The uncompressed bytes produced so far.
+    quint64 uncompressedRead;
+    /// The CRC of the uncompressed bytes so far.
+    uLong crc;
+    /// The whole buffer codec for the first read, zlib if there's none.
+    int wholeCodec;
+    /// The whole file, if it didn't fit the buffer of the first read.
+    QByteArray whole;
+    /// The bytes of \ref whole returned so far.
+    int wholePos;
+    /// The inflate state, for deflated files.
+    z_stream stream;
+    /// Whether the inflate state is initialized.
+    bool inflating;
+#ifdef HAVE_ZSTD
+    /// The zstd state, for Zstandard files.
+    ZSTD_DCtx *zstd;
+#endif
+    /// Whether inflate has reached the end of the stream.
+    bool finished;
+    /// The last error.
+    int zipError;
+    /// Copies \a len bytes at \a pos of the archive into \a buf.
+    bool readAt(quint64 pos, char *buf, qint64 len);
+    /// Points the inflate input to the next piece of compressed data.
+    bool fetchInput();
+    /// Decompresses the whole file with wholeCodec on the first read.
+    qint64 readWhole(char *data, qint64 maxSize);
+#ifdef HAVE_ZSTD
+    /// Decompresses a Zstandard file, stream holds the input.
+    qint64 readZstd(char *data, qint64 maxSize);
+#endif
+    /// Sets zipError and prints a warning.
+    void setError(int error, const char *what);
+};
+/// \endcond
+
+bool QuaZipSharedFilePrivate::readAt(quint64 pos, char *buf, qint64 len)
+{
+    if (mapped != NULL) {
+        if (pos > static_cast<quint64>(archiveSize)
+                || static_cast<quint64>(len) > archiveSize - pos)
+            return false;
+        memcpy(buf, mapped + pos, static_cast<size_t>(len));
+        return true;
+    }
+    return file.seek(static_cast<qint64>(pos)) && file.read(buf, len) == len;
+}
+
+bool QuaZipSharedFilePrivate::fetchInput()
+{
+    const quint64 left = info.compressedSize - compressedRead;
+    if (mapped != NULL) {
+        // zlib counts in uInt, a huge file is fed in pieces
+        const quint64 chunk = qMin<quint64>(left, 0x40000000u);
+        stream.next_in = const_cast<Bytef*>(
+            reinterpret_cast<const Bytef*>(mapped + dataPos + compressedRead));
+        stream.avail_in = static_cast<uInt>(chunk);
+        compressedRead += chunk;
+        return true;
+    }
+    const qint64 chunk = static_cast<qint64>(qMin<quint64>(left, 0x10000u));
+    input.resize(static_cast<int>(chunk));
+    if (!readAt(dataPos + compressedRead, input.data(), chunk))
+        return false;
+    stream.next_in = reinterpret_cast<Bytef*>(input.data());
+    stream.avail_in = static_cast<uInt>(chunk);
+    compressedRead += chunk;
+    return true;
+}
+
+qint64 QuaZipSharedFilePrivate::readWhole(char *data, qint64 maxSize)
+{
+    if (whole.isEmpty()) {
+        const int codec = wholeCodec;
+        wholeCodec = QUAZIP_CODEC_ZLIB;
+        const int size = static_cast<int>(info.uncompressedSize);
+        char *out = data;
+        if (maxSize < size) {
+            whole.resize(size);
+            out = whole.data();
+        }
+        if (quazip_codec_decompress(codec, QUAZIP_FORMAT_RAW,
+                    mapped + dataPos, static_cast<size_t>(info.compressedSize),
+                    out, static_cast<size_t>(size)) != Z_OK) {
+            // nothing is consumed yet, let inflate have a go and report
+            whole.clear();
+            return -1;
+        }
+        compressedRead = info.compressedSize;
+        finished = true;
+        wholePos = 0;
+        if (out == data) {
+            uncompressedRead = size;
+            crc = quazip_crc32(crc, reinterpret_cast<const unsigned char*>(data),
+                               static_cast<size_t>(size));
+            return size;
+        }
+    }
+    const int n = static_cast<int>(qMin<qint64>(maxSize, whole.size() - wholePos));
+    memcpy(data, whole.constData() + wholePos, n);
+    crc = quazip_crc32(crc, reinterpret_cast<const unsigned char*>(data),
+                       static_cast<size_t>(n));
+    uncompressedRead += n;
+    wholePos += n;
+    if (wholePos == whole.size())
+        whole.clear();
+    return n;
+}
+
+#ifdef HAVE_ZSTD
+qint64 QuaZipSharedFilePrivate::readZstd(char *data, qint64 maxSize)
+{
+    ZSTD_outBuffer out;
+    out.dst = data;
+    out.size = static_cast<size_t>(qMin<qint64>(maxSize, 0x40000000));
+    out.pos = 0;
+    while (out.pos < out.size && !finished) {
+        if (stream.avail_in == 0) {
+            if (compressedRead == info.compressedSize) {
+                setError(UNZ_BADZIPFILE, "truncated compressed data");
+                return -1;
+            }
+            if (!fetchInput()) {
+                zipError = UNZ_ERRNO;
+                return -1;
+            }
+        }
+        ZSTD_inBuffer in;
+        in.src = stream.next_in;
+        in.size = stream.avail_in;
+        in.pos = 0;
+        const size_t ret = ZSTD_decompressStream(zstd, &out, &in);
+        if (ZSTD_isError(ret)) {
+            setError(UNZ_BADZIPFILE, ZSTD_getErrorName(ret));
+            return -1;
+        }
+        stream.next_in += in.pos;
+        stream.avail_in -= static_cast<uInt>(in.pos);
+        if (ret == 0)
+            finished = true;
+    }
+    uncompressedRead += out.pos;
+    crc = quazip_crc32(crc, reinterpret_cast<const unsigned char*>(data),
+                       out.pos);
+    return static_cast<qint64>(out.pos);
+}
+#endif
+
+void QuaZipSharedFilePrivate::setError(int error, const char *what)
+{
+    zipError = error;
+    qWarning("QuaZipSharedFile: %s", what);
+}
+
+QuaZipSharedFile::QuaZipSharedFile(const QuaZipSharedArchive *archive,
+                                   int index, QObject *parent):
+    QIODevice(parent),
+    p(new QuaZipSharedFilePrivate(archive, index))
+{
+}
+
+QuaZipSharedFile::QuaZipSharedFile(const QuaZipSharedArchive *archive,
+                                   const QString &fileName,
+                                   QuaZip::CaseSensitivity cs,
+                                   QObject *parent):
+    QIODevice(parent),
+    p(new QuaZipSharedFilePrivate(archive, archive->indexOf(fileName, cs)))
+{
+}
+
+QuaZipSharedFile::~QuaZipSharedFile()
+{
+    if (isOpen())
+        close();
+    delete p;
+}
+
+bool QuaZipSharedFile::open(OpenMode mode)
+{
+    p->zipError = UNZ_OK;
+    if (isOpen()) {
+        qWarning("QuaZipSharedFile::open(): already opened");
+        return false;
+    }
+    if (mode != ReadOnly) {
+        qWarning("QuaZipSharedFile::open(): only ReadOnly mode is supported");
+        return false;
+    }
+    if (!p->archive->isOpen()) {
+        qWarning("QuaZipSharedFile::open(): archive is not open");
+        return false;
+    }
+    if (p->index < 0 || p->index >= p->archive->getEntriesCount()) {
+        p->zipError = UNZ_END_OF_LIST_OF_FILE;
+        return false;
+    }
+    p->info = p->archive->getFileInfo(p->index);
+    if ((p->info.flags & 1) != 0) {
+        p->setError(UNZ_BADZIPFILE, "encrypted files are not supported");
+        return false;
+    }
+    if (p->info.method != 0 && p->info.method != Z_DEFLATED
+#ifdef HAVE_ZSTD
+            && p->info.method != Z_ZSTD
+#endif
+            ) {
+        p->setError(UNZ_BADZIPFILE, "unsupported compression method");
+        return false;
+    }
+    p->mapped = p->archive->getMappedData(&p->archiveSize);
+    if (p->mapped == NULL) {
+        p->file.setFileName(p->archive->getZipName());
+        if (!p->file.open(QIODevice::ReadOnly)) {
+            p->zipError = UNZ_ERRNO;
+            return false;
+        }
+        p->archiveSize = p->file.size();
+    }
+    // the local header has a name and an extra field of its own, they
+    // may differ from the ones in the central directory
+    const quint64 header = p->archive->getLocalHeaderOffset(p->index);
+    uchar local[30];
+    if (!p->readAt(header, reinterpret_cast<char*>(local), sizeof(local))
+            || qFromLittleEndian<quint32>(local) != 0x04034b50) {
+        p->setError(UNZ_BADZIPFILE, "bad local file header");
+        p->file.close();
+        return false;
+    }
+    p->dataPos = header + sizeof(local)
+        + qFromLittleEndian<quint16>(local + 26)
+        + qFromLittleEndian<quint16>(local + 28);
+    if (p->dataPos > static_cast<quint64>(p->archiveSize)
+            || p->info.compressedSize > p->archiveSize - p->dataPos) {
+        p->setError(UNZ_BADZIPFILE, "file data past the end of the archive");
+        p->file.close();
+        return false;
+    }
+    p->compressedRead = 0;
+    p->uncompressedRead = 0;
+    p->crc = crc32(0L, Z_NULL, 0);
+    p->finished = false;
+    if (p->info.method == Z_DEFLATED) {
+        memset(&p->stream, 0, sizeof(p->stream));
+        if (inflateInit2(&p->stream, -MAX_WBITS) != Z_OK) {
+            p->setError(UNZ_INTERNALERROR, "inflateInit2() failed");
+            p->file.close();
+            return false;
+        }
+        p->inflating = true;
+        p->wholeCodec = QUAZIP_CODEC_ZLIB;
+        if (p->mapped != NULL && p->info.uncompressedSize > 0
+                && p->info.uncompressedSize <= QUAZIP_SHARED_WHOLE_MAX
+                && p->archive->getDeflateCodec() != QuaZip::dcZlib)
+            p->wholeCodec = p->archive->getDeflateCodec();
+    }
+#ifdef HAVE_ZSTD
+    if (p->info.method == Z_ZSTD) {
+        memset(&p->stream, 0, sizeof(p->stream));
+        p->zstd = ZSTD_createDCtx();
+        if (p->zstd == NULL) {
+            p->setError(UNZ_INTERNALERROR, "ZSTD_createDCtx() failed");
+            p->file.close();
+            return false;
+        }
+    }
+#endif
+    return QIODevice::open(mode);
+}
+
+void QuaZipSharedFile::close()
+{
+    if (!isOpen()) {
+        qWarning("QuaZipSharedFile::close(): file isn't open");
+        return;
+    }
+    p->zipError = UNZ_OK;
+    if (p->uncompressedRead == p->info.uncompressedSize
+            && p->crc != p->info.crc)
+        p->zipError = UNZ_CRCERROR;
+    if (p->inflating) {
+        inflateEnd(&p->stream);
+        p->inflating = false;
+    }
+#ifdef HAVE_ZSTD
+    ZSTD_freeDCtx(p->zstd);
+    p->zstd = NULL;
+#endif
+    if (p->file.isOpen())
+        p->file.close();
+    p->input.clear();
+    p->whole.clear();
+    QIODevice::close();
+}
+
+bool QuaZipSharedFile::isSequential() const
+{
+    return true;
+}
+
+qint64 QuaZipSharedFile::size() const
+{
+    return static_cast<qint64>(p->info.uncompressedSize);
+}
+
+bool QuaZipSharedFile::atEnd() const
+{
+    if (!isOpen())
+        return true;
+    return QIODevice::bytesAvailable() == 0
+        && p->uncompressedRead >= p->info.uncompressedSize;
+}
+
+qint64 QuaZipSharedFile::bytesAvailable() const
+{
+    if (!isOpen())
+        return 0;
+    const quint64 left = p->uncompressedRead < p->info.uncompressedSize
+        ? p->info.uncompressedSize - p->uncompressedRead : 0;
+    return static_cast<qint64>(left) + QIODevice::bytesAvailable();
+}
+
+QuaZipFileInfo64 QuaZipSharedFile::getFileInfo() const
+{
+    return p->info;
+}
+
+int QuaZipSharedFile::getZipError() const
+{
+    return p->zipError;
+}
+
+qint64 QuaZipSharedFile::readData(char *data, qint64 maxSize)
+{
+    p->zipError = UNZ_OK;
+    if (p->info.method == 0) {
+        const qint64 n = static_cast<qint64>(qMin<quint64>(
+            static_cast<quint64>(qMin<qint64>(maxSize, 0x40000000)),
+            p->info.compressedSize - p->compressedRead));
+        if (n == 0)
+            return 0;
+        if (!p->readAt(p->dataPos + p->compressedRead, data, n)) {
+            p->zipError = UNZ_ERRNO;
+            return -1;
+        }
+        p->compressedRead += n;
+        p->uncompressedRead += n;
+        p->crc = quazip_crc32(p->crc, reinterpret_cast<const unsigned char*>(data),
+                              static_cast<size_t>(n));
+        return n;
+    }
+#ifdef HAVE_ZSTD
+    if (p->info.method == Z_ZSTD)
+        return p->readZstd(data, maxSize);
+#endif
+    if (p->wholeCodec != QUAZIP_CODEC_ZLIB || !p->whole.isEmpty()) {
+        const qint64 n = p->readWhole(data, maxSize);
+        if (n >= 0)
+            return n;
+    }
+    if (p->finished)
+        return 0;
+    const uInt wanted = static_cast<uInt>(qMin<qint64>(maxSize, 0x40000000));
+    p->stream.next_out = reinterpret_cast<Bytef*>(data);
+    p->stream.avail_out = wanted;
+    while (p->stream.avail_out > 0) {
+        if (p->stream.avail_in == 0) {
+            if (p->compressedRead == p->info.compressedSize) {
+                p->setError(UNZ_BADZIPFILE, "truncated compressed data");
+                return -1;
+            }
+            if (!p->fetchInput()) {
+                p->zipError = UNZ_ERRNO;
+                return -1;
+            }
+        }
+        const int err = inflate(&p->stream, Z_SYNC_FLUSH);
+        if (err == Z_STREAM_END) {
+            p->finished = true;
+            break;
+        }
+        if (err != Z_OK) {
+            p->zipError = err;
+            return -1;
+        }
+    }
+    const uInt produced = wanted - p->stream.avail_out;
+    p->uncompressedRead += produced;
+    p->crc = quazip_crc32(p->crc, reinterpret_cast<const unsigned char*>(data),
+                          produced);
+    return produced;
+}
+
+qint64 QuaZipSharedFile::writeData(const char *, qint64)
+{
+    qWarning("QuaZipSharedFile::writeData(): the file is read-only");
+    return -1;
+}
@@ -0,0 +1,98 @@
+#ifndef QUAZIP_QUAZIPSHAREDFILE_H
+#define QUAZIP_QUAZIPSHAREDFILE_H
+
+
+/*
+Copyright (C) 2005-2014 Sergey A. Tachenov
+
+This file is part of QuaZIP.
+
+QuaZIP is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation, either version 2.1 of the License, or
+(at your option) any later version.
+
+QuaZIP is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with QuaZIP.  If not, see <http://www.gnu.org/licenses/>.
+
+See COPYING file for the full LGPL text.
+
+Original ZIP package is copyrighted by Gilles Vollant and contributors,
+see quazip/(un)zip.h files for details. Basically it's the zlib license.
+*/
+
+#include <QIODevice>
+
+#include "quazip_global.h"
+#include "quazip.h"
+#include "quazipfileinfo.h"
+
+class QuaZipSharedArchive;
+class QuaZipSharedFilePrivate;
+
+/// Reads a file of a QuaZipSharedArchive.
+/** \class QuaZipSharedFile quazipsharedfile.h <quazip/quazipsharedfile.h>
+  Every reader keeps its own position and decompression state and
+  reads the archive with positional reads, so readers of the same
+  archive can run in parallel threads. A single reader, like any
+  QIODevice, must only be used by one thread at a time.
+
+  The device is sequential and read-only. Stored and deflated files
+  are supported, and Zstandard ones if QuaZIP is built with
+  \c HAVE_ZSTD. Encrypted files are not. The CRC is checked when the
+  whole file has been read, a mismatch is reported by close() through
+  getZipError().
+
+  The archive must stay open while the reader is open.
+  */
+class QUAZIP_EXPORT QuaZipSharedFile: public QIODevice {
+  public:
+    /// Constructs a reader for the file number \a index of \a archive.
+    QuaZipSharedFile(const QuaZipSharedArchive *archive, int index,
+                     QObject *parent = NULL);
+    /// Constructs a reader for the file \a fileName of \a archive.
+    /**
+      The name is looked up at once, open() fails if there is no such
+      file.
+      */
+    QuaZipSharedFile(const QuaZipSharedArchive *archive,
+                     const QString &fileName,
+                     QuaZip::CaseSensitivity cs = QuaZip::csDefault,
+                     QObject *parent = NULL);
+    /// Closes the file if it's open.
+    virtual ~QuaZipSharedFile();
+    /// Opens the file for reading.
+    /**
+      Only QIODevice::ReadOnly is supported, QIODevice::Text is not.
+      */
+    virtual bool open(OpenMode mode);
+    /// Closes the file and checks its CRC if it has been read to the end.
+    virtual void close();
+    /// Returns \c true, the file can only be read in order.
+    virtual bool isSequential() const;
+    /// Returns the uncompressed size of the file.
+    virtual qint64 size() const;
+    /// Returns \c true if the whole file has been read.
+    virtual bool atEnd() const;
+    /// Returns the number of bytes left to read.
+    virtual qint64 bytesAvailable() const;
+    /// Returns information about the file.
+    QuaZipFileInfo64 getFileInfo() const;
+    /// Returns the error code of the last operation.
+    int getZipError() const;
+  protected:
+    /// Implementation of the QIODevice::readData().
+    qint64 readData(char *data, qint64 maxSize);
+    /// Fails, the file is read-only.
+    qint64 writeData(const char *data, qint64 maxSize);
+  private:
+    Q_DISABLE_COPY(QuaZipSharedFile)
+    QuaZipSharedFilePrivate *p;
+};
+
+#endif // QUAZIP_QUAZIPSHAREDFILE_H
@@ -76,6 +76,7 @@
 typedef uLongf z_crc_t;
 #endif
 #include "unzip.h"
+#include "checksum.h"
 
 #ifdef STDC
 #  include <stddef.h>
@@ -106,6 +107,10 @@ typedef uLongf z_crc_t;
 #define UNZ_BUFSIZE (16384)
 #endif
 
+#ifndef UNZ_CENTRAL_DIR_BUFSIZE
+#define UNZ_CENTRAL_DIR_BUFSIZE (1024*1024)
+#endif
+
 #ifndef UNZ_MAXFILENAMEINZIP
 #define UNZ_MAXFILENAMEINZIP (256)
 #endif
@@ -141,6 +146,9 @@ typedef struct
 #ifdef HAVE_BZIP2
     bz_stream bstream;          /* bzLib stream structure for bziped */
 #endif
+#ifdef HAVE_ZSTD
+    ZSTD_DCtx* zstream;         /* zstd context for Z_ZSTD entries */
+#endif
 
     ZPOS64_T pos_in_zipfile;       /* position in byte on the zipfile, for fseek*/
     uLong stream_initialised;   /* flag set if stream structure is initialised*/
@@ -189,6 +197,15 @@ typedef struct
     int isZip64;
     unsigned flags;
 
+    unsigned char* central_dir_buffer; /* a window on the central directory,
+                                   if buffering is on, or NULL */
+    ZPOS64_T central_dir_buffer_pos; /* offset of the window in the
+                                   central directory */
+    uLong central_dir_buffer_size; /* bytes of the directory in the window */
+    const unsigned char* mapped_data; /* the whole archive mapped in memory
+                                   by the caller, or NULL */
+    ZPOS64_T mapped_size;
+
 #    ifndef NOUNCRYPT
     unsigned long keys[3];     /* keys defining the pseudo-random sequence */
     const z_crc_t FAR * pcrc_32_tab;
@@ -575,6 +592,54 @@ local ZPOS64_T unz64local_SearchCentralDir64(const zlib_filefunc64_32_def* pzlib
     return relativeOffset;
 }
 
+/*
+  Fill the central directory window with up to UNZ_CENTRAL_DIR_BUFSIZE
+  bytes of the directory starting at offset, with a single seek and
+  read. Return UNZ_OK, or UNZ_ERRNO with the window emptied.
+*/
+local int unz64local_FillCentralDir OF((unz64_s* s, ZPOS64_T offset));
+local int unz64local_FillCentralDir (unz64_s* s, ZPOS64_T offset)
+{
+    ZPOS64_T rest = s->size_central_dir - offset;
+    uLong size = (rest < UNZ_CENTRAL_DIR_BUFSIZE) ?
+                 (uLong)rest : UNZ_CENTRAL_DIR_BUFSIZE;
+
+    s->central_dir_buffer_pos = offset;
+    s->central_dir_buffer_size = 0;
+    if ((ZSEEK64(s->z_filefunc, s->filestream,
+                 s->offset_central_dir + offset + s->byte_before_the_zipfile,
+                 ZLIB_FILEFUNC_SEEK_SET) != 0) ||
+        (ZREAD64(s->z_filefunc, s->filestream,
+                 s->central_dir_buffer, size) != size))
+        return UNZ_ERRNO;
+    s->central_dir_buffer_size = size;
+    return UNZ_OK;
+}
+
+/*
+  Allocate the central directory window and fill it with the start of
+  the directory, so that walking it costs a read per window instead of
+  a few device calls per entry. Leaves the buffer NULL if it can't be
+  allocated or read, the headers are then read from the file as usual.
+*/
+local void unz64local_ReadCentralDir OF((unz64_s* s));
+local void unz64local_ReadCentralDir (unz64_s* s)
+{
+    uLong size = (s->size_central_dir < UNZ_CENTRAL_DIR_BUFSIZE) ?
+                 (uLong)s->size_central_dir : UNZ_CENTRAL_DIR_BUFSIZE;
+
+    if (size == 0)
+        return;
+    s->central_dir_buffer = (unsigned char*)ALLOC(size);
+    if (s->central_dir_buffer == NULL)
+        return;
+    if (unz64local_FillCentralDir(s, 0) != UNZ_OK)
+    {
+        TRYFREE(s->central_dir_buffer);
+        s->central_dir_buffer = NULL;
+    }
+}
+
 /*
   Open a Zip file. path contain the full pathname (by example,
      on a Windows NT computer "c:\\test\\zlib114.zip" or on an Unix computer
@@ -757,6 +822,13 @@ extern unzFile unzOpenInternal (voidpf file,
     us.central_pos = central_pos;
     us.pfile_in_zip_read = NULL;
     us.encrypted = 0;
+    us.central_dir_buffer = NULL;
+    us.central_dir_buffer_pos = 0;
+    us.central_dir_buffer_size = 0;
+    us.mapped_data = NULL;
+    us.mapped_size = 0;
+    if ((us.flags & UNZ_BUFFER_CENTRAL_DIR) != 0)
+        unz64local_ReadCentralDir(&us);
 
 
     s=(unz64_s*)ALLOC(sizeof(unz64_s));
@@ -765,6 +837,8 @@ extern unzFile unzOpenInternal (voidpf file,
         *s=us;
         unzGoToFirstFile((unzFile)s);
     }
+    else
+        TRYFREE(us.central_dir_buffer);
     return (unzFile)s;
 }
 
@@ -826,6 +900,7 @@ extern int ZEXPORT unzClose (unzFile file)
         ZCLOSE64(s->z_filefunc, s->filestream);
     else
         ZFAKECLOSE64(s->z_filefunc, s->filestream);
+    TRYFREE(s->central_dir_buffer);
     TRYFREE(s);
     return UNZ_OK;
 }
@@ -872,6 +947,212 @@ local void unz64local_DosDateToTmuDate (ZPOS64_T ulDosDate, tm_unz* ptm)
     ptm->tm_sec =  (uInt) (2*(ulDosDate&0x1f)) ;
 }
 
+/*
+  Little endian numbers from the central directory buffer
+*/
+local uLong unz64local_bufferShort OF((const unsigned char* p));
+local uLong unz64local_bufferShort (const unsigned char* p)
+{
+    return (uLong)p[0] | ((uLong)p[1] << 8);
+}
+
+local uLong unz64local_bufferLong OF((const unsigned char* p));
+local uLong unz64local_bufferLong (const unsigned char* p)
+{
+    return unz64local_bufferShort(p) | (unz64local_bufferShort(p + 2) << 16);
+}
+
+local ZPOS64_T unz64local_bufferLong64 OF((const unsigned char* p));
+local ZPOS64_T unz64local_bufferLong64 (const unsigned char* p)
+{
+    return (ZPOS64_T)unz64local_bufferLong(p) |
+           ((ZPOS64_T)unz64local_bufferLong(p + 4) << 32);
+}
+
+/*
+  Return the current file header in the central directory window,
+  moving the window to the header first if it doesn't lie entirely in
+  it. Return NULL if there is no buffer, the window can't be filled or
+  the header doesn't fit in a window starting at it, which leaves a
+  damaged directory or a huge header to the file reading code.
+*/
+local const unsigned char* unz64local_BufferedHeader OF((unz64_s* s));
+local const unsigned char* unz64local_BufferedHeader (unz64_s* s)
+{
+    const unsigned char* p;
+    ZPOS64_T offset;
+    ZPOS64_T rest;
+    ZPOS64_T size;
+    int refilled = 0;
+
+    if ((s->central_dir_buffer == NULL) ||
+        (s->pos_in_central_dir < s->offset_central_dir))
+        return NULL;
+    offset = s->pos_in_central_dir - s->offset_central_dir;
+    if ((offset > s->size_central_dir) ||
+        (s->size_central_dir - offset < SIZECENTRALDIRITEM))
+        return NULL;
+    for (;;)
+    {
+        if ((offset >= s->central_dir_buffer_pos) &&
+            (offset - s->central_dir_buffer_pos + SIZECENTRALDIRITEM <=
+             s->central_dir_buffer_size))
+        {
+            p = s->central_dir_buffer + (offset - s->central_dir_buffer_pos);
+            rest = s->central_dir_buffer_size -
+                   (offset - s->central_dir_buffer_pos) - SIZECENTRALDIRITEM;
+            size = (ZPOS64_T)unz64local_bufferShort(p + 28) +
+                   unz64local_bufferShort(p + 30) +
+                   unz64local_bufferShort(p + 32);
+            if (rest >= size)
+                return p;
+        }
+        if (refilled ||
+            (unz64local_FillCentralDir(s, offset) != UNZ_OK))
+            return NULL;
+        refilled = 1;
+    }
+}
+
+/*
+  Same as unz64local_GetCurrentFileInfoInternal, from a header that
+  unz64local_BufferedHeader found in the central directory buffer
+*/
+local int unz64local_GetBufferedFileInfo OF((const unsigned char* p,
+                                             unz_file_info64 *pfile_info,
+                                             unz_file_info64_internal
+                                             *pfile_info_internal,
+                                             char *szFileName,
+                                             uLong fileNameBufferSize,
+                                             void *extraField,
+                                             uLong extraFieldBufferSize,
+                                             char *szComment,
+                                             uLong commentBufferSize));
+
+local int unz64local_GetBufferedFileInfo (const unsigned char* p,
+                                          unz_file_info64 *pfile_info,
+                                          unz_file_info64_internal
+                                          *pfile_info_internal,
+                                          char *szFileName,
+                                          uLong fileNameBufferSize,
+                                          void *extraField,
+                                          uLong extraFieldBufferSize,
+                                          char *szComment,
+                                          uLong commentBufferSize)
+{
+    unz_file_info64 file_info;
+    unz_file_info64_internal file_info_internal;
+    const unsigned char* extra;
+    const unsigned char* comment;
+    uLong acc = 0;
+
+    if (unz64local_bufferLong(p) != 0x02014b50)
+        return UNZ_BADZIPFILE;
+
+    file_info.version = unz64local_bufferShort(p + 4);
+    file_info.version_needed = unz64local_bufferShort(p + 6);
+    file_info.flag = unz64local_bufferShort(p + 8);
+    file_info.compression_method = unz64local_bufferShort(p + 10);
+    file_info.dosDate = unz64local_bufferLong(p + 12);
+    unz64local_DosDateToTmuDate(file_info.dosDate,&file_info.tmu_date);
+    file_info.crc = unz64local_bufferLong(p + 16);
+    file_info.compressed_size = unz64local_bufferLong(p + 20);
+    file_info.uncompressed_size = unz64local_bufferLong(p + 24);
+    file_info.size_filename = unz64local_bufferShort(p + 28);
+    file_info.size_file_extra = unz64local_bufferShort(p + 30);
+    file_info.size_file_comment = unz64local_bufferShort(p + 32);
+    file_info.disk_num_start = unz64local_bufferShort(p + 34);
+    file_info.internal_fa = unz64local_bufferShort(p + 36);
+    file_info.external_fa = unz64local_bufferLong(p + 38);
+    file_info_internal.offset_curfile = unz64local_bufferLong(p + 42);
+
+    p += SIZECENTRALDIRITEM;
+    extra = p + file_info.size_filename;
+    comment = extra + file_info.size_file_extra;
+
+    if (szFileName!=NULL)
+    {
+        uLong uSizeRead ;
+        if (file_info.size_filename<fileNameBufferSize)
+        {
+            *(szFileName+file_info.size_filename)='\0';
+            uSizeRead = file_info.size_filename;
+        }
+        else
+            uSizeRead = fileNameBufferSize;
+        if ((file_info.size_filename>0) && (fileNameBufferSize>0))
+            memcpy(szFileName, p, uSizeRead);
+    }
+
+    if (extraField!=NULL)
+    {
+        uLong uSizeRead ;
+        if (file_info.size_file_extra<extraFieldBufferSize)
+            uSizeRead = file_info.size_file_extra;
+        else
+            uSizeRead = extraFieldBufferSize;
+        if ((file_info.size_file_extra>0) && (extraFieldBufferSize>0))
+            memcpy(extraField, extra, uSizeRead);
+    }
+
+    /* the ZIP64 values that don't fit the header, a record running past
+       the extra field ends the parsing */
+    while (acc + 4 <= file_info.size_file_extra)
+    {
+        const unsigned char* field = extra + acc;
+        uLong headerId = unz64local_bufferShort(field);
+        uLong dataSize = unz64local_bufferShort(field + 2);
+        if (acc + 4 + dataSize > file_info.size_file_extra)
+            break;
+        if (headerId == 0x0001)
+        {
+            const unsigned char* value = field + 4;
+            const unsigned char* valueEnd = value + dataSize;
+            if ((file_info.uncompressed_size == (ZPOS64_T)0xFFFFFFFFu) &&
+                (value + 8 <= valueEnd))
+            {
+                file_info.uncompressed_size = unz64local_bufferLong64(value);
+                value += 8;
+            }
+            if ((file_info.compressed_size == (ZPOS64_T)0xFFFFFFFFu) &&
+                (value + 8 <= valueEnd))
+            {
+                file_info.compressed_size = unz64local_bufferLong64(value);
+                value += 8;
+            }
+            if ((file_info_internal.offset_curfile == (ZPOS64_T)0xFFFFFFFFu) &&
+                (value + 8 <= valueEnd))
+            {
+                /* Relative Header offset */
+                file_info_internal.offset_curfile = unz64local_bufferLong64(value);
+            }
+        }
+        acc += 4 + dataSize;
+    }
+
+    if (szComment!=NULL)
+    {
+        uLong uSizeRead ;
+        if (file_info.size_file_comment<commentBufferSize)
+        {
+            *(szComment+file_info.size_file_comment)='\0';
+            uSizeRead = file_info.size_file_comment;
+        }
+        else
+            uSizeRead = commentBufferSize;
+        if ((file_info.size_file_comment>0) && (commentBufferSize>0))
+            memcpy(szComment, comment, uSizeRead);
+    }
+
+    if (pfile_info!=NULL)
+        *pfile_info=file_info;
+
+    if (pfile_info_internal!=NULL)
+        *pfile_info_internal=file_info_internal;
+
+    return UNZ_OK;
+}
+
 /*
   Get Info about the current file in the zipfile, with internal only info
 */
@@ -908,6 +1189,15 @@ local int unz64local_GetCurrentFileInfoInternal (unzFile file,
     if (file==NULL)
         return UNZ_PARAMERROR;
     s=(unz64_s*)file;
+    {
+        const unsigned char* header = unz64local_BufferedHeader(s);
+        if (header != NULL)
+            return unz64local_GetBufferedFileInfo(header,
+                                                  pfile_info, pfile_info_internal,
+                                                  szFileName, fileNameBufferSize,
+                                                  extraField, extraFieldBufferSize,
+                                                  szComment, commentBufferSize);
+    }
     if (ZSEEK64(s->z_filefunc, s->filestream,
               s->pos_in_central_dir+s->byte_before_the_zipfile,
               ZLIB_FILEFUNC_SEEK_SET)!=0)
@@ -1434,6 +1724,9 @@ local int unz64local_CheckCurrentFileCoherencyHeader (unz64_s* s, uInt* piSizeVa
 /* #ifdef HAVE_BZIP2 */
                          (s->cur_file_info.compression_method!=Z_BZIP2ED) &&
 /* #endif */
+#ifdef HAVE_ZSTD
+                         (s->cur_file_info.compression_method!=Z_ZSTD) &&
+#endif
                          (s->cur_file_info.compression_method!=Z_DEFLATED))
         err=UNZ_BADZIPFILE;
 
@@ -1541,6 +1834,9 @@ extern int ZEXPORT unzOpenCurrentFile3 (unzFile file, int* method,
 /* #ifdef HAVE_BZIP2 */
         (s->cur_file_info.compression_method!=Z_BZIP2ED) &&
 /* #endif */
+#ifdef HAVE_ZSTD
+        (s->cur_file_info.compression_method!=Z_ZSTD) &&
+#endif
         (s->cur_file_info.compression_method!=Z_DEFLATED))
 
         err=UNZ_BADZIPFILE;
@@ -1581,6 +1877,23 @@ extern int ZEXPORT unzOpenCurrentFile3 (unzFile file, int* method,
       pfile_in_zip_read_info->raw=1;
 #endif
     }
+#ifdef HAVE_ZSTD
+    else if ((s->cur_file_info.compression_method==Z_ZSTD) && (!raw))
+    {
+      pfile_in_zip_read_info->stream.next_in = 0;
+      pfile_in_zip_read_info->stream.avail_in = 0;
+
+      pfile_in_zip_read_info->zstream = ZSTD_createDCtx();
+      if (pfile_in_zip_read_info->zstream != NULL)
+        pfile_in_zip_read_info->stream_initialised=Z_ZSTD;
+      else
+      {
+        TRYFREE(pfile_in_zip_read_info->read_buffer);
+        TRYFREE(pfile_in_zip_read_info);
+        return UNZ_INTERNALERROR;
+      }
+    }
+#endif
     else if ((s->cur_file_info.compression_method==Z_DEFLATED) && (!raw))
     {
       pfile_in_zip_read_info->stream.zalloc = (alloc_func)0;
@@ -1679,6 +1992,34 @@ extern ZPOS64_T ZEXPORT unzGetCurrentFileZStreamPos64( unzFile file)
 
 /** Addition for GDAL : END */
 
+/*
+  Point the input of the current file straight at its data in the mapped
+  archive, instead of reading it into read_buffer. Nothing is done without
+  a mapping or when the data has to be decrypted in place.
+*/
+local void unz64local_MapCurrentFileInput OF((unz64_s* s));
+local void unz64local_MapCurrentFileInput (unz64_s* s)
+{
+    file_in_zip64_read_info_s* pfile_in_zip_read_info = s->pfile_in_zip_read;
+    ZPOS64_T pos;
+    ZPOS64_T available;
+
+    if ((s->mapped_data == NULL) || (s->encrypted))
+        return;
+    pos = pfile_in_zip_read_info->pos_in_zipfile +
+          pfile_in_zip_read_info->byte_before_the_zipfile;
+    available = pfile_in_zip_read_info->rest_read_compressed;
+    if ((pos > s->mapped_size) || (s->mapped_size - pos < available))
+        return;
+    /* avail_in is an uInt */
+    if (available > 0x40000000u)
+        available = 0x40000000u;
+    pfile_in_zip_read_info->stream.next_in = (Bytef*)(s->mapped_data + pos);
+    pfile_in_zip_read_info->stream.avail_in = (uInt)available;
+    pfile_in_zip_read_info->pos_in_zipfile += available;
+    pfile_in_zip_read_info->rest_read_compressed -= available;
+}
+
 /*
   Read bytes from the current file.
   buf contain buffer where data must be copied
@@ -1727,6 +2068,10 @@ extern int ZEXPORT unzReadCurrentFile  (unzFile file, voidp buf, unsigned len)
 
     while (pfile_in_zip_read_info->stream.avail_out>0)
     {
+        if ((pfile_in_zip_read_info->stream.avail_in==0) &&
+            (pfile_in_zip_read_info->rest_read_compressed>0))
+            unz64local_MapCurrentFileInput(s);
+
         if ((pfile_in_zip_read_info->stream.avail_in==0) &&
             (pfile_in_zip_read_info->rest_read_compressed>0))
         {
@@ -1771,7 +2116,7 @@ extern int ZEXPORT unzReadCurrentFile  (unzFile file, voidp buf, unsigned len)
 
         if ((pfile_in_zip_read_info->compression_method==0) || (pfile_in_zip_read_info->raw))
         {
-            uInt uDoCopy,i ;
+            uInt uDoCopy ;
 
             if ((pfile_in_zip_read_info->stream.avail_in == 0) &&
                 (pfile_in_zip_read_info->rest_read_compressed == 0))
@@ -1783,13 +2128,12 @@ extern int ZEXPORT unzReadCurrentFile  (unzFile file, voidp buf, unsigned len)
             else
                 uDoCopy = pfile_in_zip_read_info->stream.avail_in ;
 
-            for (i=0;i<uDoCopy;i++)
-                *(pfile_in_zip_read_info->stream.next_out+i) =
-                        *(pfile_in_zip_read_info->stream.next_in+i);
+            memcpy(pfile_in_zip_read_info->stream.next_out,
+                   pfile_in_zip_read_info->stream.next_in, uDoCopy);
 
             pfile_in_zip_read_info->total_out_64 = pfile_in_zip_read_info->total_out_64 + uDoCopy;
 
-            pfile_in_zip_read_info->crc32 = crc32(pfile_in_zip_read_info->crc32,
+            pfile_in_zip_read_info->crc32 = quazip_crc32(pfile_in_zip_read_info->crc32,
                                 pfile_in_zip_read_info->stream.next_out,
                                 uDoCopy);
             pfile_in_zip_read_info->rest_read_uncompressed-=uDoCopy;
@@ -1826,7 +2170,7 @@ extern int ZEXPORT unzReadCurrentFile  (unzFile file, voidp buf, unsigned len)
 
             pfile_in_zip_read_info->total_out_64 = pfile_in_zip_read_info->total_out_64 + uOutThis;
 
-            pfile_in_zip_read_info->crc32 = crc32(pfile_in_zip_read_info->crc32,bufBefore, (uInt)(uOutThis));
+            pfile_in_zip_read_info->crc32 = quazip_crc32(pfile_in_zip_read_info->crc32,bufBefore, (uInt)(uOutThis));
             pfile_in_zip_read_info->rest_read_uncompressed -= uOutThis;
             iRead += (uInt)(uTotalOutAfter - uTotalOutBefore);
 
@@ -1843,6 +2187,57 @@ extern int ZEXPORT unzReadCurrentFile  (unzFile file, voidp buf, unsigned len)
               break;
 #endif
         } /* end Z_BZIP2ED */
+#ifdef HAVE_ZSTD
+        else if (pfile_in_zip_read_info->compression_method==Z_ZSTD)
+        {
+            ZSTD_inBuffer in;
+            ZSTD_outBuffer out;
+            size_t ret;
+            uInt uOutThis;
+
+            in.src = pfile_in_zip_read_info->stream.next_in;
+            in.size = pfile_in_zip_read_info->stream.avail_in;
+            in.pos = 0;
+            out.dst = pfile_in_zip_read_info->stream.next_out;
+            out.size = pfile_in_zip_read_info->stream.avail_out;
+            out.pos = 0;
+
+            ret = ZSTD_decompressStream(pfile_in_zip_read_info->zstream, &out, &in);
+            if (ZSTD_isError(ret))
+            {
+                err = Z_DATA_ERROR;
+                break;
+            }
+            uOutThis = (uInt)out.pos;
+
+            pfile_in_zip_read_info->total_out_64 = pfile_in_zip_read_info->total_out_64 + uOutThis;
+
+            pfile_in_zip_read_info->crc32
+                    = quazip_crc32(pfile_in_zip_read_info->crc32,
+                                   pfile_in_zip_read_info->stream.next_out, uOutThis);
+
+            pfile_in_zip_read_info->rest_read_uncompressed -= uOutThis;
+            iRead += uOutThis;
+
+            pfile_in_zip_read_info->stream.next_in += in.pos;
+            pfile_in_zip_read_info->stream.avail_in -= (uInt)in.pos;
+            pfile_in_zip_read_info->stream.total_in += (uLong)in.pos;
+            pfile_in_zip_read_info->stream.next_out += uOutThis;
+            pfile_in_zip_read_info->stream.avail_out -= uOutThis;
+            pfile_in_zip_read_info->stream.total_out += uOutThis;
+
+            if (ret == 0)
+                return (iRead==0) ? UNZ_EOF : iRead;
+            /* the frame wants more input than the entry has */
+            if (in.pos == 0 && uOutThis == 0
+                    && pfile_in_zip_read_info->stream.avail_in == 0
+                    && pfile_in_zip_read_info->rest_read_compressed == 0)
+            {
+                err = Z_DATA_ERROR;
+                break;
+            }
+        }
+#endif
         else
         {
             uInt uAvailOutBefore,uAvailOutAfter;
@@ -1864,7 +2259,7 @@ extern int ZEXPORT unzReadCurrentFile  (unzFile file, voidp buf, unsigned len)
             pfile_in_zip_read_info->total_out_64 = pfile_in_zip_read_info->total_out_64 + uOutThis;
 
             pfile_in_zip_read_info->crc32
-                    = crc32(pfile_in_zip_read_info->crc32,bufBefore, uOutThis);
+                    = quazip_crc32(pfile_in_zip_read_info->crc32,bufBefore, uOutThis);
 
             pfile_in_zip_read_info->rest_read_uncompressed -= uOutThis;
 
@@ -2032,6 +2427,10 @@ extern int ZEXPORT unzCloseCurrentFile (unzFile file)
     else if (pfile_in_zip_read_info->stream_initialised == Z_BZIP2ED)
         BZ2_bzDecompressEnd(&pfile_in_zip_read_info->bstream);
 #endif
+#ifdef HAVE_ZSTD
+    else if (pfile_in_zip_read_info->stream_initialised == Z_ZSTD)
+        ZSTD_freeDCtx(pfile_in_zip_read_info->zstream);
+#endif
 
 
     pfile_in_zip_read_info->stream_initialised = 0;
@@ -2145,3 +2544,39 @@ int ZEXPORT unzClearFlags(unzFile file, unsigned flags)
     s->flags &= ~flags;
     return UNZ_OK;
 }
+
+
+int ZEXPORT unzSetMappedData(unzFile file, const void* data, ZPOS64_T size)
+{
+    unz64_s* s;
+    if (file == NULL)
+        return UNZ_PARAMERROR;
+    s = (unz64_s*)file;
+    s->mapped_data = (const unsigned char*)data;
+    s->mapped_size = data != NULL ? size : 0;
+    return UNZ_OK;
+}
+
+int ZEXPORT unzGetCentralDirInfo64(unzFile file, ZPOS64_T* offset, ZPOS64_T* size)
+{
+    unz64_s* s;
+    if (file == NULL)
+        return UNZ_PARAMERROR;
+    s = (unz64_s*)file;
+    if (offset != NULL)
+        *offset = s->offset_central_dir + s->byte_before_the_zipfile;
+    if (size != NULL)
+        *size = s->size_central_dir;
+    return UNZ_OK;
+}
+
+ZPOS64_T ZEXPORT unzGetCurrentFileLocalHeaderOffset64(unzFile file)
+{
+    unz64_s* s;
+    if (file == NULL)
+        return 0;
+    s = (unz64_s*)file;
+    if (!s->current_file_ok)
+        return 0;
+    return s->cur_file_info_internal.offset_curfile + s->byte_before_the_zipfile;
+}
@@ -64,7 +64,12 @@ extern "C" {
 #include "bzlib.h"
 #endif
 
+#ifdef HAVE_ZSTD
+#include "zstd.h"
+#endif
+
 #define Z_BZIP2ED 12
+#define Z_ZSTD 93
 
 #if defined(STRICTUNZIP) || defined(STRICTZIPUNZIP)
 /* like the STRICT of WIN32, we define a pointer that cannot be converted
@@ -86,6 +91,10 @@ typedef voidp unzFile;
 #define UNZ_CRCERROR                    (-105)
 
 #define UNZ_AUTO_CLOSE 0x01u
+/* read the central directory in windows of UNZ_CENTRAL_DIR_BUFSIZE
+   bytes and parse the file headers from memory, only has effect when
+   passed to unzOpenInternal */
+#define UNZ_BUFFER_CENTRAL_DIR 0x02u
 #define UNZ_DEFAULT_FLAGS UNZ_AUTO_CLOSE
 
 /* tm_unz contain date/time info */
@@ -451,6 +460,25 @@ extern int ZEXPORT unzSetOffset (unzFile file, uLong pos);
 extern int ZEXPORT unzSetFlags(unzFile file, unsigned flags);
 extern int ZEXPORT unzClearFlags(unzFile file, unsigned flags);
 
+/* Let the file data be read straight from a mapping of the whole archive,
+   data must stay valid until the file is closed or NULL is set. Encrypted
+   files are still read through the IO functions */
+extern int ZEXPORT unzSetMappedData(unzFile file,
+                                    const void* data,
+                                    ZPOS64_T size);
+
+/* Get the position of the central directory in the file (bytes before
+   the zipfile included) and its size, for callers that cache what they
+   read from it and need to tell whether it changed */
+extern int ZEXPORT unzGetCentralDirInfo64(unzFile file,
+                                          ZPOS64_T* offset,
+                                          ZPOS64_T* size);
+
+/* Get the position of the local header of the current file (bytes before
+   the zipfile included), for callers that read the data on their own.
+   Returns 0 if there is no current file */
+extern ZPOS64_T ZEXPORT unzGetCurrentFileLocalHeaderOffset64(unzFile file);
+
 #ifdef __cplusplus
 }
 #endif
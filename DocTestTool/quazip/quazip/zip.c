@@ -34,6 +34,8 @@
 typedef uLongf z_crc_t;
 #endif
 #include "zip.h"
+#include "checksum.h"
+#include "deflatecodec.h"
 
 #ifdef STDC
 #  include <stddef.h>
@@ -140,6 +142,10 @@ typedef struct
 #ifdef HAVE_BZIP2
     bz_stream bstream;          /* bzLib stream structure for bziped */
 #endif
+#ifdef HAVE_ZSTD
+    ZSTD_CCtx* zstream;         /* the zstd context of the zip file, while
+                                   a Z_ZSTD entry is written */
+#endif
 
     int  stream_initialised;    /* 1 is stream is initialised */
     uInt pos_in_buffered_data;  /* last written byte in buffered_data */
@@ -162,6 +168,11 @@ typedef struct
     ZPOS64_T pos_zip64extrainfo;
     ZPOS64_T totalCompressedData;
     ZPOS64_T totalUncompressedData;
+    int  codec;                 /* QUAZIP_CODEC_ZLIB unless whole_data is used */
+    int  level;
+    unsigned char* whole_data;  /* data kept for a whole-buffer codec */
+    size_t whole_size;
+    size_t whole_capacity;
 #ifndef NOCRYPT
     unsigned long keys[3];     /* keys defining the pseudo-random sequence */
     const z_crc_t FAR * pcrc_32_tab;
@@ -186,6 +197,12 @@ typedef struct
 #endif
 
     unsigned flags;
+    int codec;                /* codec for the entries opened from now on */
+#ifdef HAVE_ZSTD
+    ZSTD_CCtx* zstd_cctx;     /* made for the first Z_ZSTD entry and kept, so
+                                 that worker threads are started only once */
+    int zstd_workers;
+#endif
 
 } zip64_internal;
 
@@ -867,6 +884,12 @@ extern zipFile ZEXPORT zipOpen3 (voidpf file, int append, zipcharpc* globalcomme
     int err=ZIP_OK;
 
     ziinit.flags = flags;
+    ziinit.codec = QUAZIP_CODEC_ZLIB;
+    ziinit.ci.whole_data = NULL;
+#ifdef HAVE_ZSTD
+    ziinit.zstd_cctx = NULL;
+    ziinit.zstd_workers = 0;
+#endif
     ziinit.z_filefunc.zseek32_file = NULL;
     ziinit.z_filefunc.ztell32_file = NULL;
     if (pzlib_filefunc64_32_def==NULL)
@@ -1066,6 +1089,34 @@ int Write_LocalFileHeader(zip64_internal* zi, const char* filename,
   return err;
 }
 
+#ifdef HAVE_ZSTD
+/* Readies the zstd context of the zip file for a new entry. level is a
+   zstd level, Z_DEFAULT_COMPRESSION picks the zstd default */
+local int zip64local_zstdInit(zip64_internal* zi, int level)
+{
+    if (zi->zstd_cctx == NULL)
+    {
+        zi->zstd_cctx = ZSTD_createCCtx();
+        if (zi->zstd_cctx == NULL)
+            return ZIP_INTERNALERROR;
+    }
+    else
+        ZSTD_CCtx_reset(zi->zstd_cctx, ZSTD_reset_session_only);
+    if (level == Z_DEFAULT_COMPRESSION)
+        level = ZSTD_CLEVEL_DEFAULT;
+    if (ZSTD_isError(ZSTD_CCtx_setParameter(zi->zstd_cctx, ZSTD_c_compressionLevel, level)))
+        return ZIP_PARAMERROR;
+    /* a libzstd built without threads refuses workers, it compresses in
+       this thread then */
+    ZSTD_CCtx_setParameter(zi->zstd_cctx, ZSTD_c_nbWorkers, zi->zstd_workers);
+    /* a zip entry has its own CRC, the frame doesn't need one */
+    ZSTD_CCtx_setParameter(zi->zstd_cctx, ZSTD_c_checksumFlag, 0);
+    zi->ci.zstream = zi->zstd_cctx;
+    return ZIP_OK;
+}
+
+#endif
+
 /*
  NOTE.
  When writing RAW the ZIP64 extended information in extrafield_local and extrafield_global needs to be stripped
@@ -1097,13 +1148,15 @@ extern int ZEXPORT zipOpenNewFileInZip4_64 (zipFile file, const char* filename,
     if (file == NULL)
         return ZIP_PARAMERROR;
 
+    if ((method!=0) && (method!=Z_DEFLATED)
 #ifdef HAVE_BZIP2
-    if ((method!=0) && (method!=Z_DEFLATED) && (method!=Z_BZIP2ED))
-      return ZIP_PARAMERROR;
-#else
-    if ((method!=0) && (method!=Z_DEFLATED))
-      return ZIP_PARAMERROR;
+        && (method!=Z_BZIP2ED)
 #endif
+#ifdef HAVE_ZSTD
+        && (method!=Z_ZSTD)
+#endif
+       )
+      return ZIP_PARAMERROR;
 
     zi = (zip64_internal*)file;
 
@@ -1120,6 +1173,10 @@ extern int ZEXPORT zipOpenNewFileInZip4_64 (zipFile file, const char* filename,
     {
         version_to_extract = 10;
     }
+    else if (method == Z_ZSTD)
+    {
+        version_to_extract = 63;
+    }
     else
     {
         version_to_extract = 20;
@@ -1146,12 +1203,16 @@ extern int ZEXPORT zipOpenNewFileInZip4_64 (zipFile file, const char* filename,
     }
 
     zi->ci.flag = flagBase;
-    if ((level==8) || (level==9))
-      zi->ci.flag |= 2;
-    if (level==2)
-      zi->ci.flag |= 4;
-    if (level==1)
-      zi->ci.flag |= 6;
+    /* bits 1 and 2 tell the deflate level, zstd levels don't fit them */
+    if (method != Z_ZSTD)
+    {
+      if ((level==8) || (level==9))
+        zi->ci.flag |= 2;
+      if (level==2)
+        zi->ci.flag |= 4;
+      if (level==1)
+        zi->ci.flag |= 6;
+    }
     if (password != NULL)
       zi->ci.flag |= 1;
     if (version_to_extract >= 20
@@ -1165,6 +1226,16 @@ extern int ZEXPORT zipOpenNewFileInZip4_64 (zipFile file, const char* filename,
     zi->ci.stream_initialised = 0;
     zi->ci.pos_in_buffered_data = 0;
     zi->ci.raw = raw;
+    /* a whole-buffer codec can't encrypt as it goes, and the strategies
+       are zlib's */
+    zi->ci.codec = QUAZIP_CODEC_ZLIB;
+    if (method == Z_DEFLATED && !raw && password == NULL
+            && strategy == Z_DEFAULT_STRATEGY)
+        zi->ci.codec = zi->codec;
+    zi->ci.level = level;
+    zi->ci.whole_data = NULL;
+    zi->ci.whole_size = 0;
+    zi->ci.whole_capacity = 0;
     zi->ci.pos_local_header = ZTELL64(zi->z_filefunc,zi->filestream);
 
     zi->ci.size_centralheader = SIZECENTRALHEADER + size_filename + size_extrafield_global + size_comment;
@@ -1276,6 +1347,14 @@ extern int ZEXPORT zipOpenNewFileInZip4_64 (zipFile file, const char* filename,
         }
 
     }
+#ifdef HAVE_ZSTD
+    if ((err==ZIP_OK) && (zi->ci.method == Z_ZSTD) && (!zi->ci.raw))
+    {
+        err = zip64local_zstdInit(zi, level);
+        if (err==ZIP_OK)
+            zi->ci.stream_initialised = Z_ZSTD;
+    }
+#endif
 
 #    ifndef NOCRYPT
     zi->ci.crypt_header_size = 0;
@@ -1439,6 +1518,162 @@ local int zip64FlushWriteBuffer(zip64_internal* zi)
     return err;
 }
 
+local int zip64local_deflateStream(zip64_internal* zi, const void* buf, uInt len)
+{
+    int err=ZIP_OK;
+    zi->ci.stream.next_in = (Bytef*)buf;
+    zi->ci.stream.avail_in = len;
+
+    while ((err==ZIP_OK) && (zi->ci.stream.avail_in>0))
+    {
+        if (zi->ci.stream.avail_out == 0)
+        {
+            if (zip64FlushWriteBuffer(zi) == ZIP_ERRNO)
+                err = ZIP_ERRNO;
+            zi->ci.stream.avail_out = (uInt)Z_BUFSIZE;
+            zi->ci.stream.next_out = zi->ci.buffered_data;
+        }
+
+
+        if(err != ZIP_OK)
+            break;
+
+        if ((zi->ci.method == Z_DEFLATED) && (!zi->ci.raw))
+        {
+            uInt uAvailOutBefore = zi->ci.stream.avail_out;
+            err=deflate(&zi->ci.stream,  Z_NO_FLUSH);
+            zi->ci.pos_in_buffered_data += uAvailOutBefore - zi->ci.stream.avail_out;
+        }
+        else
+        {
+            uInt copy_this,i;
+            if (zi->ci.stream.avail_in < zi->ci.stream.avail_out)
+                copy_this = zi->ci.stream.avail_in;
+            else
+                copy_this = zi->ci.stream.avail_out;
+
+            for (i = 0; i < copy_this; i++)
+                *(((char*)zi->ci.stream.next_out)+i) =
+                    *(((const char*)zi->ci.stream.next_in)+i);
+            {
+                zi->ci.stream.avail_in -= copy_this;
+                zi->ci.stream.avail_out-= copy_this;
+                zi->ci.stream.next_in+= copy_this;
+                zi->ci.stream.next_out+= copy_this;
+                zi->ci.stream.total_in+= copy_this;
+                zi->ci.stream.total_out+= copy_this;
+                zi->ci.pos_in_buffered_data += copy_this;
+            }
+        }
+    }/* while(...) */
+
+    return err;
+}
+
+#ifdef HAVE_ZSTD
+/* Compresses len bytes, or finishes the frame if end is set */
+local int zip64local_zstdStream(zip64_internal* zi, const void* buf, uInt len, int end)
+{
+    ZSTD_inBuffer in;
+    size_t remaining;
+    in.src = buf;
+    in.size = len;
+    in.pos = 0;
+    do
+    {
+        ZSTD_outBuffer out;
+        if (zi->ci.pos_in_buffered_data == Z_BUFSIZE)
+        {
+            if (zip64FlushWriteBuffer(zi) == ZIP_ERRNO)
+                return ZIP_ERRNO;
+        }
+        out.dst = zi->ci.buffered_data;
+        out.size = Z_BUFSIZE;
+        out.pos = zi->ci.pos_in_buffered_data;
+        remaining = ZSTD_compressStream2(zi->ci.zstream, &out, &in,
+                                         end ? ZSTD_e_end : ZSTD_e_continue);
+        if (ZSTD_isError(remaining))
+            return ZIP_INTERNALERROR;
+        zi->ci.pos_in_buffered_data = (uInt)out.pos;
+    } while (end ? remaining != 0 : in.pos < in.size);
+    zi->ci.totalUncompressedData += len;
+    return ZIP_OK;
+}
+#endif
+
+/* Whole-buffer codecs get the data of an entry in one piece. It's kept
+   here until the entry is closed, or until it grows past this size and
+   the rest of the entry goes through zlib */
+#ifndef QUAZIP_WHOLE_ENTRY_MAX
+#define QUAZIP_WHOLE_ENTRY_MAX (64u * 1024u * 1024u)
+#endif
+
+local int zip64local_keepWholeData(zip64_internal* zi, const void* buf, uInt len)
+{
+    size_t needed = zi->ci.whole_size + len;
+    if (needed > QUAZIP_WHOLE_ENTRY_MAX)
+        return 0;
+    if (needed > zi->ci.whole_capacity)
+    {
+        size_t capacity = zi->ci.whole_capacity != 0 ? zi->ci.whole_capacity : 64 * 1024;
+        unsigned char* grown;
+        while (capacity < needed)
+            capacity *= 2;
+        if (capacity > QUAZIP_WHOLE_ENTRY_MAX)
+            capacity = QUAZIP_WHOLE_ENTRY_MAX;
+        grown = (unsigned char*)realloc(zi->ci.whole_data, capacity);
+        if (grown == NULL)
+            return 0;
+        zi->ci.whole_data = grown;
+        zi->ci.whole_capacity = capacity;
+    }
+    memcpy(zi->ci.whole_data + zi->ci.whole_size, buf, len);
+    zi->ci.whole_size = needed;
+    return 1;
+}
+
+local void zip64local_freeWholeData(zip64_internal* zi)
+{
+    TRYFREE(zi->ci.whole_data);
+    zi->ci.whole_data = NULL;
+    zi->ci.whole_size = 0;
+    zi->ci.whole_capacity = 0;
+}
+
+/* Gives the kept data to zlib, which then gets the rest of the entry */
+local int zip64local_spillWholeData(zip64_internal* zi)
+{
+    int err = ZIP_OK;
+    zi->ci.codec = QUAZIP_CODEC_ZLIB;
+    if (zi->ci.whole_size > 0)
+        err = zip64local_deflateStream(zi, zi->ci.whole_data, (uInt)zi->ci.whole_size);
+    zip64local_freeWholeData(zi);
+    return err;
+}
+
+/* Compresses the kept data in one go and writes it out */
+local int zip64local_writeWholeData(zip64_internal* zi)
+{
+    size_t bound = quazip_codec_bound(zi->ci.codec, QUAZIP_FORMAT_RAW, zi->ci.whole_size);
+    size_t size = 0;
+    int err = ZIP_OK;
+    unsigned char* out = (unsigned char*)ALLOC(bound);
+    if (out == NULL || quazip_codec_compress(zi->ci.codec, QUAZIP_FORMAT_RAW, zi->ci.level,
+                                             zi->ci.whole_data, zi->ci.whole_size,
+                                             out, bound, &size) != Z_OK)
+    {
+        TRYFREE(out);
+        return zip64local_spillWholeData(zi);
+    }
+    if (ZWRITE64(zi->z_filefunc,zi->filestream,out,(uLong)size) != (uLong)size)
+        err = ZIP_ERRNO;
+    zi->ci.totalCompressedData += size;
+    zi->ci.totalUncompressedData += zi->ci.whole_size;
+    TRYFREE(out);
+    zip64local_freeWholeData(zi);
+    return err;
+}
+
 extern int ZEXPORT zipWriteInFileInZip (zipFile file,const void* buf,unsigned int len)
 {
     zip64_internal* zi;
@@ -1451,7 +1686,7 @@ extern int ZEXPORT zipWriteInFileInZip (zipFile file,const void* buf,unsigned in
     if (zi->in_opened_file_inzip == 0)
         return ZIP_PARAMERROR;
 
-    zi->ci.crc32 = crc32(zi->ci.crc32,buf,(uInt)len);
+    zi->ci.crc32 = quazip_crc32(zi->ci.crc32,(const unsigned char*)buf,len);
 
 #ifdef HAVE_BZIP2
     if(zi->ci.method == Z_BZIP2ED && (!zi->ci.raw))
@@ -1489,52 +1724,23 @@ extern int ZEXPORT zipWriteInFileInZip (zipFile file,const void* buf,unsigned in
     }
     else
 #endif
+#ifdef HAVE_ZSTD
+    if(zi->ci.method == Z_ZSTD && (!zi->ci.raw))
     {
-      zi->ci.stream.next_in = (Bytef*)buf;
-      zi->ci.stream.avail_in = len;
-
-      while ((err==ZIP_OK) && (zi->ci.stream.avail_in>0))
+      err = zip64local_zstdStream(zi, buf, len, 0);
+    }
+    else
+#endif
+    {
+      if (zi->ci.codec != QUAZIP_CODEC_ZLIB)
       {
-          if (zi->ci.stream.avail_out == 0)
-          {
-              if (zip64FlushWriteBuffer(zi) == ZIP_ERRNO)
-                  err = ZIP_ERRNO;
-              zi->ci.stream.avail_out = (uInt)Z_BUFSIZE;
-              zi->ci.stream.next_out = zi->ci.buffered_data;
-          }
-
-
-          if(err != ZIP_OK)
-              break;
-
-          if ((zi->ci.method == Z_DEFLATED) && (!zi->ci.raw))
-          {
-              uInt uAvailOutBefore = zi->ci.stream.avail_out;
-              err=deflate(&zi->ci.stream,  Z_NO_FLUSH);
-              zi->ci.pos_in_buffered_data += uAvailOutBefore - zi->ci.stream.avail_out;
-          }
-          else
-          {
-              uInt copy_this,i;
-              if (zi->ci.stream.avail_in < zi->ci.stream.avail_out)
-                  copy_this = zi->ci.stream.avail_in;
-              else
-                  copy_this = zi->ci.stream.avail_out;
-
-              for (i = 0; i < copy_this; i++)
-                  *(((char*)zi->ci.stream.next_out)+i) =
-                      *(((const char*)zi->ci.stream.next_in)+i);
-              {
-                  zi->ci.stream.avail_in -= copy_this;
-                  zi->ci.stream.avail_out-= copy_this;
-                  zi->ci.stream.next_in+= copy_this;
-                  zi->ci.stream.next_out+= copy_this;
-                  zi->ci.stream.total_in+= copy_this;
-                  zi->ci.stream.total_out+= copy_this;
-                  zi->ci.pos_in_buffered_data += copy_this;
-              }
-          }
-      }/* while(...) */
+          if (zip64local_keepWholeData(zi, buf, len))
+              return ZIP_OK;
+          err = zip64local_spillWholeData(zi);
+          if (err != ZIP_OK)
+              return err;
+      }
+      err = zip64local_deflateStream(zi, buf, len);
     }
 
     return err;
@@ -1561,7 +1767,10 @@ extern int ZEXPORT zipCloseFileInZipRaw64 (zipFile file, ZPOS64_T uncompressed_s
         return ZIP_PARAMERROR;
     zi->ci.stream.avail_in = 0;
 
-    if ((zi->ci.method == Z_DEFLATED) && (!zi->ci.raw))
+    if (zi->ci.codec != QUAZIP_CODEC_ZLIB)
+        err = zip64local_writeWholeData(zi);
+
+    if ((zi->ci.method == Z_DEFLATED) && (!zi->ci.raw) && (zi->ci.codec == QUAZIP_CODEC_ZLIB))
                 {
                         while (err==ZIP_OK)
                         {
@@ -1604,6 +1813,12 @@ extern int ZEXPORT zipCloseFileInZipRaw64 (zipFile file, ZPOS64_T uncompressed_s
         err = ZIP_OK;
 #endif
     }
+#ifdef HAVE_ZSTD
+    else if ((zi->ci.method == Z_ZSTD) && (!zi->ci.raw))
+    {
+      err = zip64local_zstdStream(zi, NULL, 0, 1);
+    }
+#endif
 
     if (err==Z_STREAM_END)
         err=ZIP_OK; /* this is normal */
@@ -1630,6 +1845,14 @@ extern int ZEXPORT zipCloseFileInZipRaw64 (zipFile file, ZPOS64_T uncompressed_s
                         zi->ci.stream_initialised = 0;
     }
 #endif
+#ifdef HAVE_ZSTD
+    else if((zi->ci.method == Z_ZSTD) && (!zi->ci.raw))
+    {
+      /* the context stays with the zip file for the next entry */
+      zi->ci.zstream = NULL;
+      zi->ci.stream_initialised = 0;
+    }
+#endif
 
     if (!zi->ci.raw)
     {
@@ -1643,7 +1866,8 @@ extern int ZEXPORT zipCloseFileInZipRaw64 (zipFile file, ZPOS64_T uncompressed_s
 #    endif
 
     /* update Current Item crc and sizes, */
-    if(compressed_size >= 0xffffffff || uncompressed_size >= 0xffffffff || zi->ci.pos_local_header >= 0xffffffff)
+    if((compressed_size >= 0xffffffff || uncompressed_size >= 0xffffffff || zi->ci.pos_local_header >= 0xffffffff)
+       && zi->ci.method != Z_ZSTD) /* zstd needs 6.3 already */
     {
       /*version Made by*/
       zip64local_putValue_inmemory(zi->ci.central_header+4,(uLong)45,2);
@@ -1791,6 +2015,11 @@ extern int ZEXPORT zipCloseFileInZipRaw64 (zipFile file, ZPOS64_T uncompressed_s
                     err = zip64local_putValue(&zi->z_filefunc,zi->filestream,compressed_size,4);
                 if (err==ZIP_OK) /* uncompressed size, unknown */
                     err = zip64local_putValue(&zi->z_filefunc,zi->filestream,uncompressed_size,4);
+                /* A streaming reader has nothing but the truncated descriptor
+                   to go by, so the file had to be opened in the zip64 mode. */
+                if (err==ZIP_OK && (zi->flags & ZIP_SEQUENTIAL) != 0
+                        && (compressed_size >= 0xffffffff || uncompressed_size >= 0xffffffff))
+                    err = ZIP_BADZIPFILE;
             }
         }
     }
@@ -1806,6 +2035,42 @@ extern int ZEXPORT zipCloseFileInZip (zipFile file)
     return zipCloseFileInZipRaw (file,0,0);
 }
 
+extern int ZEXPORT zipDiscardFileInZip (zipFile file)
+{
+    zip64_internal* zi;
+
+    if (file == NULL)
+        return ZIP_PARAMERROR;
+    zi = (zip64_internal*)file;
+
+    if (zi->in_opened_file_inzip == 0)
+        return ZIP_PARAMERROR;
+
+    if (zi->ci.stream_initialised == Z_DEFLATED)
+        deflateEnd(&zi->ci.stream);
+#ifdef HAVE_BZIP2
+    else if (zi->ci.stream_initialised == Z_BZIP2ED)
+        BZ2_bzCompressEnd(&zi->ci.bstream);
+#endif
+#ifdef HAVE_ZSTD
+    else if (zi->ci.stream_initialised == Z_ZSTD)
+    {
+        ZSTD_CCtx_reset(zi->zstd_cctx, ZSTD_reset_session_only);
+        zi->ci.zstream = NULL;
+    }
+#endif
+    zi->ci.stream_initialised = 0;
+    zip64local_freeWholeData(zi);
+
+    /* what is written stays in the file, but nothing refers to it */
+    zi->ci.pos_in_buffered_data = 0;
+    free(zi->ci.central_header);
+    zi->ci.central_header = NULL;
+    zi->in_opened_file_inzip = 0;
+
+    return ZIP_OK;
+}
+
 int Write_Zip64EndOfCentralDirectoryLocator(zip64_internal* zi, ZPOS64_T zip64eocd_pos_inzip)
 {
   int err = ZIP_OK;
@@ -2004,6 +2269,9 @@ extern int ZEXPORT zipClose (zipFile file, const char* global_comment)
 
 #ifndef NO_ADDFILEINEXISTINGZIP
     TRYFREE(zi->globalcomment);
+#endif
+#ifdef HAVE_ZSTD
+    ZSTD_freeCCtx(zi->zstd_cctx);
 #endif
     TRYFREE(zi);
 
@@ -2082,6 +2350,32 @@ int ZEXPORT zipSetFlags(zipFile file, unsigned flags)
     return ZIP_OK;
 }
 
+int ZEXPORT zipSetDeflateCodec(zipFile file, int codec)
+{
+    zip64_internal* zi;
+    if (file == NULL || !quazip_codec_available(codec))
+        return ZIP_PARAMERROR;
+    zi = (zip64_internal*)file;
+    zi->codec = codec;
+    return ZIP_OK;
+}
+
+int ZEXPORT zipSetZstdWorkers(zipFile file, int workers)
+{
+#ifdef HAVE_ZSTD
+    zip64_internal* zi;
+    if (file == NULL || workers < 0)
+        return ZIP_PARAMERROR;
+    zi = (zip64_internal*)file;
+    zi->zstd_workers = workers;
+    return ZIP_OK;
+#else
+    (void)file;
+    (void)workers;
+    return ZIP_PARAMERROR;
+#endif
+}
+
 int ZEXPORT zipClearFlags(zipFile file, unsigned flags)
 {
     zip64_internal* zi;
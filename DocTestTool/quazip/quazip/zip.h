@@ -64,7 +64,12 @@ extern "C" {
 #include "bzlib.h"
 #endif
 
+#ifdef HAVE_ZSTD
+#include "zstd.h"
+#endif
+
 #define Z_BZIP2ED 12
+#define Z_ZSTD 93
 
 #if defined(STRICTZIP) || defined(STRICTZIPUNZIP)
 /* like the STRICT of WIN32, we define a pointer that cannot be converted
@@ -352,6 +357,16 @@ extern int ZEXPORT zipCloseFileInZipRaw64 OF((zipFile file,
   uncompressed_size and crc32 are value for the uncompressed size
 */
 
+extern int ZEXPORT zipDiscardFileInZip OF((zipFile file));
+/*
+  Close the current file in the zipfile without adding it to the central
+    directory, for a file whose data could not be written in full. The
+    data written so far stays in the zipfile where no reader that uses
+    the central directory looks. A streaming reader does come across it
+    and, with a data descriptor, can't tell where it ends, so this is of
+    no use with ZIP_SEQUENTIAL.
+*/
+
 extern int ZEXPORT zipClose OF((zipFile file,
                 const char* global_comment));
 /*
@@ -383,6 +398,25 @@ extern int ZEXPORT zipRemoveExtraInfoBlock OF((char* pData, int* dataLen, short
 extern int ZEXPORT zipSetFlags(zipFile file, unsigned flags);
 extern int ZEXPORT zipClearFlags(zipFile file, unsigned flags);
 
+/*
+   Selects the deflate codec for the entries opened from now on, one of
+   the QUAZIP_CODEC_ constants of deflatecodec.h. A whole-buffer codec
+   compresses each deflated entry in one go when it's closed, entries
+   that are raw, encrypted, use a non-default strategy or grow past
+   QUAZIP_WHOLE_ENTRY_MAX bytes go through zlib. Returns ZIP_PARAMERROR
+   for a codec that isn't compiled in.
+*/
+extern int ZEXPORT zipSetDeflateCodec(zipFile file, int codec);
+
+/*
+   Sets the number of threads zstd compresses the Z_ZSTD entries opened
+   from now on with, 0 to compress in the calling thread. zstd only splits
+   an entry that is larger than several megabytes, smaller entries are
+   compressed by one thread whatever the setting. Returns ZIP_PARAMERROR
+   if QuaZIP is built without HAVE_ZSTD.
+*/
+extern int ZEXPORT zipSetZstdWorkers(zipFile file, int workers);
+
 #ifdef __cplusplus
 }
 #endif
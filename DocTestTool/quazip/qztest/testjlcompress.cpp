@@ -32,6 +32,7 @@ see quazip/(un)zip.h files for details. Basically it's the zlib license.
 #include <QtTest/QtTest>
 
 #include <quazip/JlCompress.h>
+#include <quazip/quazipfile.h>
 
 #ifdef Q_OS_WIN
 #include <Windows.h>
@@ -381,3 +382,154 @@ void TestJlCompress::zeroPermissions()
     curDir.remove("zero.zip");
     curDir.remove("zero.txt");
 }
+
+void TestJlCompress::compressDirParallel_data()
+{
+    compressDir_data();
+}
+
+void TestJlCompress::compressDirParallel()
+{
+    QFETCH(QString, zipName);
+    QFETCH(QStringList, fileNames);
+    QFETCH(QStringList, expected);
+    QDir curDir;
+    if (curDir.exists(zipName)) {
+        if (!curDir.remove(zipName))
+            QFAIL("Can't remove zip file");
+    }
+    if (!createTestFiles(fileNames, -1, "compressDir_tmp")) {
+        QFAIL("Can't create test files");
+    }
+#ifdef Q_OS_WIN
+    for (int i = 0; i < fileNames.size(); ++i) {
+        if (fileNames.at(i).startsWith(".")) {
+            QString fn = "compressDir_tmp\\" + fileNames.at(i);
+            SetFileAttributesW(reinterpret_cast<LPCWSTR>(fn.utf16()),
+                              FILE_ATTRIBUTE_HIDDEN);
+        }
+    }
+#endif
+    // the same entries in the same order as the sequential version
+    const QString sequentialName = "sequential_" + zipName;
+    QVERIFY(JlCompress::compressDir(sequentialName, "compressDir_tmp", true, QDir::Hidden));
+    QVERIFY(JlCompress::compressDirParallel(zipName, "compressDir_tmp", true,
+                                            QDir::Hidden, 3));
+    QStringList fileList = JlCompress::getFileList(zipName);
+    QCOMPARE(fileList, JlCompress::getFileList(sequentialName));
+    qSort(fileList);
+    qSort(expected);
+    QCOMPARE(fileList, expected);
+    // and the data reads back
+    QuaZip zip(zipName);
+    QVERIFY(zip.open(QuaZip::mdUnzip));
+    for (bool more = zip.goToFirstFile(); more; more = zip.goToNextFile()) {
+        const QString name = zip.getCurrentFileName();
+        if (name.endsWith('/'))
+            continue;
+        QFile original("compressDir_tmp/" + name);
+        QVERIFY(original.open(QIODevice::ReadOnly));
+        QuaZipFile zipFile(&zip);
+        QVERIFY(zipFile.open(QIODevice::ReadOnly));
+        QCOMPARE(zipFile.readAll(), original.readAll());
+        zipFile.close();
+        QCOMPARE(zipFile.getZipError(), UNZ_OK);
+    }
+    zip.close();
+    removeTestFiles(fileNames, "compressDir_tmp");
+    curDir.remove(zipName);
+    curDir.remove(sequentialName);
+}
+
+void TestJlCompress::extractDirParallel_data()
+{
+    extractDir_data();
+}
+
+void TestJlCompress::extractDirParallel()
+{
+    QFETCH(QString, zipName);
+    QFETCH(QStringList, fileNames);
+    QDir curDir;
+    if (!curDir.mkpath("jlext/jldir")) {
+        QFAIL("Couldn't mkpath jlext/jldir");
+    }
+    if (!createTestFiles(fileNames)) {
+        QFAIL("Couldn't create test files");
+    }
+    if (!createTestArchive(zipName, fileNames)) {
+        QFAIL("Couldn't create test archive");
+    }
+    QStringList extracted;
+    QCOMPARE((extracted = JlCompress::extractDirParallel(zipName, "jlext/jldir", 3))
+        .count(), fileNames.count());
+    foreach (QString fileName, fileNames) {
+        QString fullName = "jlext/jldir/" + fileName;
+        QFileInfo fileInfo(fullName);
+        QFileInfo extInfo("tmp/" + fileName);
+        if (!fileInfo.isDir())
+            QCOMPARE(fileInfo.size(), extInfo.size());
+        QCOMPARE(fileInfo.permissions(), extInfo.permissions());
+        curDir.remove(fullName);
+        curDir.rmpath(fileInfo.dir().path());
+        QString absolutePath = fileInfo.absoluteFilePath();
+        if (fileInfo.isDir() && !absolutePath.endsWith('/'))
+            absolutePath += '/';
+        QVERIFY(extracted.contains(absolutePath));
+    }
+    QVERIFY(JlCompress::extractFilesParallel(zipName,
+                QStringList() << "no such file", "jlext/jldir").isEmpty());
+    curDir.rmpath("jlext/jldir");
+    removeTestFiles(fileNames);
+    curDir.remove(zipName);
+}
+
+// Two entries with the same name must not be written by two workers at
+// once, the parallel extraction leaves what the serial one does.
+void TestJlCompress::extractDuplicateParallel()
+{
+    QDir curDir;
+    QVERIFY(curDir.mkpath("tmp"));
+    const QString zipName = "tmp/jlduplicate.zip";
+    const QStringList names = QStringList() << "dup.txt" << "other.txt"
+                                            << "dup.txt";
+    {
+        QuaZip zip(zipName);
+        QVERIFY(zip.open(QuaZip::mdCreate));
+        for (int i = 0; i < names.size(); ++i) {
+            QuaZipFile file(&zip);
+            QVERIFY(file.open(QIODevice::WriteOnly, QuaZipNewInfo(names.at(i))));
+            file.write(QString("entry %1 of %2\n").arg(i).arg(names.at(i))
+                       .toUtf8().repeated(1000 * (i + 1)));
+            file.close();
+        }
+        zip.close();
+        QCOMPARE(zip.getZipError(), ZIP_OK);
+    }
+    const QStringList dirs = QStringList() << "jlext/serial" << "jlext/parallel";
+    QList<QStringList> extracted;
+    extracted << JlCompress::extractDir(zipName, dirs.at(0))
+              << JlCompress::extractDirParallel(zipName, dirs.at(1), 3);
+    QList<QStringList> files;
+    files << JlCompress::extractFiles(zipName, names, dirs.at(0) + "/files")
+          << JlCompress::extractFilesParallel(zipName, names,
+                                              dirs.at(1) + "/files", 3);
+    for (int i = 0; i < 2; ++i) {
+        QCOMPARE(extracted.at(i).size(), names.size());
+        QCOMPARE(files.at(i).size(), names.size());
+    }
+    foreach (QString name, QStringList() << "dup.txt" << "other.txt"
+             << "files/dup.txt" << "files/other.txt") {
+        QFile serial(dirs.at(0) + "/" + name);
+        QFile parallel(dirs.at(1) + "/" + name);
+        QVERIFY(serial.open(QIODevice::ReadOnly));
+        QVERIFY(parallel.open(QIODevice::ReadOnly));
+        QVERIFY(serial.readAll() == parallel.readAll());
+    }
+    for (int i = 0; i < 2; ++i) {
+        QDir dir(dirs.at(i));
+        QVERIFY(dir.removeRecursively());
+    }
+    curDir.rmpath("jlext");
+    curDir.remove(zipName);
+}
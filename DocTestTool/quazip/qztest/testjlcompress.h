@@ -43,6 +43,11 @@ private slots:
     void extractDir_data();
     void extractDir();
     void zeroPermissions();
+    void compressDirParallel_data();
+    void compressDirParallel();
+    void extractDirParallel_data();
+    void extractDirParallel();
+    void extractDuplicateParallel();
 };
 
 #endif // QUAZIP_TEST_JLCOMPRESS_H
@@ -29,6 +29,8 @@ see quazip/(un)zip.h files for details. Basically it's the zlib license.
 
 #include <QtTest/QtTest>
 
+#include <zlib.h>
+
 void TestQuaChecksum32::calculate()
 {
     QuaCrc32 crc32;
@@ -48,3 +50,98 @@ void TestQuaChecksum32::update()
     adler32.update("pedia");
     QCOMPARE(adler32.value(), 0x11E60398u);
 }
+
+// Random bytes, the same on every run.
+static QByteArray checksumData(int size)
+{
+    QByteArray data(size, '\0');
+    quint32 seed = 12345;
+    for (int i = 0; i < size; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        data[i] = static_cast<char>(seed >> 24);
+    }
+    return data;
+}
+
+void TestQuaChecksum32::crossCheck()
+{
+    // every length around the SIMD block sizes, at every alignment
+    const QByteArray data = checksumData(4096 + 16);
+    for (int offset = 0; offset < 16; ++offset) {
+        for (int size = 0; size <= 1024; ++size) {
+            const char *p = data.constData() + offset;
+            const Bytef *z = reinterpret_cast<const Bytef*>(p);
+            QuaCrc32 crc32;
+            QCOMPARE(crc32.calculate(p, size),
+                     static_cast<quint32>(::crc32(0L, z, size)));
+            QuaAdler32 adler32;
+            QCOMPARE(adler32.calculate(p, size),
+                     static_cast<quint32>(::adler32(1L, z, size)));
+        }
+    }
+    // streamed in uneven pieces, continuing from a non-initial value
+    QuaCrc32 crc32;
+    QuaAdler32 adler32;
+    for (int pos = 0, step = 1; pos < data.size(); pos += step, step = step * 3 + 1) {
+        const int size = qMin(step, data.size() - pos);
+        crc32.update(data.constData() + pos, size);
+        adler32.update(data.mid(pos, size));
+    }
+    const Bytef *z = reinterpret_cast<const Bytef*>(data.constData());
+    QCOMPARE(crc32.value(), static_cast<quint32>(::crc32(0L, z, data.size())));
+    QCOMPARE(adler32.value(), static_cast<quint32>(::adler32(1L, z, data.size())));
+    // sums that would overflow without the modulo, all bytes 0xFF
+    const QByteArray ones(1024 * 1024, '\xff');
+    z = reinterpret_cast<const Bytef*>(ones.constData());
+    QCOMPARE(QuaAdler32().calculate(ones),
+             static_cast<quint32>(::adler32(1L, z, ones.size())));
+    QCOMPARE(QuaCrc32().calculate(ones),
+             static_cast<quint32>(::crc32(0L, z, ones.size())));
+}
+
+void TestQuaChecksum32::throughput_data()
+{
+    QTest::addColumn<int>("algorithm");
+    QTest::addColumn<bool>("zlib");
+    QTest::newRow("crc32 zlib") << 0 << true;
+    QTest::newRow("crc32 QuaCrc32") << 0 << false;
+    QTest::newRow("adler32 zlib") << 1 << true;
+    QTest::newRow("adler32 QuaAdler32") << 1 << false;
+}
+
+// Checksums 64 MB in 1 MB spans.
+void TestQuaChecksum32::throughput()
+{
+    QFETCH(int, algorithm);
+    QFETCH(bool, zlib);
+    const QByteArray data = checksumData(1024 * 1024);
+    const Bytef *z = reinterpret_cast<const Bytef*>(data.constData());
+    quint32 result = 0;
+    QBENCHMARK {
+        QuaCrc32 crc32;
+        QuaAdler32 adler32;
+        uLong value = algorithm == 0 ? ::crc32(0L, Z_NULL, 0)
+                                     : ::adler32(0L, Z_NULL, 0);
+        for (int i = 0; i < 64; ++i) {
+            if (zlib && algorithm == 0)
+                value = ::crc32(value, z, data.size());
+            else if (zlib)
+                value = ::adler32(value, z, data.size());
+            else if (algorithm == 0)
+                crc32.update(data.constData(), data.size());
+            else
+                adler32.update(data.constData(), data.size());
+        }
+        if (!zlib)
+            value = algorithm == 0 ? crc32.value() : adler32.value();
+        result = static_cast<quint32>(value);
+    }
+    // both implementations give the same answer
+    uLong expected = algorithm == 0 ? ::crc32(0L, Z_NULL, 0)
+                                    : ::adler32(0L, Z_NULL, 0);
+    for (int i = 0; i < 64; ++i) {
+        expected = algorithm == 0 ? ::crc32(expected, z, data.size())
+                                  : ::adler32(expected, z, data.size());
+    }
+    QCOMPARE(result, static_cast<quint32>(expected));
+}
@@ -32,6 +32,9 @@ class TestQuaChecksum32: public QObject {
 private slots:
     void calculate();
     void update();
+    void crossCheck();
+    void throughput_data();
+    void throughput();
 };
 
 #endif // QUAZIP_TEST_QUACHECKSUM32_H
@@ -69,6 +69,48 @@ void TestQuaGzipFile::write()
     curDir.rmdir("tmp");
 }
 
+void TestQuaGzipFile::parallelWrite_data()
+{
+    QTest::addColumn<int>("size");
+    QTest::newRow("empty") << 0;
+    QTest::newRow("small") << 1000;
+    QTest::newRow("several blocks") << 5 * 1024 * 1024 + 17;
+}
+
+void TestQuaGzipFile::parallelWrite()
+{
+    QFETCH(int, size);
+    QDir curDir;
+    curDir.mkpath("tmp");
+    QByteArray data;
+    data.reserve(size);
+    for (int i = 0; data.size() < size; ++i)
+        data.append(QByteArray::number(i * 7919 % 100003)).append(' ');
+    data.truncate(size);
+    QuaGzipFile testFile("tmp/test.gz", QuaGzipFile::cmParallel);
+    QCOMPARE(testFile.getCompressionMode(), QuaGzipFile::cmParallel);
+    QVERIFY(testFile.open(QIODevice::WriteOnly));
+    // uneven pieces with a flush in the middle
+    const int half = size / 2;
+    for (int pos = 0; pos < half; pos += 65521)
+        QCOMPARE(testFile.write(data.constData() + pos, qMin(65521, half - pos)),
+                 static_cast<qint64>(qMin(65521, half - pos)));
+    QVERIFY(testFile.flush());
+    QCOMPARE(testFile.write(data.mid(half)),
+             static_cast<qint64>(size - half));
+    testFile.close();
+    QVERIFY(!testFile.isOpen());
+    gzFile file = gzopen("tmp/test.gz", "rb");
+    QVERIFY(file != NULL);
+    QByteArray read(size + 1, '\0');
+    QCOMPARE(gzread(file, read.data(), size + 1), size);
+    QCOMPARE(gzclose(file), Z_OK);
+    read.truncate(size);
+    QVERIFY(read == data);
+    curDir.remove("tmp/test.gz");
+    curDir.rmdir("tmp");
+}
+
 void TestQuaGzipFile::constructorDestructor()
 {
     QuaGzipFile *f1 = new QuaGzipFile();
@@ -32,6 +32,8 @@ class TestQuaGzipFile: public QObject {
 private slots:
     void read();
     void write();
+    void parallelWrite_data();
+    void parallelWrite();
     void constructorDestructor();
 };
 
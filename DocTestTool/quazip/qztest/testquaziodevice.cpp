@@ -110,3 +110,30 @@ void TestQuaZIODevice::write()
     QCOMPARE(static_cast<const char*>(outBuf), "test");
     delete testDevice; // Test D0 destructor
 }
+
+void TestQuaZIODevice::parallelWrite()
+{
+    QByteArray data;
+    for (int i = 0; data.size() < 3 * 1024 * 1024; ++i)
+        data.append(QByteArray::number(i * 7919 % 100003)).append(' ');
+    QByteArray buf;
+    QBuffer testBuffer(&buf);
+    testBuffer.open(QIODevice::WriteOnly);
+    QuaZIODevice testDevice(&testBuffer, QuaZIODevice::cmParallel);
+    QVERIFY(testDevice.open(QIODevice::WriteOnly));
+    const int half = data.size() / 2;
+    QCOMPARE(testDevice.write(data.left(half)), static_cast<qint64>(half));
+    QVERIFY(testDevice.flush());
+    QCOMPARE(testDevice.write(data.mid(half)),
+             static_cast<qint64>(data.size() - half));
+    testDevice.close();
+    testBuffer.close();
+    QVERIFY(buf.size() < data.size());
+    testBuffer.open(QIODevice::ReadOnly);
+    QuaZIODevice readDevice(&testBuffer);
+    QVERIFY(readDevice.open(QIODevice::ReadOnly));
+    QByteArray read = readDevice.readAll();
+    QVERIFY(readDevice.atEnd());
+    readDevice.close();
+    QVERIFY(read == data);
+}
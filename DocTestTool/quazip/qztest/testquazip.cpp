@@ -40,6 +40,9 @@ see quazip/(un)zip.h files for details. Basically it's the zlib license.
 #include <QtTest/QtTest>
 
 #include <quazip/quazip.h>
+#include <quazip/quazipfile.h>
+#include <quazip/quazipsharedarchive.h>
+#include <quazip/quazipsharedfile.h>
 #include <quazip/JlCompress.h>
 
 void TestQuaZip::getFileList_data()
@@ -392,8 +395,19 @@ void TestQuaZip::saveFileBug()
 }
 #endif
 
+void TestQuaZip::testSequential_data()
+{
+    QTest::addColumn<bool>("zip64");
+    QTest::addColumn<int>("method");
+    QTest::newRow("stored") << false << 0;
+    QTest::newRow("deflated") << false << static_cast<int>(Z_DEFLATED);
+    QTest::newRow("zip64") << true << static_cast<int>(Z_DEFLATED);
+}
+
 void TestQuaZip::testSequential()
 {
+    QFETCH(bool, zip64);
+    QFETCH(int, method);
     QTcpServer server;
     QVERIFY(server.listen(QHostAddress(QHostAddress::LocalHost)));
     quint16 port = server.serverPort();
@@ -404,11 +418,12 @@ void TestQuaZip::testSequential()
     QTcpSocket *client = server.nextPendingConnection();
     QuaZip zip(&socket);
     zip.setAutoClose(false);
+    zip.setZip64Enabled(zip64);
     QVERIFY(zip.open(QuaZip::mdCreate));
     QVERIFY(socket.isOpen());
     QuaZipFile zipFile(&zip);
     QuaZipNewInfo info("test.txt");
-    QVERIFY(zipFile.open(QIODevice::WriteOnly, info, NULL, 0, 0));
+    QVERIFY(zipFile.open(QIODevice::WriteOnly, info, NULL, 0, method));
     QCOMPARE(zipFile.write("test"), static_cast<qint64>(4));
     zipFile.close();
     zip.close();
@@ -439,3 +454,317 @@ void TestQuaZip::testSequential()
     receivedFile.close();
     receivedZip.close();
 }
+
+void TestQuaZip::nameIndex()
+{
+    QString zipName = "qznameindex.zip";
+    QString indexName = zipName + ".qzindex";
+    QStringList fileNames;
+    fileNames << "test0.txt" << "testdir1/test1.txt" << "testdir2/TEST2.txt";
+    QStringList fileNamesToAdd("testAdd.txt");
+    QDir curDir;
+    curDir.remove(zipName);
+    curDir.remove(indexName);
+    if (!createTestFiles(fileNames + fileNamesToAdd)) {
+        QFAIL("Can't create test files");
+    }
+    if (!createTestArchive(zipName, fileNames)) {
+        QFAIL("Can't create test archive");
+    }
+    QuaZip testZip(zipName);
+    testZip.setNameIndexEnabled(true);
+    QVERIFY(testZip.open(QuaZip::mdUnzip));
+    QVERIFY(testZip.isNameIndexUsed());
+    QVERIFY(curDir.exists(indexName));
+    testZip.close();
+    QVERIFY(!testZip.isNameIndexUsed());
+    // a new object has nothing mapped, every lookup goes through the index
+    QuaZip indexedZip(zipName);
+    indexedZip.setNameIndexEnabled(true);
+    QVERIFY(indexedZip.open(QuaZip::mdUnzip));
+    QVERIFY(indexedZip.isNameIndexUsed());
+    foreach (QString fileName, fileNames) {
+        QVERIFY(indexedZip.setCurrentFile(fileName, QuaZip::csSensitive));
+        QCOMPARE(indexedZip.getCurrentFileName(), fileName);
+    }
+    QVERIFY(indexedZip.setCurrentFile("TESTDIR2/test2.txt",
+                                      QuaZip::csInsensitive));
+    QCOMPARE(indexedZip.getCurrentFileName(), QString("testdir2/TEST2.txt"));
+    QVERIFY(!indexedZip.setCurrentFile("testdir2/test2.txt",
+                                       QuaZip::csSensitive));
+    QVERIFY(!indexedZip.setCurrentFile("missing.txt"));
+    QVERIFY(!indexedZip.hasCurrentFile());
+    QCOMPARE(indexedZip.getZipError(), UNZ_OK);
+    indexedZip.close();
+    // adding a file makes the index stale, the next open rewrites it
+    QVERIFY(testZip.open(QuaZip::mdAdd));
+    foreach (QString fileName, fileNamesToAdd) {
+        QuaZipFile testFile(&testZip);
+        QVERIFY(testFile.open(QIODevice::WriteOnly,
+            QuaZipNewInfo(fileName, "tmp/" + fileName)));
+        QFile inFile("tmp/" + fileName);
+        QVERIFY(inFile.open(QIODevice::ReadOnly));
+        testFile.write(inFile.readAll());
+        inFile.close();
+        testFile.close();
+    }
+    testZip.close();
+    QVERIFY(indexedZip.open(QuaZip::mdUnzip));
+    QVERIFY(indexedZip.isNameIndexUsed());
+    foreach (QString fileName, fileNames + fileNamesToAdd) {
+        QVERIFY(indexedZip.setCurrentFile(fileName));
+    }
+    indexedZip.close();
+    removeTestFiles(fileNames + fileNamesToAdd);
+    curDir.remove(zipName);
+    curDir.remove(indexName);
+}
+
+void TestQuaZip::nameIndexLookup_data()
+{
+    QTest::addColumn<bool>("indexed");
+    QTest::newRow("directory walk") << false;
+    QTest::newRow("name index") << true;
+}
+
+// Cold open plus 10k random lookups. The number of entries can be raised
+// with QZTEST_BENCH_ENTRIES, e.g. QZTEST_BENCH_ENTRIES=500000 to match
+// a reference archive.
+void TestQuaZip::nameIndexLookup()
+{
+    QFETCH(bool, indexed);
+    int entries = qgetenv("QZTEST_BENCH_ENTRIES").toInt();
+    if (entries <= 0)
+        entries = 20000;
+    QDir curDir;
+    QVERIFY(curDir.mkpath("tmp"));
+    const QString zipName = "tmp/nameindex.zip";
+    const QString indexName = zipName + ".qzindex";
+    curDir.remove(indexName);
+    {
+        QuaZip zip(zipName);
+        QVERIFY(zip.open(QuaZip::mdCreate));
+        for (int i = 0; i < entries; ++i) {
+            QuaZipFile zipFile(&zip);
+            QVERIFY(zipFile.open(QIODevice::WriteOnly, QuaZipNewInfo(
+                QString("dir%1/document%2.xml").arg(i % 100).arg(i)),
+                NULL, 0, 0));
+            zipFile.write("<doc/>");
+            zipFile.close();
+        }
+        zip.close();
+    }
+    if (indexed) {
+        // written once, the benchmark measures the processes that come later
+        QuaZip zip(zipName);
+        zip.setNameIndexEnabled(true);
+        QVERIFY(zip.open(QuaZip::mdUnzip));
+        QVERIFY(zip.isNameIndexUsed());
+        zip.close();
+    }
+    QStringList lookups;
+    quint32 seed = 12345;
+    for (int i = 0; i < 10000; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        const int entry = static_cast<int>((seed >> 8) % entries);
+        lookups << QString("dir%1/document%2.xml").arg(entry % 100).arg(entry);
+    }
+    QBENCHMARK_ONCE {
+        QuaZip zip(zipName);
+        zip.setNameIndexEnabled(indexed);
+        QVERIFY(zip.open(QuaZip::mdUnzip));
+        QCOMPARE(zip.isNameIndexUsed(), indexed);
+        foreach (const QString &name, lookups) {
+            if (!zip.setCurrentFile(name))
+                QFAIL("Entry not found");
+        }
+        zip.close();
+    }
+    curDir.remove(zipName);
+    curDir.remove(indexName);
+}
+
+// The central directory is read in windows of 1 MB (UNZ_CENTRAL_DIR_BUFSIZE
+// in unzip.c), so make it larger than that with long names and comments of
+// varying lengths and check that buffered listing matches device reads.
+void TestQuaZip::centralDirBuffering()
+{
+    const int windowSize = 1024 * 1024;
+    const int entries = 4000;
+    QDir curDir;
+    QVERIFY(curDir.mkpath("tmp"));
+    const QString zipName = "tmp/cdbuffer.zip";
+    QStringList names;
+    {
+        QuaZip zip(zipName);
+        QVERIFY(zip.open(QuaZip::mdCreate));
+        for (int i = 0; i < entries; ++i) {
+            const QString name = QString("dir%1/%2%3.xml").arg(i % 10)
+                .arg(QString(100 + i % 150, QChar('n'))).arg(i);
+            QuaZipNewInfo info(name);
+            info.comment = QString(i % 200, QChar('c'));
+            if (i % 11 == 0)
+                info.extraGlobal = QByteArray("\xfe\xca\x02\x00" "ab", 6);
+            QuaZipFile zipFile(&zip);
+            QVERIFY(zipFile.open(QIODevice::WriteOnly, info, NULL, 0, 0));
+            zipFile.write(name.toUtf8());
+            zipFile.close();
+            names << name;
+        }
+        zip.close();
+    }
+    QList<QuaZipFileInfo64> expected;
+    {
+        QuaZip zip(zipName);
+        zip.setCentralDirBufferingEnabled(false);
+        QVERIFY(zip.open(QuaZip::mdUnzip));
+        expected = zip.getFileInfoList64();
+        zip.close();
+    }
+    QCOMPARE(expected.size(), entries);
+    // some header must cross the end of the first window
+    qint64 offset = 0;
+    bool straddles = false;
+    foreach (const QuaZipFileInfo64 &info, expected) {
+        const qint64 next = offset + 46 + info.name.toUtf8().size()
+            + info.extra.size() + info.comment.toUtf8().size();
+        if (offset < windowSize && next > windowSize)
+            straddles = true;
+        offset = next;
+    }
+    QVERIFY(offset > windowSize);
+    QVERIFY(straddles);
+    QuaZip zip(zipName);
+    zip.setCentralDirBufferingEnabled(true);
+    QVERIFY(zip.open(QuaZip::mdUnzip));
+    QList<QuaZipFileInfo64> infos = zip.getFileInfoList64();
+    QCOMPARE(infos.size(), entries);
+    for (int i = 0; i < entries; ++i) {
+        QCOMPARE(infos.at(i).name, names.at(i));
+        QCOMPARE(infos.at(i).name, expected.at(i).name);
+        QCOMPARE(infos.at(i).comment, expected.at(i).comment);
+        QCOMPARE(infos.at(i).extra, expected.at(i).extra);
+        QCOMPARE(infos.at(i).crc, expected.at(i).crc);
+    }
+    // going back to the start moves the window back
+    foreach (const QString &name, QStringList() << names.first()
+             << names.last()) {
+        QVERIFY(zip.setCurrentFile(name));
+        QuaZipFile file(&zip);
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        QCOMPARE(file.readAll(), name.toUtf8());
+        file.close();
+    }
+    zip.close();
+    curDir.remove(zipName);
+}
+
+static bool writeCodecArchive(const QString &zipName,
+                              QuaZip::DeflateCodec codec, int level,
+                              const QByteArray &data, int entries)
+{
+    QuaZip zip(zipName);
+    zip.setDeflateCodec(codec);
+    if (!zip.open(QuaZip::mdCreate))
+        return false;
+    bool written = true;
+    for (int i = 0; written && i < entries; ++i) {
+        QuaZipFile zipFile(&zip);
+        written = zipFile.open(QIODevice::WriteOnly,
+                               QuaZipNewInfo(QString("doc%1.xml").arg(i)),
+                               NULL, 0, Z_DEFLATED, level)
+            && zipFile.write(data) == data.size();
+        zipFile.close();
+        written = written && zipFile.getZipError() == ZIP_OK;
+    }
+    zip.close();
+    return written && zip.getZipError() == ZIP_OK;
+}
+
+static bool readCodecArchive(const QString &zipName,
+                             QuaZip::DeflateCodec codec,
+                             QList<QByteArray> *contents)
+{
+    QuaZipSharedArchive archive(zipName);
+    archive.setDeflateCodec(codec);
+    if (!archive.open())
+        return false;
+    bool read = true;
+    for (int i = 0; read && i < archive.getEntriesCount(); ++i) {
+        QuaZipSharedFile file(&archive, i);
+        read = file.open(QIODevice::ReadOnly);
+        contents->append(file.readAll());
+        file.close();
+        read = read && file.getZipError() == UNZ_OK;
+    }
+    archive.close();
+    return read;
+}
+
+void TestQuaZip::deflateCodec_data()
+{
+    QTest::addColumn<int>("codec");
+    QTest::addColumn<int>("level");
+    QTest::addColumn<bool>("extract");
+    const char *names[] = {"zlib", "libdeflate"};
+    const int levels[] = {1, 6, 9};
+    for (int codec = QuaZip::dcZlib; codec <= QuaZip::dcLibdeflate; ++codec) {
+        for (int i = 0; i < 3; ++i) {
+            QTest::newRow(QString("%1 -%2 compress").arg(names[codec])
+                          .arg(levels[i]).toUtf8().constData())
+                << codec << levels[i] << false;
+            QTest::newRow(QString("%1 -%2 extract").arg(names[codec])
+                          .arg(levels[i]).toUtf8().constData())
+                << codec << levels[i] << true;
+        }
+    }
+}
+
+// Compress or extract 16 entries of 1 MB of text-like data with each
+// deflate implementation that is compiled in.
+void TestQuaZip::deflateCodec()
+{
+    QFETCH(int, codec);
+    QFETCH(int, level);
+    QFETCH(bool, extract);
+    const QuaZip::DeflateCodec deflateCodec =
+        static_cast<QuaZip::DeflateCodec>(codec);
+    if (!QuaZip::isDeflateCodecAvailable(deflateCodec))
+        QSKIP("the codec isn't compiled in");
+    const char *words[] = {"<doc>", "</doc>", "table", "row", "cell",
+        "the", "of", "and", "document", "value", "12345", "\n", " ", "=\""};
+    QByteArray data;
+    data.reserve(1024 * 1024 + 16);
+    quint32 seed = 12345;
+    while (data.size() < 1024 * 1024) {
+        seed = seed * 1103515245u + 12345u;
+        data.append(words[(seed >> 16) % 14]);
+    }
+    data.resize(1024 * 1024);
+    const int entries = 16;
+    QDir curDir;
+    QVERIFY(curDir.mkpath("tmp"));
+    const QString zipName = "tmp/codec.zip";
+    QList<QByteArray> contents;
+    if (extract) {
+        QVERIFY(writeCodecArchive(zipName, deflateCodec, level, data, entries));
+        QBENCHMARK_ONCE {
+            QVERIFY(readCodecArchive(zipName, deflateCodec, &contents));
+        }
+    } else {
+        QBENCHMARK_ONCE {
+            QVERIFY(writeCodecArchive(zipName, deflateCodec, level, data,
+                                      entries));
+        }
+        QVERIFY(readCodecArchive(zipName, QuaZip::dcZlib, &contents));
+    }
+    QCOMPARE(contents.size(), entries);
+    for (int i = 0; i < entries; ++i)
+        QVERIFY(contents.at(i) == data);
+    // whatever wrote the archive, the plain unzip code reads it
+    QuaZipFile file(zipName, "doc0.xml");
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QVERIFY(file.readAll() == data);
+    file.close();
+    curDir.remove(zipName);
+}
@@ -49,7 +49,14 @@ private slots:
 #ifdef QUAZIP_TEST_QSAVEFILE
     void saveFileBug();
 #endif
+    void testSequential_data();
     void testSequential();
+    void nameIndex();
+    void nameIndexLookup_data();
+    void nameIndexLookup();
+    void centralDirBuffering();
+    void deflateCodec_data();
+    void deflateCodec();
 };
 
 #endif // QUAZIP_TEST_QUAZIP_H
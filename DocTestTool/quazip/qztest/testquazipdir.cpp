@@ -27,6 +27,7 @@ see quazip/(un)zip.h files for details. Basically it's the zlib license.
 #include <QtTest/QtTest>
 #include <quazip/quazip.h>
 #include <quazip/quazipdir.h>
+#include <quazip/quazipfile.h>
 
 void TestQuaZipDir::entryList_data()
 {
@@ -346,3 +347,70 @@ void TestQuaZipDir::filePath()
     zip.close();
     curDir.remove(zipName);
 }
+
+void TestQuaZipDir::dirTree()
+{
+    QString zipName = "dirTree.zip";
+    QStringList fileNames;
+    fileNames << "a/b/c.txt" << "a/d.txt" << "e.txt";
+    if (!createTestFiles(fileNames)) {
+        QFAIL("Couldn't create test files");
+    }
+    if (!createTestArchive(zipName, fileNames)) {
+        QFAIL("Couldn't create test archive");
+    }
+    removeTestFiles(fileNames);
+    QuaZip zip(zipName);
+    QDir curDir;
+    QVERIFY(zip.open(QuaZip::mdUnzip));
+    QVERIFY(zip.setCurrentFile("e.txt"));
+    QuaZipDir dir(&zip);
+    QCOMPARE(dir.entryList(), QStringList() << "a/" << "e.txt");
+    QVERIFY(dir.exists("a/b/c.txt"));
+    QVERIFY(!dir.exists("a/b/d.txt"));
+    QVERIFY(dir.cd("a"));
+    QCOMPARE(dir.entryList(), QStringList() << "b/" << "d.txt");
+    QList<QuaZipFileInfo64> infos = dir.entryInfoList64();
+    QCOMPARE(infos.size(), 2);
+    // "b/" has no entry of its own
+    QCOMPARE(infos[0].name, QString("b/"));
+    QCOMPARE(infos[0].uncompressedSize, static_cast<quint64>(0));
+    QCOMPARE(infos[1].name, QString("d.txt"));
+    QVERIFY(infos[1].uncompressedSize > 0);
+    dir.setCaseSensitivity(QuaZip::csInsensitive);
+    QVERIFY(dir.exists("D.TXT"));
+    QVERIFY(dir.exists("B/"));
+    QVERIFY(!dir.exists("D.TXT/"));
+    // listing doesn't lose the current file
+    QCOMPARE(zip.getCurrentFileName(), QString("e.txt"));
+    zip.close();
+    // the tree of the previous open must not survive
+    QVERIFY(zip.open(QuaZip::mdAdd));
+    QuaZipFile newFile(&zip);
+    QVERIFY(newFile.open(QIODevice::WriteOnly, QuaZipNewInfo("a/f.txt")));
+    QVERIFY(newFile.write("f") == 1);
+    newFile.close();
+    zip.close();
+    QVERIFY(zip.open(QuaZip::mdUnzip));
+    QuaZipDir reopened(&zip, "a");
+    QCOMPARE(reopened.entryList(), QStringList() << "b/" << "d.txt" << "f.txt");
+    QCOMPARE(reopened.count(), static_cast<uint>(3));
+    zip.close();
+    // the same name twice, each copy is listed with its own size
+    QVERIFY(zip.open(QuaZip::mdAdd));
+    QuaZipFile sameFile(&zip);
+    QVERIFY(sameFile.open(QIODevice::WriteOnly, QuaZipNewInfo("a/d.txt")));
+    QVERIFY(sameFile.write(QByteArray(1000, 'd')) == 1000);
+    sameFile.close();
+    zip.close();
+    QVERIFY(zip.open(QuaZip::mdUnzip));
+    QuaZipDir same(&zip, "a");
+    infos = same.entryInfoList64(QDir::Files, QDir::Size | QDir::Reversed);
+    QCOMPARE(infos.size(), 3);
+    QCOMPARE(infos[0].name, QString("d.txt"));
+    QCOMPARE(infos[0].uncompressedSize, static_cast<quint64>(1000));
+    QCOMPARE(infos[1].name, QString("d.txt"));
+    QVERIFY(infos[1].uncompressedSize < 1000);
+    zip.close();
+    curDir.remove(zipName);
+}
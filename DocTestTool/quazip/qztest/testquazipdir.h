@@ -37,6 +37,7 @@ private slots:
     void entryInfoList();
     void operators();
     void filePath();
+    void dirTree();
 };
 
 #endif // QUAZIP_TEST_QUAZIPDIR_H
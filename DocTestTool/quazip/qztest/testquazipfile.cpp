@@ -29,13 +29,19 @@ see quazip/(un)zip.h files for details. Basically it's the zlib license.
 #include <quazip/JlCompress.h>
 #include <quazip/quazipfile.h>
 #include <quazip/quazip.h>
+#include <quazip/quazipsharedarchive.h>
+#include <quazip/quazipsharedfile.h>
 
 #include <QFile>
 #include <QString>
 #include <QStringList>
+#include <QThread>
+#include <QVector>
 
 #include <QtTest/QtTest>
 
+#include <zlib.h>
+
 void TestQuaZipFile::zipUnzip_data()
 {
     QTest::addColumn<QString>("zipName");
@@ -573,3 +579,481 @@ void TestQuaZipFile::largeFile()
     fakeLargeZip.close();
     curDir.remove("tmp/large.zip");
 }
+
+// Deflates a piece on its own, so that pieces can be concatenated.
+static QByteArray deflatePiece(const QByteArray &piece, bool last)
+{
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS,
+                8, Z_DEFAULT_STRATEGY) != Z_OK)
+        return QByteArray();
+    QByteArray out(deflateBound(&stream, piece.size()) + 16, 0);
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(
+                piece.constData()));
+    stream.avail_in = piece.size();
+    stream.next_out = reinterpret_cast<Bytef*>(out.data());
+    stream.avail_out = out.size();
+    deflate(&stream, last ? Z_FINISH : Z_SYNC_FLUSH);
+    out.resize(stream.total_out);
+    deflateEnd(&stream);
+    return out;
+}
+
+void TestQuaZipFile::closeRaw()
+{
+    QDir curDir;
+    QVERIFY(curDir.mkpath("tmp"));
+    const QString zipName = "tmp/closeRaw.zip";
+    const QByteArray first(100000, 'a');
+    const QByteArray second("and the tail written as another piece");
+    QuaZip zip(zipName);
+    QVERIFY(zip.open(QuaZip::mdCreate));
+    QuaZipFile zipFile(&zip);
+    QuaZipNewInfo newInfo("pieces.txt");
+    newInfo.uncompressedSize = first.size() + second.size();
+    QVERIFY(zipFile.open(QIODevice::WriteOnly, newInfo, NULL, 0,
+                Z_DEFLATED, Z_DEFAULT_COMPRESSION, true));
+    QVERIFY(zipFile.write(deflatePiece(first, false)) > 0);
+    QVERIFY(zipFile.write(deflatePiece(second, true)) > 0);
+    uLong crc = crc32(0L, reinterpret_cast<const Bytef*>(first.constData()),
+            first.size());
+    crc = crc32_combine(crc, crc32(0L,
+                reinterpret_cast<const Bytef*>(second.constData()),
+                second.size()), second.size());
+    zipFile.closeRaw(first.size() + second.size(), crc);
+    QCOMPARE(zipFile.getZipError(), ZIP_OK);
+    zip.close();
+    QVERIFY(zip.open(QuaZip::mdUnzip));
+    QVERIFY(zip.goToFirstFile());
+    QuaZipFile readFile(&zip);
+    QVERIFY(readFile.open(QIODevice::ReadOnly));
+    QCOMPARE(readFile.readAll(), first + second);
+    readFile.close();
+    // a wrong CRC would be reported here
+    QCOMPARE(readFile.getZipError(), UNZ_OK);
+    zip.close();
+    curDir.remove(zipName);
+}
+
+void TestQuaZipFile::discard()
+{
+    QDir curDir;
+    QVERIFY(curDir.mkpath("tmp"));
+    const QString zipName = "tmp/discard.zip";
+    const QByteArray data(100000, 'a');
+    QuaZip zip(zipName);
+    QVERIFY(zip.open(QuaZip::mdCreate));
+    QuaZipFile zipFile(&zip);
+    QStringList names;
+    names << "first.txt" << "failed.txt" << "last.txt";
+    foreach (QString name, names) {
+        QVERIFY(zipFile.open(QIODevice::WriteOnly, QuaZipNewInfo(name)));
+        QCOMPARE(zipFile.write(data), static_cast<qint64>(data.size()));
+        if (name == "failed.txt") {
+            zipFile.discard();
+        } else {
+            zipFile.close();
+        }
+        QCOMPARE(zipFile.getZipError(), ZIP_OK);
+        QVERIFY(!zipFile.isOpen());
+    }
+    zip.close();
+    QCOMPARE(zip.getZipError(), ZIP_OK);
+    QVERIFY(zip.open(QuaZip::mdUnzip));
+    names.removeAll("failed.txt");
+    QCOMPARE(zip.getFileNameList(), names);
+    QVERIFY(zip.setCurrentFile("last.txt"));
+    QuaZipFile readFile(&zip);
+    QVERIFY(readFile.open(QIODevice::ReadOnly));
+    QCOMPARE(readFile.readAll(), data);
+    readFile.close();
+    QCOMPARE(readFile.getZipError(), UNZ_OK);
+    zip.close();
+    curDir.remove(zipName);
+}
+
+// Mix of text-like (PDF content streams) and noise-like (TIFF strips) data.
+// Size in megabytes can be raised with QZTEST_BENCH_MB for a real run,
+// e.g. QZTEST_BENCH_MB=1024 to match a full document export.
+static QByteArray benchmarkData()
+{
+    int megabytes = qgetenv("QZTEST_BENCH_MB").toInt();
+    if (megabytes <= 0)
+        megabytes = 8;
+    QByteArray data;
+    data.reserve(megabytes * 1024 * 1024);
+    quint32 seed = 12345;
+    const QByteArray text("BT /F1 12 Tf 72 712 Td (Document test tool) Tj ET\n");
+    while (data.size() < megabytes * 1024 * 1024) {
+        for (int i = 0; i < 64 * 1024 / text.size(); ++i)
+            data.append(text);
+        for (int i = 0; i < 64 * 1024; ++i) {
+            seed = seed * 1103515245u + 12345u;
+            data.append(static_cast<char>(seed >> 24));
+        }
+    }
+    data.resize(megabytes * 1024 * 1024);
+    return data;
+}
+
+void TestQuaZipFile::writeThroughput_data()
+{
+    QTest::addColumn<int>("blockSize");
+    QTest::newRow("putChar") << 1;
+    QTest::newRow("64K blocks") << 64 * 1024;
+    QTest::newRow("1M blocks") << 1024 * 1024;
+}
+
+void TestQuaZipFile::writeThroughput()
+{
+    QFETCH(int, blockSize);
+    const QByteArray data = benchmarkData();
+    QDir curDir;
+    QVERIFY(curDir.mkpath("tmp"));
+    const QString zipName = "tmp/throughput.zip";
+    QBENCHMARK_ONCE {
+        QuaZip zip(zipName);
+        QVERIFY(zip.open(QuaZip::mdCreate));
+        QuaZipFile zipFile(&zip);
+        QVERIFY(zipFile.open(QIODevice::WriteOnly,
+                QuaZipNewInfo("throughput.bin")));
+        const char *p = data.constData();
+        const char *end = p + data.size();
+        if (blockSize == 1) {
+            while (p != end && zipFile.putChar(*p))
+                ++p;
+        } else {
+            while (p != end) {
+                const qint64 size = qMin<qint64>(blockSize, end - p);
+                QCOMPARE(zipFile.write(p, size), size);
+                p += size;
+            }
+        }
+        zipFile.close();
+        QCOMPARE(zipFile.getZipError(), ZIP_OK);
+        zip.close();
+    }
+    QuaZip zip(zipName);
+    QVERIFY(zip.open(QuaZip::mdUnzip));
+    QVERIFY(zip.goToFirstFile());
+    QuaZipFile zipFile(&zip);
+    QVERIFY(zipFile.open(QIODevice::ReadOnly));
+    QCOMPARE(zipFile.readAll(), data);
+    zipFile.close();
+    zip.close();
+    curDir.remove(zipName);
+}
+
+void TestQuaZipFile::mappedData()
+{
+    QDir curDir;
+    QVERIFY(curDir.mkpath("tmp"));
+    const QString zipName = "tmp/mappedData.zip";
+    const QByteArray stored("stored as it is, readable in place");
+    const QByteArray deflated(10000, 'd');
+    QuaZip zip(zipName);
+    QVERIFY(zip.open(QuaZip::mdCreate));
+    QuaZipFile zipFile(&zip);
+    QVERIFY(zipFile.open(QIODevice::WriteOnly, QuaZipNewInfo("stored.txt"),
+                NULL, 0, 0));
+    zipFile.write(stored);
+    zipFile.close();
+    QVERIFY(zipFile.open(QIODevice::WriteOnly, QuaZipNewInfo("deflated.txt")));
+    zipFile.write(deflated);
+    zipFile.close();
+    zip.close();
+    zip.setMemoryMappingEnabled(true);
+    QVERIFY(zip.open(QuaZip::mdUnzip));
+    QVERIFY(zip.isMemoryMapped());
+    QVERIFY(zip.setCurrentFile("stored.txt"));
+    QuaZipFile readFile(&zip);
+    QVERIFY(readFile.open(QIODevice::ReadOnly));
+    QCOMPARE(readFile.mappedData(), stored);
+    QCOMPARE(readFile.readAll(), stored);
+    readFile.close();
+    QCOMPARE(readFile.getZipError(), UNZ_OK);
+    // deflated data is inflated from the mapping, but can't be viewed
+    QVERIFY(zip.setCurrentFile("deflated.txt"));
+    QVERIFY(readFile.open(QIODevice::ReadOnly));
+    QVERIFY(readFile.mappedData().isNull());
+    QCOMPARE(readFile.readAll(), deflated);
+    readFile.close();
+    QCOMPARE(readFile.getZipError(), UNZ_OK);
+    QVERIFY(readFile.open(QIODevice::ReadOnly, NULL, NULL, true));
+    QuaZipFileInfo64 info;
+    QVERIFY(zip.getCurrentFileInfo(&info));
+    QCOMPARE(static_cast<quint64>(readFile.mappedData().size()),
+             info.compressedSize);
+    readFile.close();
+    zip.close();
+    QVERIFY(!zip.isMemoryMapped());
+    zip.setMemoryMappingEnabled(false);
+    QVERIFY(zip.open(QuaZip::mdUnzip));
+    QVERIFY(!zip.isMemoryMapped());
+    QVERIFY(zip.setCurrentFile("stored.txt"));
+    QVERIFY(readFile.open(QIODevice::ReadOnly));
+    QVERIFY(readFile.mappedData().isNull());
+    readFile.close();
+    zip.close();
+    curDir.remove(zipName);
+}
+
+void TestQuaZipFile::mappedRead_data()
+{
+    QTest::addColumn<bool>("mapped");
+    QTest::newRow("device") << false;
+    QTest::newRow("mapped") << true;
+}
+
+// Inflates the benchmarkData() archive, see writeThroughput() for the size.
+void TestQuaZipFile::mappedRead()
+{
+    QFETCH(bool, mapped);
+    const QByteArray data = benchmarkData();
+    QDir curDir;
+    QVERIFY(curDir.mkpath("tmp"));
+    const QString zipName = "tmp/mappedRead.zip";
+    {
+        QuaZip zip(zipName);
+        QVERIFY(zip.open(QuaZip::mdCreate));
+        QuaZipFile zipFile(&zip);
+        QVERIFY(zipFile.open(QIODevice::WriteOnly,
+                QuaZipNewInfo("throughput.bin")));
+        zipFile.write(data);
+        zipFile.close();
+        zip.close();
+    }
+    QByteArray read;
+    QBENCHMARK_ONCE {
+        QuaZip zip(zipName);
+        zip.setMemoryMappingEnabled(mapped);
+        QVERIFY(zip.open(QuaZip::mdUnzip));
+        QCOMPARE(zip.isMemoryMapped(), mapped);
+        QVERIFY(zip.goToFirstFile());
+        QuaZipFile zipFile(&zip);
+        QVERIFY(zipFile.open(QIODevice::ReadOnly));
+        read = zipFile.readAll();
+        zipFile.close();
+        QCOMPARE(zipFile.getZipError(), UNZ_OK);
+        zip.close();
+    }
+    QCOMPARE(read, data);
+    curDir.remove(zipName);
+}
+
+void TestQuaZipFile::sharedArchive()
+{
+    QDir curDir;
+    QVERIFY(curDir.mkpath("tmp"));
+    const QString zipName = "tmp/sharedArchive.zip";
+    const QByteArray stored("stored as it is");
+    const QByteArray deflated(100000, 'd');
+    {
+        QuaZip zip(zipName);
+        QVERIFY(zip.open(QuaZip::mdCreate));
+        QuaZipFile zipFile(&zip);
+        QVERIFY(zipFile.open(QIODevice::WriteOnly,
+                QuaZipNewInfo("stored.txt"), NULL, 0, 0));
+        zipFile.write(stored);
+        zipFile.close();
+        QVERIFY(zipFile.open(QIODevice::WriteOnly,
+                QuaZipNewInfo("Deflated.txt")));
+        zipFile.write(deflated);
+        zipFile.close();
+        zip.close();
+    }
+    QuaZipSharedArchive archive(zipName);
+    QVERIFY(archive.open());
+    QVERIFY(archive.isMapped());
+    QCOMPARE(archive.getEntriesCount(), 2);
+    QCOMPARE(archive.getFileNameList(),
+             QStringList() << "stored.txt" << "Deflated.txt");
+    QCOMPARE(archive.indexOf("stored.txt"), 0);
+    QCOMPARE(archive.indexOf("deflated.txt", QuaZip::csSensitive), -1);
+    QCOMPARE(archive.indexOf("deflated.txt", QuaZip::csInsensitive), 1);
+    // two readers of one archive, read in turns
+    QuaZipSharedFile storedFile(&archive, "stored.txt");
+    QuaZipSharedFile deflatedFile(&archive, 1);
+    QVERIFY(storedFile.open(QIODevice::ReadOnly));
+    QVERIFY(deflatedFile.open(QIODevice::ReadOnly));
+    QCOMPARE(deflatedFile.size(), static_cast<qint64>(deflated.size()));
+    QByteArray storedRead, deflatedRead;
+    while (!storedFile.atEnd() || !deflatedFile.atEnd()) {
+        storedRead += storedFile.read(4);
+        deflatedRead += deflatedFile.read(1000);
+    }
+    QCOMPARE(storedRead, stored);
+    QCOMPARE(deflatedRead, deflated);
+    storedFile.close();
+    QCOMPARE(storedFile.getZipError(), UNZ_OK);
+    deflatedFile.close();
+    QCOMPARE(deflatedFile.getZipError(), UNZ_OK);
+    QuaZipSharedFile missing(&archive, "missing.txt");
+    QVERIFY(!missing.open(QIODevice::ReadOnly));
+    archive.close();
+    QVERIFY(!archive.isOpen());
+    curDir.remove(zipName);
+}
+
+namespace {
+
+// Reads every threads-th file of a shared archive, starting from first.
+class SharedReadThread: public QThread {
+public:
+    SharedReadThread(const QuaZipSharedArchive *archive, int first,
+                     int threads):
+        failed(0), archive(archive), first(first), threads(threads) {}
+    int failed;
+protected:
+    void run()
+    {
+        for (int i = first; i < archive->getEntriesCount(); i += threads) {
+            QuaZipSharedFile file(archive, i);
+            if (!file.open(QIODevice::ReadOnly)) {
+                ++failed;
+                continue;
+            }
+            char buf[64 * 1024];
+            while (file.read(buf, sizeof(buf)) > 0)
+                ;
+            file.close();
+            if (file.getZipError() != UNZ_OK)
+                ++failed;
+        }
+    }
+private:
+    const QuaZipSharedArchive *archive;
+    int first;
+    int threads;
+};
+
+}
+
+void TestQuaZipFile::sharedArchiveParallel_data()
+{
+    QTest::addColumn<int>("threads");
+    QTest::newRow("1 thread") << 1;
+    QTest::newRow("4 threads") << 4;
+}
+
+// Inflates 16 copies of benchmarkData(), see writeThroughput() for the size.
+void TestQuaZipFile::sharedArchiveParallel()
+{
+    QFETCH(int, threads);
+    const QByteArray data = benchmarkData();
+    QDir curDir;
+    QVERIFY(curDir.mkpath("tmp"));
+    const QString zipName = "tmp/sharedArchiveParallel.zip";
+    {
+        QuaZip zip(zipName);
+        QVERIFY(zip.open(QuaZip::mdCreate));
+        QuaZipFile zipFile(&zip);
+        for (int i = 0; i < 16; ++i) {
+            QVERIFY(zipFile.open(QIODevice::WriteOnly,
+                    QuaZipNewInfo(QString("file%1.bin").arg(i))));
+            zipFile.write(data);
+            zipFile.close();
+        }
+        zip.close();
+    }
+    QuaZipSharedArchive archive(zipName);
+    QVERIFY(archive.open());
+    int failed = 0;
+    QBENCHMARK_ONCE {
+        QVector<SharedReadThread*> readers;
+        for (int i = 0; i < threads; ++i) {
+            readers.append(new SharedReadThread(&archive, i, threads));
+            readers.last()->start();
+        }
+        for (int i = 0; i < threads; ++i) {
+            readers.at(i)->wait();
+            failed += readers.at(i)->failed;
+            delete readers.at(i);
+        }
+    }
+    QCOMPARE(failed, 0);
+    archive.close();
+    curDir.remove(zipName);
+}
+
+void TestQuaZipFile::zstd_data()
+{
+    QTest::addColumn<int>("size");
+    QTest::addColumn<int>("level");
+    QTest::addColumn<int>("workers");
+    QTest::newRow("empty") << 0 << 3 << 0;
+    QTest::newRow("small") << 1000 << 3 << 0;
+    QTest::newRow("default level") << 300000 << (int) Z_DEFAULT_COMPRESSION << 0;
+    QTest::newRow("fast") << 300000 << 1 << 0;
+    QTest::newRow("strong") << 300000 << 19 << 0;
+    QTest::newRow("large") << 20 * 1024 * 1024 << 3 << 0;
+    QTest::newRow("large, 4 workers") << 20 * 1024 * 1024 << 3 << 4;
+}
+
+void TestQuaZipFile::zstd()
+{
+    QFETCH(int, size);
+    QFETCH(int, level);
+    QFETCH(int, workers);
+    if (!QuaZip::isZstdAvailable())
+        QSKIP("QuaZIP is built without HAVE_ZSTD");
+    QByteArray data(size, '\0');
+    quint32 seed = 12345;
+    for (int i = 0; i < size; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        // compressible, but not trivially
+        data[i] = static_cast<char>('a' + (seed >> 28));
+    }
+    QDir curDir;
+    QVERIFY(curDir.mkpath("tmp"));
+    const QString zipName = "tmp/zstd.zip";
+    {
+        QuaZip zip(zipName);
+        zip.setZstdWorkers(workers);
+        QVERIFY(zip.open(QuaZip::mdCreate));
+        QuaZipFile zipFile(&zip);
+        QVERIFY(zipFile.open(QIODevice::WriteOnly, QuaZipNewInfo("zstd.txt"),
+                             NULL, 0, Z_ZSTD, level));
+        // in pieces, so the frame spans several writes
+        for (int pos = 0; pos < size; pos += 100000)
+            QCOMPARE(zipFile.write(data.mid(pos, 100000)),
+                     static_cast<qint64>(qMin(100000, size - pos)));
+        zipFile.close();
+        QCOMPARE(zipFile.getZipError(), ZIP_OK);
+        // and a deflated one after it, in the same archive
+        QVERIFY(zipFile.open(QIODevice::WriteOnly,
+                             QuaZipNewInfo("deflated.txt")));
+        zipFile.write(data);
+        zipFile.close();
+        zip.close();
+        QCOMPARE(zip.getZipError(), ZIP_OK);
+    }
+    QuaZipFile zipFile(zipName, "zstd.txt");
+    int method = 0;
+    QVERIFY(zipFile.open(QIODevice::ReadOnly, &method, NULL, false));
+    QCOMPARE(method, static_cast<int>(Z_ZSTD));
+    QuaZipFileInfo64 info;
+    QVERIFY(zipFile.getFileInfo(&info));
+    QCOMPARE(info.method, static_cast<quint16>(Z_ZSTD));
+    QCOMPARE(info.versionNeeded, static_cast<quint16>(63));
+    QVERIFY(zipFile.readAll() == data);
+    zipFile.close();
+    QCOMPARE(zipFile.getZipError(), UNZ_OK);
+    zipFile.setFileName("deflated.txt");
+    QVERIFY(zipFile.open(QIODevice::ReadOnly));
+    QVERIFY(zipFile.readAll() == data);
+    zipFile.close();
+    QuaZipSharedArchive archive(zipName);
+    QVERIFY(archive.open());
+    QuaZipSharedFile sharedFile(&archive, "zstd.txt");
+    QVERIFY(sharedFile.open(QIODevice::ReadOnly));
+    QByteArray sharedRead;
+    while (!sharedFile.atEnd())
+        sharedRead += sharedFile.read(65536);
+    sharedFile.close();
+    QCOMPARE(sharedFile.getZipError(), UNZ_OK);
+    QVERIFY(sharedRead == data);
+    archive.close();
+    curDir.remove(zipName);
+}
@@ -48,6 +48,18 @@ private slots:
     void constructorDestructor();
     void setFileAttrs();
     void largeFile();
+    void closeRaw();
+    void discard();
+    void writeThroughput_data();
+    void writeThroughput();
+    void mappedData();
+    void mappedRead_data();
+    void mappedRead();
+    void sharedArchive();
+    void sharedArchiveParallel_data();
+    void sharedArchiveParallel();
+    void zstd_data();
+    void zstd();
 };
 
 #endif // QUAZIP_TEST_QUAZIPFILE_H
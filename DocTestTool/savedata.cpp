@@ -26,6 +26,11 @@ bool SaveData::prepareFolders()
         QDir().mkdir(getDocsFilePath());
     }
 
+    if (!QDir(getIndexFilePath()).exists())
+    {
+        QDir().mkdir(getIndexFilePath());
+    }
+
     // create file for default tags
     QFile tagsFile(getConfigFilePath());
     if (!tagsFile.exists())
@@ -41,6 +46,10 @@ bool SaveData::prepareFolders()
 void SaveData::loadConfig()
 {
     defaultTags.clear();
+    tagRules.clear();
+    compression.clearOverrides();
+    deflateCacheMegabytes = 0;
+    tagMirror = false;
     QFile tagsFile(SaveData::getConfigFilePath());
     if (tagsFile.open(QIODevice::ReadOnly))
     {
@@ -73,10 +82,64 @@ void SaveData::loadConfig()
                 }
 
             }
+            // load tagging rules
+            QJsonValue rulesValue = obj[Constants::kRules];
+            if (rulesValue.isArray())
+            {
+                QJsonArray array = rulesValue.toArray();
+                for (int i = 0, iEnd = array.size(); i < iEnd; ++i)
+                {
+                    QJsonObject ruleObj = array[i].toObject();
+                    TagRule rule;
+                    rule.pattern = ruleObj[Constants::kMatch].toString();
+                    const QString scope = ruleObj[Constants::kScope].toString();
+                    if (scope == Constants::kScopeContent)
+                    {
+                        rule.scope = TagRule::Content;
+                    }
+                    else if (scope == Constants::kScopeAny)
+                    {
+                        rule.scope = TagRule::Any;
+                    }
+                    QJsonArray ruleTags = ruleObj[Constants::kTags].toArray();
+                    for (int j = 0, jEnd = ruleTags.size(); j < jEnd; ++j)
+                    {
+                        rule.tags.push_back(ruleTags[j].toString());
+                    }
+                    rule.templateName = ruleObj[Constants::kTemplate].toString();
+                    if (!rule.pattern.isEmpty())
+                    {
+                        tagRules.push_back(rule);
+                    }
+                }
+            }
+            // load per extension compression, e.g. {"tiff": "deflate", "bmp": "deflate"}
+            QJsonValue compressionValue = obj[Constants::kCompression];
+            if (compressionValue.isObject())
+            {
+                QJsonObject compressionObj = compressionValue.toObject();
+                for (auto it = compressionObj.constBegin(); it != compressionObj.constEnd(); ++it)
+                {
+                    const QString method = it.value().toString();
+                    if (method == Constants::kStore)
+                    {
+                        compression.setOverride(it.key(), CompressionPolicy::Store);
+                    }
+                    else if (method == Constants::kDeflate)
+                    {
+                        compression.setOverride(it.key(), CompressionPolicy::Deflate);
+                    }
+                }
+            }
+            // load the disk budget of deflate sidecars
+            deflateCacheMegabytes = qMax(0, obj[Constants::kDeflateCacheBudget].toInt());
+            // load whether the by-tag folder is kept
+            tagMirror = obj[Constants::kTagMirror].toBool();
         }
         tagsFile.close();
     }
     defaultTags.sort();
+    tagMatcher.compile(tagRules, templates);
 }
 
 QString SaveData::getConfigFilePath()
@@ -97,6 +160,29 @@ QString SaveData::getDocsFilePath()
     return QDir(Constants::kBaseFolder).filePath(Constants::kDocsFolder);
 }
 
+QString SaveData::getIndexFilePath()
+{
+    if (QDir(workingFolder).exists())
+    {
+        return QDir(workingFolder).filePath(Constants::kIndexFolder);
+    }
+    return QDir(Constants::kBaseFolder).filePath(Constants::kIndexFolder);
+}
+
+QString SaveData::getMirrorFilePath()
+{
+    if (QDir(workingFolder).exists())
+    {
+        return QDir(workingFolder).filePath(Constants::kMirrorFolder);
+    }
+    return QDir(Constants::kBaseFolder).filePath(Constants::kMirrorFolder);
+}
+
+TagMirror SaveData::getTagMirror()
+{
+    return TagMirror(tagMirror ? getMirrorFilePath() : QString(), getDocsFilePath());
+}
+
 bool SaveData::exportTagsToFile(QFile & file)
 {
     QString defaultTagsStr;
@@ -125,6 +211,51 @@ bool SaveData::exportTagsToFile(QFile & file)
     const QString val = valTmpl.arg(defaultTagsStr).arg(templatesStr);
 
     QJsonDocument jsonDoc = QJsonDocument::fromJson(val.toUtf8());
+    if (!jsonDoc.isNull() && !compression.overrides().isEmpty())
+    {
+        QJsonObject compressionObj;
+        auto methodIt = compression.overrides().constBegin();
+        while (methodIt != compression.overrides().constEnd())
+        {
+            compressionObj[methodIt.key()] = methodIt.value() == CompressionPolicy::Store ? Constants::kStore : Constants::kDeflate;
+            ++methodIt;
+        }
+        QJsonObject obj = jsonDoc.object();
+        obj[Constants::kCompression] = compressionObj;
+        jsonDoc.setObject(obj);
+    }
+    if (!jsonDoc.isNull() && (deflateCacheMegabytes > 0 || tagMirror))
+    {
+        QJsonObject obj = jsonDoc.object();
+        if (deflateCacheMegabytes > 0)
+        {
+            obj[Constants::kDeflateCacheBudget] = deflateCacheMegabytes;
+        }
+        if (tagMirror)
+        {
+            obj[Constants::kTagMirror] = true;
+        }
+        jsonDoc.setObject(obj);
+    }
+    if (!jsonDoc.isNull() && !tagRules.isEmpty())
+    {
+        QJsonArray rulesArray;
+        for (const TagRule & rule : tagRules)
+        {
+            QJsonObject ruleObj;
+            ruleObj[Constants::kMatch] = rule.pattern;
+            ruleObj[Constants::kScope] = rule.scope == TagRule::Any ? Constants::kScopeAny : (rule.scope == TagRule::Content ? Constants::kScopeContent : Constants::kScopePath);
+            ruleObj[Constants::kTags] = QJsonArray::fromStringList(rule.tags);
+            if (!rule.templateName.isEmpty())
+            {
+                ruleObj[Constants::kTemplate] = rule.templateName;
+            }
+            rulesArray.append(ruleObj);
+        }
+        QJsonObject obj = jsonDoc.object();
+        obj[Constants::kRules] = rulesArray;
+        jsonDoc.setObject(obj);
+    }
     QByteArray json = jsonDoc.toJson(QJsonDocument::Indented);
     if (!jsonDoc.isNull())
     {
@@ -183,6 +314,7 @@ void SaveData::loadFilesData()
                 }
 
                 docInfo.filePath = QDir(path).absoluteFilePath(docInfo.fileName);
+                docInfo.md5 = info.fileName();
 
                 folderDocsData.append(docInfo);
             }
@@ -5,6 +5,11 @@
 #include <QMap>
 #include <QFile>
 
+#include "compressionpolicy.h"
+#include "tagmatcher.h"
+#include "tagmirror.h"
+
+class BackgroundJob;
 struct DocInfo;
 
 struct SaveData
@@ -13,6 +18,12 @@ struct SaveData
     QStringList defaultTags; // list of default tags
     QMap<QString, QStringList> templates; // templates with tag lists
     QList<DocInfo> folderDocsData; // files that are stored in the app folder
+    QList<TagRule> tagRules; // rules that tag documents on upload
+    TagMatcher tagMatcher; // tag rules compiled for matching
+    CompressionPolicy compression; // store or deflate for exported documents
+    int deflateCacheMegabytes = 0; // disk budget of deflate sidecars, 0 turns them off
+    bool tagMirror = false; // keep the by-tag folder of links up to date
+    QList<BackgroundJob *> jobs; // running uploads and exports, owned by the main window
     //
     bool prepareFolders();
     //
@@ -25,6 +36,12 @@ struct SaveData
     QString getConfigFilePath();
     //
     QString getDocsFilePath();
+    // folder of the full text index
+    QString getIndexFilePath();
+    // folder of the by-tag links
+    QString getMirrorFilePath();
+    // turned off unless enabled in config
+    TagMirror getTagMirror();
 };
 
 #endif // SAVE_DATA_H
@@ -18,6 +18,7 @@ Screen::Screen(QWidget * parent, Ui::DocTestToolClass * ui, SaveData * save)
     ui_->editBtn->setVisible(false);
     ui_->searchBtn->setVisible(false);
     ui_->progressBar->setVisible(false);
+    ui_->cancelBtn->setVisible(false);
     ui_->findBtn->setVisible(false);
     ui_->inputTextEdit->setVisible(false);
     ui_->inputTextEdit2->setVisible(false);
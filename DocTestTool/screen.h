@@ -29,6 +29,9 @@ public:
         DocsListDoubleClicked,
         EditComboBoxChanged,
         LoginButtonClicked,
+        AddFolderClicked,
+        AddArchiveClicked,
+        ExportFolderClicked,
     };
 protected:
     enum ClearMode
@@ -2,15 +2,16 @@
 
 #include <QFileDialog>
 #include <QDesktopServices>
-#include "quazip.h"
-#include "quazipfile.h"
-#include "quazipnewinfo.h"
 #include "QTimer"
 #include "QThread"
 
 #include "constants.h"
 #include "docinfo.h"
+#include "exportjob.h"
+#include "folderexportjob.h"
+#include "fulltextindex.h"
 #include "savedata.h"
+#include "tarexportjob.h"
 
 //=============================================================================
 // class SearchScreen
@@ -44,6 +45,7 @@ SearchScreen::SearchScreen(QWidget * parent, Ui::DocTestToolClass * ui, SaveData
     ui->deleteBtn->setVisible(true);
     ui->backBtn->setVisible(true);
     ui->searchComboBox->setVisible(true);
+    ui->searchComboBox->addItem(Constants::kContentCombo);
 
     timer_ = new QTimer();
     QObject::connect(timer_, &QTimer::timeout, [&]() {onTimerElapsed(); });
@@ -52,6 +54,8 @@ SearchScreen::SearchScreen(QWidget * parent, Ui::DocTestToolClass * ui, SaveData
 
 SearchScreen::~SearchScreen()
 {
+    ui_->searchComboBox->removeItem(ui_->searchComboBox->findText(Constants::kContentCombo));
+
     if (timer_)
     {
         timer_->stop();
@@ -88,6 +92,10 @@ void SearchScreen::processUserEvent(Screen::UserEvent event)
             {
                 findName();
             }
+            else if (currentText == Constants::kContentCombo)
+            {
+                findContent();
+            }
         }
         break;
         case Screen::UserEvent::SaveBtnClicked:
@@ -95,6 +103,11 @@ void SearchScreen::processUserEvent(Screen::UserEvent event)
             save();
         }
         break;
+        case Screen::UserEvent::ExportFolderClicked:
+        {
+            saveToFolder();
+        }
+        break;
         case Screen::UserEvent::ClearBtnClicked:
         {
             clearWidgets(ClearMode::ClearInputText);
@@ -189,12 +202,16 @@ void SearchScreen::deleteFromDisk()
     // get rows
     QModelIndexList indexes = ui_->docsListWidget->selectionModel()->selectedIndexes();
 
+    const TagMirror mirror = save_->getTagMirror();
+    FullTextIndex textIndex(save_->getIndexFilePath());
     for (QModelIndex & index : indexes)
     {
         const int i = index.row();
         if (i < foundDocsData_.size())
         {
             DocInfo & docInfo = foundDocsData_[i];
+            mirror.remove(docInfo);
+            textIndex.removeDocument(docInfo.md5);
             QFile file(docInfo.filePath);
             QFileInfo fileInfo(file);
             QString path = fileInfo.path();
@@ -240,44 +257,70 @@ void SearchScreen::save()
         return;
     }
 
-    QString fileName = QFileDialog::getSaveFileName(parent_, "Save File", "documents.zip", "Zip *.zip");
+    // an update adds to the chosen archive, so there's nothing to confirm
+    const bool update = ui_->actionUpdateArchive->isChecked();
+    const QString zipFilter = "Zip (*.zip)";
+    QString filters = zipFilter;
+#ifdef HAVE_ZSTD
+    // only zips can be updated
+    const QString tarFilter = "Tar+zstd (*.tar.zst)";
+    if (!update)
+    {
+        filters.append(";;").append(tarFilter);
+    }
+#endif
+    QString selectedFilter;
+    QString fileName = QFileDialog::getSaveFileName(parent_, update ? "Update Archive" : "Save File", "documents.zip", filters,
+        &selectedFilter, update ? QFileDialog::DontConfirmOverwrite : QFileDialog::Options());
     if (!fileName.isEmpty())
     {
-        ui_->progressBar->setVisible(true);
-        ui_->progressBar->setValue(0);
-
-        QString delimiter = ui_->actionSingleFolder->isChecked() ? "-" : "/";
-        char c;
-        if (!fileName.endsWith(".zip"))
-        {
-            fileName.append(".zip");
-        }
-        QuaZip zip(fileName);
-        if (zip.open(QuaZip::mdCreate))
+        bool isZip = true;
+#ifdef HAVE_ZSTD
+        isZip = selectedFilter != tarFilter && !fileName.endsWith(".tar.zst");
+#endif
+        const QString suffix = isZip ? ".zip" : ".tar.zst";
+        // named pipes and devices are streamed to as they are
+        const QFileInfo target(fileName);
+        if (!fileName.endsWith(suffix) && (!target.exists() || target.isFile()))
         {
-            int i = 0;
-            ui_->progressBar->setMaximum(foundDocsData_.size());
-            for (DocInfo & info : foundDocsData_)
+            if (fileName.endsWith(".zip"))
             {
-                QFile inFile(info.filePath);
-                if (inFile.open(QIODevice::ReadOnly))
-                {
-                    const QString zipPath = QString::number(++i).append(delimiter).append(info.fileName);
-                    QuaZipNewInfo zipInfo(zipPath, info.filePath);
-                    QuaZipFile zipFile(&zip);
-                    if (zipFile.open(QIODevice::WriteOnly, zipInfo))
-                    {
-                        while (inFile.getChar(&c) && zipFile.putChar(c));
-                        zipFile.close();
-                    }
-                    inFile.close();
-                }
-                ui_->progressBar->setValue(ui_->progressBar->value() + 1);
+                fileName.chop(4);
             }
-            zip.close();
+            fileName.append(suffix);
+        }
+        // the main window reports progress, searching goes on meanwhile
+        BackgroundJob * job = nullptr;
+        if (isZip)
+        {
+            job = new ExportJob(*save_, foundDocsData_, fileName, ui_->actionSingleFolder->isChecked(), update);
         }
-        ui_->progressBar->setValue(ui_->progressBar->maximum());
-        ui_->progressBar->setVisible(false);
+#ifdef HAVE_ZSTD
+        else
+        {
+            job = new TarExportJob(foundDocsData_, fileName, ui_->actionSingleFolder->isChecked());
+        }
+#endif
+        save_->jobs.append(job);
+        job->start();
+    }
+}
+
+void SearchScreen::saveToFolder()
+{
+    if (foundDocsData_.size() == 0)
+    {
+        ui_->statusBar->setStyleSheet("color: red");
+        ui_->statusBar->showMessage("No files to save!", 2000);
+        return;
+    }
+
+    const QString folderPath = QFileDialog::getExistingDirectory(parent_, "Export To Folder");
+    if (!folderPath.isEmpty())
+    {
+        FolderExportJob * job = new FolderExportJob(foundDocsData_, folderPath, ui_->actionSingleFolder->isChecked());
+        save_->jobs.append(job);
+        job->start();
     }
 }
 
@@ -399,6 +442,46 @@ void SearchScreen::findName()
         }
     }
 
+    clearWidgets(ClearMode::ClearDocsList);
+    for (DocInfo & info : foundDocsData_)
+    {
+        ui_->docsListWidget->addItem(info.fileName);
+    }
+}
+
+void SearchScreen::findContent()
+{
+    foundDocsData_.clear();
+
+    const QString findText = ui_->inputTextEdit->text();
+    if (!findText.isEmpty())
+    {
+        const QStringList searchTexts = findText.simplified().split(Constants::kDelimiter);
+
+        FullTextIndex index(save_->getIndexFilePath());
+        QSet<QString> docs;
+        if (ui_->fullMatchBox->isChecked())
+        {
+            docs = index.find(searchTexts.join(" "));
+        }
+        else
+        {
+            for (const QString & text : searchTexts)
+            {
+                docs.unite(index.find(text));
+            }
+        }
+
+        // the catalog also drops documents deleted outside the tool
+        for (DocInfo & info : save_->folderDocsData)
+        {
+            if (docs.contains(info.md5))
+            {
+                foundDocsData_.append(info);
+            }
+        }
+    }
+
     clearWidgets(ClearMode::ClearDocsList);
     for (DocInfo & info : foundDocsData_)
     {
@@ -23,8 +23,12 @@ private:
     void doStrictSearch();
     //
     void findName();
+    // look words up in the full text index
+    void findContent();
     // save files to hard drive based on search results
     void save();
+    // link or clone search results into a folder instead of zipping them
+    void saveToFolder();
     // delete files from search result
     void deleteFromDocs();
     // delete files from hard drive
@@ -0,0 +1,191 @@
+#include "tagmatcher.h"
+
+#include <QQueue>
+
+#include <algorithm>
+
+namespace
+{
+    inline uchar foldCase(uchar c)
+    {
+        return (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c;
+    }
+}
+
+//=============================================================================
+// class TagMatcher
+//=============================================================================
+TagMatcher::TagMatcher()
+    : classCount_(1)
+    , scopes_(0)
+{
+    std::fill(classOf_, classOf_ + 256, 0);
+}
+
+void TagMatcher::compile(const QList<TagRule> & rules, const QMap<QString, QStringList> & templates)
+{
+    ruleTags_.clear();
+    ruleScopes_.clear();
+    transitions_.clear();
+    outputs_.clear();
+    scopes_ = 0;
+    classCount_ = 1;
+    std::fill(classOf_, classOf_ + 256, 0);
+
+    QList<QByteArray> patterns;
+    for (const TagRule & rule : rules)
+    {
+        const QByteArray pattern = rule.pattern.toUtf8();
+        if (pattern.isEmpty())
+        {
+            continue;
+        }
+        QStringList tags = rule.tags;
+        auto it = templates.find(rule.templateName);
+        if (it != templates.constEnd())
+        {
+            for (const QString & tag : it.value())
+            {
+                if (!tags.contains(tag))
+                {
+                    tags.append(tag);
+                }
+            }
+        }
+        patterns.append(pattern);
+        ruleTags_.append(tags);
+        ruleScopes_.append(rule.scope);
+        scopes_ |= rule.scope;
+    }
+
+    if (patterns.isEmpty())
+    {
+        return;
+    }
+
+    // only bytes that occur in patterns get their own class, it keeps the table narrow
+    for (const QByteArray & pattern : patterns)
+    {
+        for (char c : pattern)
+        {
+            const uchar folded = foldCase(uchar(c));
+            if (classOf_[folded] == 0)
+            {
+                classOf_[folded] = classCount_++;
+            }
+        }
+    }
+    for (int c = 'A'; c <= 'Z'; ++c)
+    {
+        classOf_[c] = classOf_[foldCase(uchar(c))];
+    }
+
+    // build the trie, -1 marks a missing edge
+    transitions_.fill(-1, classCount_);
+    outputs_.resize(1);
+    for (int rule = 0, ruleEnd = patterns.size(); rule < ruleEnd; ++rule)
+    {
+        int node = 0;
+        for (char c : patterns[rule])
+        {
+            const int edge = node * classCount_ + classOf_[uchar(c)];
+            if (transitions_[edge] < 0)
+            {
+                transitions_[edge] = outputs_.size();
+                outputs_.append(QVector<int>());
+                transitions_.resize(outputs_.size() * classCount_);
+                std::fill(transitions_.end() - classCount_, transitions_.end(), -1);
+            }
+            node = transitions_[edge];
+        }
+        outputs_[node].append(rule);
+    }
+
+    // breadth first pass turns the trie into a complete automaton following the failure links
+    QVector<int> fail(outputs_.size(), 0);
+    QQueue<int> queue;
+    for (int c = 0; c < classCount_; ++c)
+    {
+        int & next = transitions_[c];
+        if (next < 0)
+        {
+            next = 0;
+        }
+        else
+        {
+            queue.enqueue(next);
+        }
+    }
+    while (!queue.isEmpty())
+    {
+        const int node = queue.dequeue();
+        for (int c = 0; c < classCount_; ++c)
+        {
+            int & next = transitions_[node * classCount_ + c];
+            const int fallback = transitions_[fail[node] * classCount_ + c];
+            if (next < 0)
+            {
+                next = fallback;
+            }
+            else
+            {
+                fail[next] = fallback;
+                outputs_[next] += outputs_[fallback];
+                queue.enqueue(next);
+            }
+        }
+    }
+}
+
+TagMatcher::Scan TagMatcher::begin() const
+{
+    Scan scan;
+    scan.matched.fill(false, ruleTags_.size());
+    return scan;
+}
+
+void TagMatcher::feed(Scan & scan, const char * data, qint64 size, int scope) const
+{
+    if (isEmpty() || !hasScope(scope))
+    {
+        return;
+    }
+    const int * table = transitions_.constData();
+    int node = scan.node;
+    for (qint64 i = 0; i < size; ++i)
+    {
+        node = table[node * classCount_ + classOf_[uchar(data[i])]];
+        const QVector<int> & output = outputs_[node];
+        for (int rule : output)
+        {
+            if (ruleScopes_[rule] & scope)
+            {
+                scan.matched[rule] = true;
+            }
+        }
+    }
+    scan.node = node;
+}
+
+void TagMatcher::feed(Scan & scan, const QString & text, int scope) const
+{
+    const QByteArray data = text.toUtf8();
+    feed(scan, data.constData(), data.size(), scope);
+}
+
+void TagMatcher::apply(const Scan & scan, QStringList & tags) const
+{
+    for (int rule = 0, ruleEnd = scan.matched.size(); rule < ruleEnd; ++rule)
+    {
+        if (scan.matched[rule])
+        {
+            for (const QString & tag : ruleTags_[rule])
+            {
+                if (!tags.contains(tag))
+                {
+                    tags.append(tag);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef TAG_MATCHER_H
+#define TAG_MATCHER_H
+
+#include <QStringList>
+#include <QVector>
+#include <QMap>
+
+struct TagRule
+{
+    enum Scope
+    {
+        Path = 0x1, // file path and file name
+        Content = 0x2, // text of the document
+        Any = Path | Content,
+    };
+
+    QString pattern; // literal keyword, ASCII letters are case insensitive
+    int scope = Path;
+    QStringList tags; // tags added on match
+    QString templateName; // template whose tags are added on match
+};
+
+// All rules are compiled into one Aho-Corasick automaton with a dense transition table,
+// so a document is classified in a single pass whatever the number of rules is.
+class TagMatcher
+{
+public:
+    struct Scan
+    {
+        int node = 0; // automaton state, kept between fed chunks
+        QVector<bool> matched; // rules that fired
+    };
+private:
+    QVector<QStringList> ruleTags_; // tags with template tags resolved
+    QVector<int> ruleScopes_;
+    int classOf_[256]; // byte to input class, 0 is the class of bytes used by no pattern
+    int classCount_;
+    QVector<int> transitions_; // node * classCount_ + class -> node
+    QVector<QVector<int>> outputs_; // rules ending at the node, including its suffixes
+    int scopes_; // union of rule scopes
+public:
+    //
+    TagMatcher();
+    //
+    void compile(const QList<TagRule> & rules, const QMap<QString, QStringList> & templates);
+    //
+    bool isEmpty() const { return ruleTags_.isEmpty(); }
+    //
+    bool hasScope(int scope) const { return (scopes_ & scope) != 0; }
+    //
+    Scan begin() const;
+    // advance the automaton over the chunk, a new text should start from a reset node
+    void feed(Scan & scan, const char * data, qint64 size, int scope) const;
+    //
+    void feed(Scan & scan, const QString & text, int scope) const;
+    // append tags of fired rules that are not in the list yet
+    void apply(const Scan & scan, QStringList & tags) const;
+};
+
+#endif // TAG_MATCHER_H
@@ -0,0 +1,221 @@
+#include "tagmirror.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSet>
+#include <QThread>
+
+#include <thread>
+#include <vector>
+
+#include "docinfo.h"
+#include "filelinker.h"
+
+namespace
+{
+    // length of the md5 prefix that tells apart documents with the same name
+    const int kPrefixLength = 8;
+
+    bool createLink(const QString & target, const QString & linkPath)
+    {
+#if defined(Q_OS_UNIX)
+        // relative, so the working folder can be moved with its mirror
+        return QFile::link(QFileInfo(linkPath).dir().relativeFilePath(target), linkPath);
+#else
+        // QFile::link makes .lnk shortcuts on Windows, other tools don't follow them
+        return FileLinker::hardLink(target, linkPath);
+#endif
+    }
+}
+
+//=============================================================================
+// class TagMirror
+//=============================================================================
+TagMirror::TagMirror(const QString & mirrorPath, const QString & docsPath)
+    : mirrorPath_(mirrorPath)
+    , docsPath_(docsPath)
+{
+}
+
+QString TagMirror::tagFolder(const QString & tag) const
+{
+    QString name = tag.trimmed();
+    for (QChar & c : name)
+    {
+        if (c == '/' || c == '\\' || c == ':' || c == '*' || c == '?' || c == '"' || c == '<' || c == '>' || c == '|')
+        {
+            c = '_';
+        }
+    }
+    if (name.isEmpty() || name == "." || name == "..")
+    {
+        name.prepend('_');
+    }
+    return QDir(mirrorPath_).filePath(name);
+}
+
+QString TagMirror::targetPath(const DocInfo & info) const
+{
+    return QDir(docsPath_).filePath(info.md5 + "/" + info.fileName);
+}
+
+bool TagMirror::pointsTo(const QString & linkPath, const QString & target) const
+{
+    const QFileInfo link(linkPath);
+    if (link.isSymLink())
+    {
+        return link.symLinkTarget() == QFileInfo(target).absoluteFilePath();
+    }
+    // a hard link is the stored document itself, a copy with the same size and
+    // time stamps is not
+    return link.exists() && FileLinker::isSameFile(linkPath, target);
+}
+
+bool TagMirror::addLink(const QString & tag, const DocInfo & info) const
+{
+    const QDir folder(tagFolder(tag));
+    if (!folder.exists() && !QDir().mkpath(folder.path()))
+    {
+        return false;
+    }
+    const QString target = targetPath(info);
+    const QString names[] = { info.fileName, info.md5.left(kPrefixLength) + "-" + info.fileName };
+    for (const QString & name : names)
+    {
+        const QString linkPath = folder.filePath(name);
+        if (QFileInfo(linkPath).exists() || QFileInfo(linkPath).isSymLink())
+        {
+            if (pointsTo(linkPath, target))
+            {
+                return true;
+            }
+            continue;
+        }
+        if (createLink(target, linkPath))
+        {
+            return true;
+        }
+        // another worker may have taken the name just now
+        if (!QFileInfo(linkPath).isSymLink() && !QFileInfo(linkPath).exists())
+        {
+            return false;
+        }
+    }
+    return false;
+}
+
+void TagMirror::removeLink(const QString & tag, const DocInfo & info) const
+{
+    const QDir folder(tagFolder(tag));
+    const QString target = targetPath(info);
+    const QString names[] = { info.fileName, info.md5.left(kPrefixLength) + "-" + info.fileName };
+    for (const QString & name : names)
+    {
+        const QString linkPath = folder.filePath(name);
+        if (pointsTo(linkPath, target))
+        {
+            QFile::remove(linkPath);
+            break;
+        }
+    }
+    // an empty tag folder means the tag is gone
+    QDir().rmdir(folder.path());
+}
+
+bool TagMirror::needsRebuild() const
+{
+    return isEnabled() && !QDir(mirrorPath_).exists();
+}
+
+void TagMirror::update(const DocInfo * before, const DocInfo * after) const
+{
+    if (!isEnabled())
+    {
+        return;
+    }
+    const QSet<QString> oldTags = before ? before->tags.toSet() : QSet<QString>();
+    const QSet<QString> newTags = after ? after->tags.toSet() : QSet<QString>();
+    // a renamed document needs all its links replaced
+    const bool moved = before && after && (before->md5 != after->md5 || before->fileName != after->fileName);
+    for (const QString & tag : oldTags)
+    {
+        if (moved || !newTags.contains(tag))
+        {
+            removeLink(tag, *before);
+        }
+    }
+    for (const QString & tag : newTags)
+    {
+        if (moved || !oldTags.contains(tag))
+        {
+            addLink(tag, *after);
+        }
+    }
+}
+
+bool TagMirror::rebuild(const QList<DocInfo> & docs, const std::atomic<bool> * cancelled, std::atomic<qint64> * done) const
+{
+    if (!isEnabled())
+    {
+        return true;
+    }
+    QDir(mirrorPath_).removeRecursively();
+    if (!QDir().mkpath(mirrorPath_))
+    {
+        return false;
+    }
+    // folders first, so workers never race to create the same one
+    QSet<QString> tags;
+    for (const DocInfo & info : docs)
+    {
+        for (const QString & tag : info.tags)
+        {
+            tags.insert(tag);
+        }
+    }
+    for (const QString & tag : tags)
+    {
+        QDir().mkpath(tagFolder(tag));
+    }
+
+    // links don't depend on each other, workers take documents in turn
+    const int threads = qMax(1, QThread::idealThreadCount());
+    std::atomic<int> next(0);
+    std::atomic<bool> failed(false);
+    std::vector<std::thread> workers;
+    for (int worker = 0; worker < threads; ++worker)
+    {
+        workers.emplace_back([&]()
+        {
+            for (int i = next++; i < docs.size(); i = next++)
+            {
+                if (cancelled && *cancelled)
+                {
+                    return;
+                }
+                for (const QString & tag : docs[i].tags)
+                {
+                    if (!addLink(tag, docs[i]))
+                    {
+                        failed = true;
+                    }
+                }
+                if (done)
+                {
+                    ++*done;
+                }
+            }
+        });
+    }
+    for (std::thread & worker : workers)
+    {
+        worker.join();
+    }
+    if (cancelled && *cancelled)
+    {
+        // a missing folder makes the next login start over
+        QDir(mirrorPath_).removeRecursively();
+    }
+    return !failed;
+}
@@ -0,0 +1,49 @@
+#ifndef TAG_MIRROR_H
+#define TAG_MIRROR_H
+
+#include <QStringList>
+
+#include <atomic>
+
+struct DocInfo;
+
+// Folder tree "by-tag/<tag>/<fileName>" of links into "docs/<md5>/", lets other tools
+// browse the catalog by tag. Symbolic links are used where the platform has them
+// without privileges, hard links otherwise. Two documents with the same name under
+// one tag are told apart by a short md5 prefix on the second one.
+class TagMirror
+{
+private:
+    QString mirrorPath_;
+    QString docsPath_;
+private:
+    // tags may contain characters that are not allowed in a folder name
+    QString tagFolder(const QString & tag) const;
+    //
+    QString targetPath(const DocInfo & info) const;
+    // true if the link at linkPath leads to the stored document
+    bool pointsTo(const QString & linkPath, const QString & target) const;
+    //
+    bool addLink(const QString & tag, const DocInfo & info) const;
+    //
+    void removeLink(const QString & tag, const DocInfo & info) const;
+public:
+    // an empty mirror path turns the mirror off
+    TagMirror(const QString & mirrorPath, const QString & docsPath);
+    //
+    bool isEnabled() const { return !mirrorPath_.isEmpty(); }
+    // true if there's nothing to update incrementally yet
+    bool needsRebuild() const;
+    // touch only the tags that differ, before is null for a new document and after
+    // is null for a deleted one
+    void update(const DocInfo * before, const DocInfo * after) const;
+    //
+    void add(const DocInfo & info) const { update(nullptr, &info); }
+    //
+    void remove(const DocInfo & info) const { update(&info, nullptr); }
+    // drop the tree and link every document again on all cores, done counts linked
+    // documents, returns false if something could not be linked
+    bool rebuild(const QList<DocInfo> & docs, const std::atomic<bool> * cancelled, std::atomic<qint64> * done) const;
+};
+
+#endif // TAG_MIRROR_H
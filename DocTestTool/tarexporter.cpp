@@ -0,0 +1,441 @@
+#include "tarexporter.h"
+
+#ifdef HAVE_ZSTD
+
+#include <QDateTime>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QThread>
+
+#include <cstring>
+#include <zstd.h>
+
+#include "docinfo.h"
+
+namespace
+{
+    // stream bytes per zstd frame, big enough for many small documents to share one
+    // and small enough that a reader seeking a document decompresses little extra
+    const qint64 kBlockSize = 4 * 1024 * 1024;
+    // blocks per worker that may wait in memory for the writer
+    const size_t kBlocksPerWorker = 2;
+    const int kLevel = ZSTD_CLEVEL_DEFAULT;
+    // tar works in records of this size, headers take one and data is padded to it
+    const int kRecordSize = 512;
+    const int kNameSize = 100;
+    const int kIndexVersion = 1;
+    const double kMegabyte = 1024.0 * 1024.0;
+
+    // zero terminated octal number, base-256 when it doesn't fit like GNU tar does
+    void writeNumber(char * field, int width, qint64 value)
+    {
+        const int digits = width - 1;
+        if (value < (qint64(1) << (3 * digits)))
+        {
+            qsnprintf(field, width, "%0*llo", digits, static_cast<unsigned long long>(value));
+            return;
+        }
+        for (int i = width - 1; i > 0; --i)
+        {
+            field[i] = static_cast<char>(value & 0xFF);
+            value >>= 8;
+        }
+        field[0] = static_cast<char>(0x80);
+    }
+
+    QByteArray ustarHeader(const QByteArray & name, qint64 size, qint64 modified, char type)
+    {
+        QByteArray header(kRecordSize, '\0');
+        char * data = header.data();
+        memcpy(data, name.constData(), qMin(name.size(), kNameSize));
+        writeNumber(data + 100, 8, 0644);
+        writeNumber(data + 108, 8, 0);
+        writeNumber(data + 116, 8, 0);
+        writeNumber(data + 124, 12, size);
+        writeNumber(data + 136, 12, modified);
+        data[156] = type;
+        memcpy(data + 257, "ustar", 6);
+        memcpy(data + 263, "00", 2);
+        // the checksum is summed while its own field holds spaces
+        memset(data + 148, ' ', 8);
+        unsigned int checksum = 0;
+        for (int i = 0; i < kRecordSize; ++i)
+        {
+            checksum += static_cast<unsigned char>(data[i]);
+        }
+        qsnprintf(data + 148, 8, "%06o", checksum);
+        return header;
+    }
+
+    // zeros that fill the last record of a document
+    QByteArray padding(qint64 size)
+    {
+        return QByteArray(static_cast<int>((kRecordSize - size % kRecordSize) % kRecordSize), '\0');
+    }
+
+    // ustar header, preceded by a GNU long name record if the name doesn't fit, which
+    // GNU tar, bsdtar and 7-Zip all understand
+    QByteArray tarHeader(const QString & name, qint64 size, qint64 modified)
+    {
+        QByteArray path = name.toUtf8();
+        QByteArray header;
+        if (path.size() > kNameSize)
+        {
+            QByteArray longName = path;
+            longName.append('\0');
+            header.append(ustarHeader("././@LongLink", longName.size(), 0, 'L'));
+            header.append(longName).append(padding(longName.size()));
+            path.truncate(kNameSize);
+        }
+        header.append(ustarHeader(path, size, modified, '0'));
+        return header;
+    }
+}
+
+//=============================================================================
+// class TarExporter
+//=============================================================================
+TarExporter::TarExporter(const QString & archivePath, bool singleFolder)
+    : file_(archivePath)
+    , device_(&file_)
+    , indexPath_(archivePath + ".idx")
+    , delimiter_(singleFolder ? "-" : "/")
+    , cancelled_(nullptr)
+    , entryIndex_(0)
+    , filesCount_(0)
+    , bytesCount_(0)
+    , archiveSize_(0)
+    , broken_(false)
+    , rawOffset_(0)
+    , unclaimed_(0)
+    , window_(0)
+    , stopping_(false)
+{
+}
+
+TarExporter::TarExporter(QIODevice * device, bool singleFolder)
+    : device_(device)
+    , delimiter_(singleFolder ? "-" : "/")
+    , cancelled_(nullptr)
+    , entryIndex_(0)
+    , filesCount_(0)
+    , bytesCount_(0)
+    , archiveSize_(0)
+    , broken_(false)
+    , rawOffset_(0)
+    , unclaimed_(0)
+    , window_(0)
+    , stopping_(false)
+{
+}
+
+TarExporter::~TarExporter()
+{
+    stopWorkers();
+}
+
+void TarExporter::addFailure(const QString & path, const QString & reason)
+{
+    failures_.append(QString("%1: %2").arg(path, reason));
+}
+
+bool TarExporter::open()
+{
+    timer_.start();
+    if (device_ == &file_ && !file_.open(QIODevice::WriteOnly))
+    {
+        return false;
+    }
+    pending_ = std::make_shared<Block>(0);
+    const size_t threads = qMax(1, QThread::idealThreadCount());
+    window_ = threads * kBlocksPerWorker;
+    stopping_ = false;
+    for (size_t i = 0; i < threads; ++i)
+    {
+        workers_.emplace_back(&TarExporter::runWorker, this);
+    }
+    return true;
+}
+
+void TarExporter::runWorker()
+{
+    // a context per worker keeps its tables between blocks
+    std::unique_ptr<ZSTD_CCtx, size_t (*)(ZSTD_CCtx *)> context(ZSTD_createCCtx(), &ZSTD_freeCCtx);
+    ZSTD_CCtx_setParameter(context.get(), ZSTD_c_compressionLevel, kLevel);
+    ZSTD_CCtx_setParameter(context.get(), ZSTD_c_checksumFlag, 1);
+    for (;;)
+    {
+        std::shared_ptr<Block> block;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            blockQueued_.wait(lock, [this]() { return stopping_ || unclaimed_ < blocks_.size(); });
+            if (unclaimed_ == blocks_.size())
+            {
+                return;
+            }
+            block = blocks_[unclaimed_++];
+        }
+        compressBlock(*block, context.get());
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            block->done = true;
+        }
+        blockDone_.notify_all();
+    }
+}
+
+void TarExporter::compressBlock(Block & block, ZSTD_CCtx_s * context) const
+{
+    if (isCancelled())
+    {
+        return;
+    }
+    QByteArray raw;
+    raw.reserve(static_cast<int>(block.rawSize));
+    for (const Piece & piece : block.pieces)
+    {
+        if (piece.filePath.isEmpty())
+        {
+            raw.append(piece.bytes);
+            continue;
+        }
+        QFile file(piece.filePath);
+        QByteArray data;
+        if (file.open(QIODevice::ReadOnly) && file.seek(piece.offset))
+        {
+            data = file.read(piece.size);
+        }
+        if (data.size() != piece.size)
+        {
+            // the header already promised this size, zeros keep the rest of the tar readable
+            block.errors.append(QString("%1: file changed while exporting").arg(piece.filePath));
+            data.append(QByteArray(static_cast<int>(piece.size - data.size()), '\0'));
+        }
+        raw.append(data);
+    }
+    block.frame.resize(static_cast<int>(ZSTD_compressBound(raw.size())));
+    const size_t written = ZSTD_compress2(context, block.frame.data(), block.frame.size(), raw.constData(), raw.size());
+    if (ZSTD_isError(written))
+    {
+        block.errors.append(QString("zstd error: %1").arg(ZSTD_getErrorName(written)));
+        block.frame.clear();
+        return;
+    }
+    block.frame.resize(static_cast<int>(written));
+}
+
+void TarExporter::writeBlock(Block & block)
+{
+    failures_.append(block.errors);
+    if (isCancelled() || broken_)
+    {
+        return;
+    }
+    if (block.frame.isEmpty() || device_->write(block.frame) != block.frame.size())
+    {
+        // later frames would be read as the wrong part of the tar
+        broken_ = true;
+        failures_.append(QString("archive can't be written: %1").arg(device_->errorString()));
+        return;
+    }
+    QJsonObject frame;
+    frame["offset"] = double(archiveSize_);
+    frame["size"] = block.frame.size();
+    frame["rawOffset"] = double(block.rawOffset);
+    frame["rawSize"] = double(block.rawSize);
+    frames_.append(frame);
+    archiveSize_ += block.frame.size();
+    for (const Piece & piece : block.pieces)
+    {
+        if (!piece.filePath.isEmpty())
+        {
+            bytesCount_ += piece.size;
+            if (piece.last)
+            {
+                ++filesCount_;
+            }
+        }
+    }
+}
+
+void TarExporter::writeBlocks(size_t limit)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;)
+    {
+        while (!blocks_.empty() && blocks_.front()->done)
+        {
+            std::shared_ptr<Block> block = blocks_.front();
+            blocks_.pop_front();
+            --unclaimed_;
+            lock.unlock();
+            writeBlock(*block);
+            lock.lock();
+        }
+        if (blocks_.size() < limit || blocks_.empty())
+        {
+            return;
+        }
+        blockDone_.wait(lock);
+    }
+}
+
+void TarExporter::appendBytes(const QByteArray & bytes)
+{
+    Piece piece;
+    piece.bytes = bytes;
+    piece.offset = 0;
+    piece.size = bytes.size();
+    piece.last = false;
+    pending_->pieces.push_back(piece);
+    pending_->rawSize += piece.size;
+    rawOffset_ += piece.size;
+    if (pending_->rawSize >= kBlockSize)
+    {
+        queueBlock();
+    }
+}
+
+void TarExporter::appendFile(const QString & filePath, qint64 size)
+{
+    qint64 offset = 0;
+    do
+    {
+        Piece piece;
+        piece.filePath = filePath;
+        piece.offset = offset;
+        piece.size = qMin(kBlockSize - pending_->rawSize, size - offset);
+        piece.last = offset + piece.size == size;
+        pending_->pieces.push_back(piece);
+        pending_->rawSize += piece.size;
+        rawOffset_ += piece.size;
+        offset += piece.size;
+        if (pending_->rawSize >= kBlockSize)
+        {
+            queueBlock();
+        }
+    }
+    while (offset < size);
+}
+
+void TarExporter::queueBlock()
+{
+    if (pending_->pieces.empty())
+    {
+        return;
+    }
+    writeBlocks(window_);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        blocks_.push_back(pending_);
+    }
+    blockQueued_.notify_one();
+    pending_ = std::make_shared<Block>(rawOffset_);
+}
+
+bool TarExporter::writeIndex()
+{
+    QJsonObject index;
+    index["version"] = kIndexVersion;
+    index["blockSize"] = double(kBlockSize);
+    index["frames"] = frames_;
+    index["entries"] = entries_;
+    QSaveFile file(indexPath_);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        return false;
+    }
+    file.write(QJsonDocument(index).toJson(QJsonDocument::Compact));
+    return file.commit();
+}
+
+void TarExporter::stopWorkers()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    blockQueued_.notify_all();
+    for (std::thread & worker : workers_)
+    {
+        worker.join();
+    }
+    workers_.clear();
+}
+
+bool TarExporter::addDocument(const DocInfo & info)
+{
+    if (isCancelled())
+    {
+        return false;
+    }
+    const QFileInfo fileInfo(info.filePath);
+    if (!fileInfo.isFile() || !fileInfo.isReadable())
+    {
+        addFailure(info.filePath, "file can't be read");
+        return false;
+    }
+    const QString name = QString::number(++entryIndex_).append(delimiter_).append(info.fileName);
+    const qint64 size = fileInfo.size();
+    appendBytes(tarHeader(name, size, fileInfo.lastModified().toMSecsSinceEpoch() / 1000));
+
+    QJsonObject entry;
+    entry["name"] = name;
+    entry["md5"] = info.md5;
+    entry["offset"] = double(rawOffset_);
+    entry["size"] = double(size);
+    entries_.append(entry);
+
+    appendFile(info.filePath, size);
+    const QByteArray tail = padding(size);
+    if (!tail.isEmpty())
+    {
+        appendBytes(tail);
+    }
+    return true;
+}
+
+bool TarExporter::close()
+{
+    if (!isCancelled())
+    {
+        // two empty records end the archive
+        appendBytes(QByteArray(2 * kRecordSize, '\0'));
+        queueBlock();
+    }
+    writeBlocks(1);
+    stopWorkers();
+    if (device_ == &file_)
+    {
+        file_.close();
+    }
+    if (broken_ || isCancelled())
+    {
+        return false;
+    }
+    return indexPath_.isEmpty() || writeIndex();
+}
+
+double TarExporter::megabytesPerSecond() const
+{
+    const qint64 ms = timer_.isValid() ? timer_.elapsed() : 0;
+    return ms > 0 ? bytesCount_ / kMegabyte * 1000.0 / ms : 0.0;
+}
+
+QString TarExporter::statsMessage() const
+{
+    QString message = QString("Exported %1 files (%2 MB) into %3 MB of tar.zst: %4 MB/s")
+        .arg(filesCount_.load())
+        .arg(bytesCount_ / kMegabyte, 0, 'f', 1)
+        .arg(archiveSize_ / kMegabyte, 0, 'f', 1)
+        .arg(megabytesPerSecond(), 0, 'f', 1);
+    if (!failures_.isEmpty())
+    {
+        message.append(QString(", %1 failed").arg(failures_.size()));
+    }
+    return message;
+}
+
+#endif // HAVE_ZSTD
@@ -0,0 +1,135 @@
+#ifndef TAR_EXPORTER_H
+#define TAR_EXPORTER_H
+
+#ifdef HAVE_ZSTD
+
+#include <QStringList>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct DocInfo;
+struct ZSTD_CCtx_s;
+
+// Writes documents as one tar stream compressed with zstd, similar small documents
+// share a block so they compress far better than separate zip entries. The stream is
+// cut into blocks that become independent zstd frames, workers compress them in
+// parallel and any tool that reads .tar.zst reads the result. Next to the archive an
+// "<archive>.idx" json lists the frames and where every document lies in the tar, a
+// reader decompresses only the frames a document spans.
+class TarExporter
+{
+private:
+    // tar header bytes, or a range of a document that a worker reads
+    struct Piece
+    {
+        QByteArray bytes;
+        QString filePath;
+        qint64 offset;
+        qint64 size;
+        bool last; // ends the document
+    };
+    // piece of the tar stream that is compressed into its own frame
+    struct Block
+    {
+        std::vector<Piece> pieces;
+        qint64 rawOffset; // position in the tar stream
+        qint64 rawSize;
+        QByteArray frame;
+        QStringList errors;
+        bool done;
+
+        explicit Block(qint64 offset) : rawOffset(offset), rawSize(0), done(false) {}
+    };
+private:
+    QFile file_;
+    QIODevice * device_; // the archive file or a device given by the caller
+    QString indexPath_; // empty when streaming, there's nothing to put it next to
+    QString delimiter_; // separates the entry number from the file name
+    QElapsedTimer timer_; // measures the whole export
+    const std::atomic<bool> * cancelled_; // set from another thread to stop the export
+    int entryIndex_; // number given to the last entry
+    // counters are read by the GUI thread while the export runs
+    std::atomic<qint64> filesCount_;
+    std::atomic<qint64> bytesCount_;
+    std::atomic<qint64> archiveSize_; // compressed bytes written
+    bool broken_; // a frame is missing, the archive can't be read to the end
+    QStringList failures_; // documents that could not be exported, with the reason
+    QJsonArray frames_; // index records of written frames
+    QJsonArray entries_; // index records of added documents
+    std::shared_ptr<Block> pending_; // block being filled
+    qint64 rawOffset_; // tar stream size so far
+    // blocks in archive order, workers take them from the front part, the writer
+    // removes finished ones from the front
+    std::deque<std::shared_ptr<Block>> blocks_;
+    size_t unclaimed_; // position of the first block no worker has taken yet
+    size_t window_; // limit of blocks held in memory
+    bool stopping_;
+    std::mutex mutex_;
+    std::condition_variable blockQueued_;
+    std::condition_variable blockDone_;
+    std::vector<std::thread> workers_;
+private:
+    //
+    bool isCancelled() const { return cancelled_ && *cancelled_; }
+    //
+    void addFailure(const QString & path, const QString & reason);
+    // worker thread loop
+    void runWorker();
+    // read the pieces and compress them into a frame, runs on a worker thread
+    void compressBlock(Block & block, ZSTD_CCtx_s * context) const;
+    // append the frame to the archive, runs on the caller's thread
+    void writeBlock(Block & block);
+    // write finished blocks in order until fewer than limit remain queued
+    void writeBlocks(size_t limit);
+    // add header or padding bytes to the pending block
+    void appendBytes(const QByteArray & bytes);
+    // add the document to the pending blocks, cut where a block is full
+    void appendFile(const QString & filePath, qint64 size);
+    // hand the pending block to the workers
+    void queueBlock();
+    //
+    bool writeIndex();
+    //
+    void stopWorkers();
+public:
+    //
+    TarExporter(const QString & archivePath, bool singleFolder);
+    // write to an open device, the caller closes it and no index is written
+    TarExporter(QIODevice * device, bool singleFolder);
+    //
+    ~TarExporter();
+    // the export stops at the next block once the flag is raised
+    void setCancelFlag(const std::atomic<bool> * cancelled) { cancelled_ = cancelled; }
+    // create the archive, start compression workers and start measuring
+    bool open();
+    // queue the document as a numbered entry, blocks that are already compressed get
+    // written meanwhile, blocks while too many wait to be written
+    bool addDocument(const DocInfo & info);
+    // write the remaining blocks, the end of the tar and the index
+    bool close();
+    //
+    qint64 filesCount() const { return filesCount_; }
+    //
+    qint64 bytesCount() const { return bytesCount_; }
+    //
+    qint64 archiveSize() const { return archiveSize_; }
+    //
+    const QStringList & failures() const { return failures_; }
+    //
+    double megabytesPerSecond() const;
+    // human readable throughput report
+    QString statsMessage() const;
+};
+
+#endif // HAVE_ZSTD
+
+#endif // TAR_EXPORTER_H
@@ -0,0 +1,69 @@
+#include "tarexportjob.h"
+
+#ifdef HAVE_ZSTD
+
+#include <QFile>
+#include <QFileInfo>
+
+//=============================================================================
+// class TarExportJob
+//=============================================================================
+TarExportJob::TarExportJob(const QList<DocInfo> & docs, const QString & archivePath, bool singleFolder)
+    : docs_(docs)
+    , archivePath_(archivePath)
+    , exporter_(archivePath, singleFolder)
+    , closed_(false)
+    , bytesTotal_(0)
+{
+    exporter_.setCancelFlag(&cancelled_);
+
+    for (const DocInfo & info : docs_)
+    {
+        bytesTotal_ += QFileInfo(info.filePath).size();
+    }
+}
+
+TarExportJob::~TarExportJob()
+{
+    wait();
+}
+
+void TarExportJob::run()
+{
+    if (!exporter_.open())
+    {
+        failures_.append(QString("%1: can't create the archive").arg(archivePath_));
+        return;
+    }
+    for (const DocInfo & info : docs_)
+    {
+        if (isCancelled())
+        {
+            break;
+        }
+        exporter_.addDocument(info);
+    }
+    closed_ = exporter_.close();
+    failures_ = exporter_.failures();
+    if (isCancelled() && QFileInfo(archivePath_).isFile())
+    {
+        // half an archive is worse than none, pipes are left alone
+        QFile::remove(archivePath_);
+    }
+    else if (!closed_)
+    {
+        failures_.append(QString("%1: archive or its index could not be completed").arg(archivePath_));
+    }
+}
+
+QString TarExportJob::finish(SaveData * /*save*/)
+{
+    QString message = exporter_.statsMessage();
+    if (isCancelled())
+    {
+        message.prepend("Export cancelled, partial archive removed. ");
+    }
+    return message;
+}
+
+#endif // HAVE_ZSTD
@@ -0,0 +1,45 @@
+#ifndef TAR_EXPORT_JOB_H
+#define TAR_EXPORT_JOB_H
+
+#ifdef HAVE_ZSTD
+
+#include "backgroundjob.h"
+#include "docinfo.h"
+#include "tarexporter.h"
+
+// Exports search results as a .tar.zst with its frame index instead of a zip.
+class TarExportJob : public BackgroundJob
+{
+private:
+    QList<DocInfo> docs_; // search results to export
+    QString archivePath_;
+    TarExporter exporter_;
+    bool closed_; // end of the tar and the index written
+    qint64 bytesTotal_;
+protected:
+    //
+    virtual void run() override;
+public:
+    //
+    TarExportJob(const QList<DocInfo> & docs, const QString & archivePath, bool singleFolder);
+    //
+    virtual ~TarExportJob();
+    //
+    virtual Type type() const override { return Type::Export; }
+    //
+    virtual QString title() const override { return "Tar export"; }
+    //
+    virtual qint64 filesDone() const override { return exporter_.filesCount(); }
+    //
+    virtual qint64 filesTotal() const override { return docs_.size(); }
+    //
+    virtual qint64 bytesDone() const override { return exporter_.bytesCount(); }
+    //
+    virtual qint64 bytesTotal() const override { return bytesTotal_; }
+    //
+    virtual QString finish(SaveData * save) override;
+};
+
+#endif // HAVE_ZSTD
+
+#endif // TAR_EXPORT_JOB_H
@@ -0,0 +1,73 @@
+#include "uploadjob.h"
+
+#include <QFileInfo>
+
+//=============================================================================
+// class UploadJob
+//=============================================================================
+UploadJob::UploadJob(const SaveData & save, const QList<DocInfo> & docs)
+    : save_(save)
+    , docs_(docs)
+    , importer_(&save_)
+    , filesTotal_(0)
+    , bytesTotal_(0)
+{
+    save_.jobs.clear();
+    save_.folderDocsData.clear();
+    importer_.setCancelFlag(&cancelled_);
+
+    // totals are only known when every entry is a plain file
+    for (const DocInfo & info : docs_)
+    {
+        if (info.isFolder || info.isArchive)
+        {
+            filesTotal_ = 0;
+            bytesTotal_ = 0;
+            break;
+        }
+        ++filesTotal_;
+        bytesTotal_ += QFileInfo(info.filePath).size();
+    }
+}
+
+UploadJob::~UploadJob()
+{
+    wait();
+}
+
+void UploadJob::run()
+{
+    importer_.start();
+    for (const DocInfo & info : docs_)
+    {
+        if (isCancelled())
+        {
+            break;
+        }
+        if (info.isFolder)
+        {
+            importer_.importFolder(info);
+        }
+        else if (info.isArchive)
+        {
+            importer_.importArchive(info);
+        }
+        else
+        {
+            importer_.importFile(info);
+        }
+    }
+    importer_.finish();
+    failures_ = importer_.failures();
+}
+
+QString UploadJob::finish(SaveData * save)
+{
+    save->loadFilesData();
+    QString message = importer_.statsMessage();
+    if (isCancelled())
+    {
+        message.prepend("Upload cancelled. ");
+    }
+    return message;
+}
@@ -0,0 +1,41 @@
+#ifndef UPLOAD_JOB_H
+#define UPLOAD_JOB_H
+
+#include "backgroundjob.h"
+#include "docimporter.h"
+#include "docinfo.h"
+#include "savedata.h"
+
+class UploadJob : public BackgroundJob
+{
+private:
+    SaveData save_; // snapshot of settings, the GUI may edit the original meanwhile
+    QList<DocInfo> docs_; // files, folders and archives to import
+    DocImporter importer_;
+    qint64 filesTotal_;
+    qint64 bytesTotal_;
+protected:
+    //
+    virtual void run() override;
+public:
+    //
+    UploadJob(const SaveData & save, const QList<DocInfo> & docs);
+    //
+    virtual ~UploadJob();
+    //
+    virtual Type type() const override { return Type::Upload; }
+    //
+    virtual QString title() const override { return "Upload"; }
+    //
+    virtual qint64 filesDone() const override { return importer_.filesCount(); }
+    //
+    virtual qint64 filesTotal() const override { return filesTotal_; }
+    //
+    virtual qint64 bytesDone() const override { return importer_.bytesCount(); }
+    //
+    virtual qint64 bytesTotal() const override { return bytesTotal_; }
+    //
+    virtual QString finish(SaveData * save) override;
+};
+
+#endif // UPLOAD_JOB_H
@@ -2,13 +2,10 @@
 
 #include <QFileDialog>
 #include <QDesktopServices>
-#include <QJsonDocument>
-#include <QJsonArray>
-#include <QJsonObject>
-#include <QCryptographicHash>
 
 #include "constants.h"
 #include "docinfo.h"
+#include "uploadjob.h"
 #include "savedata.h"
 
 //=============================================================================
@@ -55,12 +52,7 @@ bool UploadScreen::init()
 
     loadDocs(fileNames);
 
-    for (DocInfo & info : loadedDocsData_)
-    {
-        QListWidgetItem * newItem = new QListWidgetItem;
-        newItem->setText(info.fileName);
-        ui_->docsListWidget->addItem(newItem);
-    }
+    showDocs();
 
     if (!fileNames.empty())
     {
@@ -91,6 +83,13 @@ void UploadScreen::loadDocs(QStringList & fileNames)
             DocInfo docInfo;
             docInfo.filePath = fileName;
             docInfo.fileName = info.fileName();
+
+            // path rules are applied right away, content rules run during upload
+            const TagMatcher & matcher = save_->tagMatcher;
+            TagMatcher::Scan scan = matcher.begin();
+            matcher.feed(scan, fileName, TagRule::Path);
+            matcher.apply(scan, docInfo.tags);
+
             loadedDocsData_.append(docInfo);
         }
     }
@@ -132,6 +131,16 @@ void UploadScreen::processUserEvent(Screen::UserEvent event)
             addToDocs();
         }
         break;
+        case Screen::UserEvent::AddFolderClicked:
+        {
+            addFolderToDocs();
+        }
+        break;
+        case Screen::UserEvent::AddArchiveClicked:
+        {
+            addArchivesToDocs();
+        }
+        break;
         case Screen::UserEvent::ClearBtnClicked:
         {
             clearWidgets(ClearMode::ClearInputText);
@@ -192,11 +201,73 @@ void UploadScreen::addToDocs()
 
     loadDocs(fileNames);
 
+    showDocs();
+}
+
+void UploadScreen::addFolderToDocs()
+{
+    const QString folderPath = QFileDialog::getExistingDirectory(parent_, "Select folder to import");
+    if (folderPath.isEmpty())
+    {
+        return;
+    }
+
+    for (const DocInfo & info : loadedDocsData_)
+    {
+        if (info.filePath == folderPath)
+        {
+            return;
+        }
+    }
+
+    DocInfo docInfo;
+    docInfo.filePath = folderPath;
+    docInfo.fileName = QDir(folderPath).dirName().append("/");
+    docInfo.isFolder = true;
+    loadedDocsData_.append(docInfo);
+
+    showDocs();
+}
+
+void UploadScreen::addArchivesToDocs()
+{
+    const QStringList fileNames = QFileDialog::getOpenFileNames(parent_, "Select one or more archives to import", QString(), Constants::kArchiveFilters);
+    for (const QString & fileName : fileNames)
+    {
+        bool duplicate = false;
+        for (const DocInfo & info : loadedDocsData_)
+        {
+            if (info.filePath == fileName)
+            {
+                duplicate = true;
+                break;
+            }
+        }
+
+        if (!duplicate)
+        {
+            DocInfo docInfo;
+            docInfo.filePath = fileName;
+            docInfo.fileName = QFileInfo(fileName).fileName().append("/");
+            docInfo.isArchive = true;
+            loadedDocsData_.append(docInfo);
+        }
+    }
+
+    showDocs();
+}
+
+void UploadScreen::showDocs()
+{
     clearWidgets(ClearMode::ClearDocsList);
     for (DocInfo & info : loadedDocsData_)
     {
         QListWidgetItem * newItem = new QListWidgetItem;
         newItem->setText(info.fileName);
+        if (!info.tags.isEmpty())
+        {
+            newItem->setTextColor("blue");
+        }
         ui_->docsListWidget->addItem(newItem);
     }
 }
@@ -327,14 +398,16 @@ void UploadScreen::finishUpload()
     for (int i = 0, iEnd = loadedDocsData_.size(); i < iEnd; ++i)
     {
         DocInfo & info = loadedDocsData_[i];
-        if (info.tags.empty())
+        // archives may bring their own tags in the manifest
+        if (info.tags.empty() && !info.isArchive)
         {
             missingTagIndex = i;
             break;
         }
     }
-    // if tag is missing than set color to red and scroll to this item
-    if (missingTagIndex >= 0)
+    // if tag is missing than set color to red and scroll to this item,
+    // with tag rules configured untagged documents may still get tags from their content
+    if (missingTagIndex >= 0 && save_->tagMatcher.isEmpty())
     {
         QListWidgetItem * item = ui_->docsListWidget->item(missingTagIndex);
         item->setTextColor("red");
@@ -345,61 +418,20 @@ void UploadScreen::finishUpload()
         return;
     }
 
-    ui_->progressBar->setVisible(true);
-    ui_->progressBar->setValue(0);
-    ui_->progressBar->setMaximum(loadedDocsData_.size());
-    for (DocInfo & info : loadedDocsData_)
+    for (BackgroundJob * job : save_->jobs)
     {
-        QFile file(info.filePath);
-        QFileInfo fileInfo(file);
-
-        QString md5;
-        if (file.open(QFile::ReadOnly))
-        {
-            QCryptographicHash hash(QCryptographicHash::Md5);
-            if (hash.addData(&file))
-            {
-                md5 = hash.result().toHex();
-            }
-            file.close();
-        }
-
-        if (md5.isEmpty())
+        if (job->type() == BackgroundJob::Type::Upload)
         {
+            ui_->statusBar->setStyleSheet("color: red");
+            ui_->statusBar->showMessage("Upload is already running!", 2000);
             return;
         }
-
-        QString folderPath(save_->getDocsFilePath());
-        folderPath.append("/").append(md5);
-        if (!QDir(folderPath).exists())
-        {
-            QDir().mkdir(folderPath);
-            const QString filepath = QDir(folderPath).filePath(info.fileName);
-            file.copy(filepath);
-
-            const QString infoPath = QDir(folderPath).filePath(Constants::kInfoDocFile);
-            QFile infoFile(infoPath);
-            const QString val = "{}";
-            QJsonDocument jsonDoc = QJsonDocument::fromJson(val.toUtf8());
-            QJsonObject obj = jsonDoc.object();
-            obj[Constants::kComment] = info.comment;
-            obj[Constants::kFilename] = info.fileName;
-            obj[Constants::kTags] = QJsonArray::fromStringList(info.tags);
-            jsonDoc.setObject(obj);
-
-            QByteArray json = jsonDoc.toJson(QJsonDocument::Indented);
-
-            if (infoFile.open(QIODevice::WriteOnly))
-            {
-                infoFile.write(json);
-                infoFile.close();
-            }
-        }
-        ui_->progressBar->setValue(ui_->progressBar->value() + 1);
     }
-    save_->loadFilesData();
-    ui_->progressBar->setValue(ui_->progressBar->maximum());
-    ui_->progressBar->setVisible(true);
+
+    // the main window reports progress and reloads the catalog when the job is done
+    UploadJob * job = new UploadJob(*save_, loadedDocsData_);
+    save_->jobs.append(job);
+    job->start();
 
     ui_->backBtn->click();
 }
\ No newline at end of file
@@ -23,6 +23,12 @@ private:
     void openSelectedDoc();
     //
     void addToDocs();
+    // add a folder entry, its files are enumerated only when upload starts
+    void addFolderToDocs();
+    // add zip archive entries, documents are read from the archives during upload
+    void addArchivesToDocs();
+    //
+    void showDocs();
     //
     void deleteFromDocs();
     //